@@ -0,0 +1,742 @@
+#!/usr/bin/env python3
+"""
+Reference SMAA implementation that writes the conformance goldens in this directory, read by the
+SMAA.Conformance.CPU and SMAA.Conformance.GPU automation tests.
+
+It is transcribed independently from the shaders (SMAA_UE5.usf, SMAAReference.usf, SMAA_EdgeDetection.usf and
+SMAA_T2XResolve.usf) rather than from the CPU port, so the goldens catch the port and the GPU passes drifting from
+the original algorithm, not just from their own earlier output. Standard library only:
+
+    python3 SMAAReference.py [OutputDir]
+
+Inputs are quantised to multiples of 1/256, so every edge detection comparison is exact in float32 and the edges
+don't depend on the precision of whoever runs them.
+
+The area texture is an input here, not something this script reproduces, so the blend weight goldens store the
+area lookups rather than the weights: for each pixel, the texel coordinates the shader samples the area texture at
+and the corner factors applied afterwards. The tests sample the shipped texture at those coordinates, which checks
+every search, crossing edge, corner and diagonal decision exactly while leaving the table itself out.
+
+Neighbourhood blending and the resolve take synthetic weights (<Scene>_Frame<N>_Weights) so they're tested
+independently of the weights pass.
+
+Files, all 32 bit float RGBA EXRs:
+    <Scene>_Frame<N>_{Colour,Depth,Normal,Velocity,Weights}  Inputs, where a case reads them. Frame 0 is the
+                                                            previous frame
+    <Case>_Edges                                            Edge detection output
+    <Case>_AreaH, <Case>_AreaV                              (X, Y, factor X, factor Y), X < 0 without an edge
+    <Case>_AreaDiag                                         (X1, Y1, X2, Y2) of both diagonals, negative when not
+                                                            found. High and Ultra only
+    <Scene>_Blended                                         Neighbourhood blending, no reprojection
+    <Scene>_T2x_History, _T2x_Blended, _T2x_Resolved        Frames 0 and 1 blended with reprojection, and resolved
+"""
+
+import math
+import os
+import struct
+import sys
+import zlib
+
+WIDTH = 64
+HEIGHT = 48
+
+# FSMAACPUSettings defaults
+ADAPTATION_FACTOR = 2.0
+REPROJECTION_WEIGHT = 25.0
+TEMPORAL_HISTORY_BIAS = 0.4
+
+# Must match the presets in SMAAReference.usf: threshold, search steps, diagonal steps (0 disables diagonal and
+# corner detection), corner rounding
+PRESETS = {
+    "Low": (0.15, 4, 0, 0),
+    "Medium": (0.1, 8, 0, 0),
+    "High": (0.1, 16, 8, 25),
+    "Ultra": (0.05, 32, 16, 25),
+}
+
+AREATEX_MAX_DISTANCE = 16
+AREATEX_MAX_DISTANCE_DIAG = 20
+AREATEX_SUBTEX_HEIGHT = 80
+AREATEX_DIAG_X = 80
+
+# (Scene, edge detector, preset, T2x). T2x cases run on the current frame with its subsample indices
+EDGE_CASES = [
+    ("Shapes", "Luminance", "Low", False),
+    ("Shapes", "Luminance", "Ultra", False),
+    ("Shapes", "Colour", "Low", False),
+    ("Shapes", "Colour", "Ultra", False),
+    ("Shapes", "Depth", "Low", False),
+    ("Shapes", "Depth", "Ultra", False),
+    ("Shapes", "Normal", "Low", False),
+    ("Shapes", "Normal", "Ultra", False),
+    ("Shapes", "Luminance", "Ultra", True),
+    ("Lines", "Luminance", "Low", False),
+    ("Lines", "Luminance", "Medium", False),
+    ("Lines", "Luminance", "High", False),
+    ("Lines", "Luminance", "Ultra", False),
+    ("Lines", "Luminance", "Ultra", True),
+    ("Noise", "Colour", "High", False),
+    ("Contrast", "Luminance", "Low", False),
+    ("Contrast", "Luminance", "Ultra", False),
+    ("Contrast", "Colour", "Low", False),
+    ("Contrast", "Colour", "Ultra", False),
+    ("Contrast", "Depth", "Low", False),
+    ("Contrast", "Depth", "Ultra", False),
+    ("Contrast", "Normal", "Ultra", False),
+]
+
+SCENES = ["Shapes", "Lines", "Noise", "Contrast"]
+
+# Scenes with motion, which also get the T2x blending and resolve goldens
+TEMPORAL_SCENES = ["Shapes", "Lines"]
+
+# Inputs each scene's cases read, for frames 0 and 1
+SCENE_INPUTS = {
+    "Shapes": (("Colour", "Depth", "Velocity", "Weights"), ("Colour", "Depth", "Normal", "Velocity", "Weights")),
+    "Lines": (("Colour", "Depth", "Velocity", "Weights"), ("Colour", "Depth", "Velocity", "Weights")),
+    "Noise": ((), ("Colour", "Weights")),
+    "Contrast": ((), ("Colour", "Depth", "Normal", "Weights")),
+}
+
+# Subsample indices of the current and previous frame with T2x, see SubpixelJitterWeights
+T2X_SUBSAMPLE_INDICES = (1, 1, 1, 0)
+
+# Smallest distance allowed between a value and a threshold it's compared against
+MARGIN = 1e-5
+
+
+class MarginError(Exception):
+    pass
+
+
+def check_margin(a, b, what):
+    if a != b and abs(a - b) < MARGIN:
+        raise MarginError("%s: %r and %r are too close to compare reliably, adjust the scene" % (what, a, b))
+
+
+def step(edge, x):
+    return 1.0 if x >= edge else 0.0
+
+
+def saturate(x):
+    return min(max(x, 0.0), 1.0)
+
+
+def hlsl_round(x):
+    # Every value rounded here is away from .5, which the margin checks below rely on
+    return float(math.floor(x + 0.5))
+
+
+def f32(x):
+    return struct.unpack("<f", struct.pack("<f", x))[0]
+
+
+def quantise(x):
+    return round(x * 256.0) / 256.0
+
+
+###### ###### ###### ###### ######
+# Images, with texture sampling. Coordinates are in pixels, texel centres at +0.5, clamped addressing
+#
+
+class Image:
+    def __init__(self, width=WIDTH, height=HEIGHT, fill=(0.0, 0.0, 0.0, 0.0)):
+        self.width = width
+        self.height = height
+        self.pixels = [tuple(fill)] * (width * height)
+
+    def at(self, x, y):
+        x = min(max(x, 0), self.width - 1)
+        y = min(max(y, 0), self.height - 1)
+        return self.pixels[y * self.width + x]
+
+    def set(self, x, y, value):
+        self.pixels[y * self.width + x] = tuple(f32(v) for v in value)
+
+    def point(self, x, y):
+        return self.at(int(math.floor(x)), int(math.floor(y)))
+
+    def bilinear(self, x, y):
+        x -= 0.5
+        y -= 0.5
+        x0 = int(math.floor(x))
+        y0 = int(math.floor(y))
+        fx = x - x0
+        fy = y - y0
+        a, b = self.at(x0, y0), self.at(x0 + 1, y0)
+        c, d = self.at(x0, y0 + 1), self.at(x0 + 1, y0 + 1)
+        return tuple((a[i] * (1 - fx) + b[i] * fx) * (1 - fy) + (c[i] * (1 - fx) + d[i] * fx) * fy for i in range(4))
+
+
+def write_exr(path, image):
+    """Uncompressed scanline OpenEXR, 32 bit float A, B, G, R channels"""
+
+    def attribute(name, type_name, value):
+        return name.encode() + b"\0" + type_name.encode() + b"\0" + struct.pack("<i", len(value)) + value
+
+    channels = b"".join(name + b"\0" + struct.pack("<iB3xii", 2, 0, 1, 1) for name in (b"A", b"B", b"G", b"R")) + b"\0"
+    window = struct.pack("<iiii", 0, 0, image.width - 1, image.height - 1)
+
+    header = b"\x76\x2f\x31\x01" + struct.pack("<i", 2)
+    header += attribute("channels", "chlist", channels)
+    header += attribute("compression", "compression", b"\0")
+    header += attribute("dataWindow", "box2i", window)
+    header += attribute("displayWindow", "box2i", window)
+    header += attribute("lineOrder", "lineOrder", b"\0")
+    header += attribute("pixelAspectRatio", "float", struct.pack("<f", 1.0))
+    header += attribute("screenWindowCenter", "v2f", struct.pack("<ff", 0.0, 0.0))
+    header += attribute("screenWindowWidth", "float", struct.pack("<f", 1.0))
+    header += b"\0"
+
+    line_size = image.width * 4 * 4
+    chunk_size = 8 + line_size
+    first_chunk = len(header) + 8 * image.height
+    offsets = b"".join(struct.pack("<Q", first_chunk + y * chunk_size) for y in range(image.height))
+
+    chunks = []
+    for y in range(image.height):
+        row = image.pixels[y * image.width:(y + 1) * image.width]
+        data = b"".join(struct.pack("<%df" % image.width, *(p[channel] for p in row)) for channel in (3, 2, 1, 0))
+        chunks.append(struct.pack("<ii", y, line_size) + data)
+
+    with open(path, "wb") as file:
+        file.write(header + offsets + b"".join(chunks))
+
+
+###### ###### ###### ###### ######
+# Scenes
+#
+
+def hash_2d(x, y):
+    value = ((x * 0x8da6b343) ^ (y * 0xd8163841)) & 0xffffffff
+    value ^= value >> 15
+    value = (value * 0x2c1b3c6d) & 0xffffffff
+    value ^= value >> 12
+    return value
+
+
+def velocity_to_pixels(velocity):
+    """Screen space velocity (+Y up), as a pixel shift per frame"""
+    return (velocity[0] * WIDTH * 0.5, -velocity[1] * HEIGHT * 0.5)
+
+
+def make_scene(scene, frame_index):
+    """Colour, depth (inverted, 1 = near), normal and velocity of one frame. Frame 0 is the previous one"""
+    colour, depth, normal, velocity = Image(), Image(), Image(), Image()
+    time = float(frame_index - 1)
+
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            px, py = x + 0.5, y + 0.5
+
+            c = (0.05 + 0.002 * x, 0.05, 0.08)
+            d = 0.01
+            n = (0.0, 1.0, 0.0)
+            v = (0.0, 0.0)
+
+            if scene == "Shapes":
+                rect_velocity = (0.04, 0.0)
+                shift = velocity_to_pixels(rect_velocity)
+                rx, ry = px - time * shift[0], py - time * shift[1]
+                if 6.0 <= rx < 30.0 and 5.0 <= ry < 22.0:
+                    c, d, n, v = (0.8, 0.3, 0.2), 0.5, (0.0, 0.0, 1.0), rect_velocity
+
+                if py > 0.6 * px + 20.0 and px < 40.0:
+                    c, d, n, v = (0.2, 0.7, 0.3), 0.3, (0.7071, 0.0, 0.7071), (0.0, 0.0)
+
+                circle_velocity = (-0.03, 0.04)
+                shift = velocity_to_pixels(circle_velocity)
+                ox, oy = px - time * shift[0] - 46.0, py - time * shift[1] - 30.0
+                if ox * ox + oy * oy < 144.0:
+                    nz = math.sqrt(max(0.0, 1.0 - (ox * ox + oy * oy) / 144.0))
+                    c, d, n, v = (0.9, 0.9, 0.85), 0.7, (ox / 12.0, -oy / 12.0, nz), circle_velocity
+
+            elif scene == "Lines":
+                # Horizontal, vertical, and slopes of 1, 1/2 and 1/3, moving right by a pixel per frame
+                lx = x - frame_index
+                if y == 4 or lx == 3 or lx == y + 8 or lx == y * 2 + 20 or y == lx // 3 + 20 or y == lx // 2 + 10:
+                    c, d, n, v = (1.0, 1.0, 1.0), 0.5, (0.0, 0.0, 1.0), (2.0 / WIDTH, 0.0)
+
+            elif scene == "Contrast":
+                # Steps between the Low and Ultra thresholds, each seen by some edge detectors only: grey for colour
+                # (luma sees four times the step), equal luma for colour alone, green for luma alone, and a green
+                # slope for the diagonal search. Depth and normals step between the thresholds on the first, past
+                # both on the second. The slope is tilted too, so the normal and colour detectors disagree
+                c, d = (0.4, 0.4, 0.4), 0.0117
+                if 4.0 <= px < 20.0 and 4.0 <= py < 20.0:
+                    c, d, n = (0.5, 0.5, 0.5), 0.0195, (0.0, 0.9, 0.1)
+                elif 24.0 <= px < 40.0 and 4.0 <= py < 20.0:
+                    c, d, n = (0.48, 0.4, 0.32), 0.04, (0.3, 0.7, 0.0)
+                elif 44.0 <= px < 60.0 and 4.0 <= py < 20.0:
+                    c = (0.4, 0.43, 0.4)
+                elif py > 0.5 * px + 26.0:
+                    c, n = (0.4, 0.44, 0.4), (0.0, 0.75, 0.25)
+
+            else:
+                # Low contrast noise with a few hard steps, for local contrast adaptation
+                noise = (hash_2d(x, y) & 0xffff) / 65535.0
+                c = (0.4 + 0.08 * noise, 0.4 + 0.05 * noise, 0.4)
+                if (x // 16 + y // 12) % 2 == 0:
+                    c = (c[0] + 0.3, c[1] + 0.3, c[2] + 0.3)
+
+            colour.set(x, y, tuple(quantise(value) for value in c) + (1.0,))
+            depth.set(x, y, (quantise(d), 0.0, 0.0, 0.0))
+            normal.set(x, y, tuple(quantise(value) for value in n) + (0.0,))
+            velocity.set(x, y, (v[0], v[1], 0.0, 0.0))
+
+    return {"Colour": colour, "Depth": depth, "Normal": normal, "Velocity": velocity}
+
+
+def make_weights(scene, frame_index):
+    """Synthetic blend weights: about a third of the pixels blend, in steps of 1/32 below a half"""
+    salt = {"Shapes": 1, "Lines": 2, "Noise": 3, "Contrast": 4}[scene] * 4 + frame_index
+    weights = Image()
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            value = hash_2d(x + 97 * salt, y + 61 * salt)
+            if value % 3 != 0:
+                continue
+            value //= 3
+            weights.set(x, y, tuple(((value >> (4 * i)) & 15) / 32.0 for i in range(4)))
+    return weights
+
+
+###### ###### ###### ###### ######
+# Edge detection, SMAA_EdgeDetection.usf
+#
+
+def luma(c):
+    return c[1] * 2.0 + (c[0] + c[2])
+
+
+def colour_delta(a, b):
+    return max(abs(a[0] - b[0]), abs(a[1] - b[1]), abs(a[2] - b[2]))
+
+
+def detect_edges(frame, mode, threshold):
+    edges = Image()
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            if mode == "Depth":
+                depth = frame["Depth"]
+                p = depth.at(x, y)[0]
+                delta = (abs(p - depth.at(x - 1, y)[0]), abs(p - depth.at(x, y - 1)[0]))
+                depth_threshold = 0.1 * threshold
+                for value in delta:
+                    check_margin(value, depth_threshold, "Depth delta")
+                e = (step(depth_threshold, delta[0]), step(depth_threshold, delta[1]))
+            else:
+                # Normals go through the colour detector
+                source = frame["Normal"] if mode == "Normal" else frame["Colour"]
+                e = detect_colour_edges(source, x, y, mode == "Luminance", threshold)
+
+            edges.set(x, y, (e[0], e[1], 1.0, 1.0))
+    return edges
+
+
+def detect_colour_edges(source, x, y, use_luma, threshold):
+    def tap(dx, dy):
+        return source.at(x + dx, y + dy)
+
+    if use_luma:
+        l, left, top = luma(tap(0, 0)), luma(tap(-1, 0)), luma(tap(0, -1))
+        delta = [abs(l - left), abs(l - top)]
+    else:
+        delta = [colour_delta(tap(0, 0), tap(-1, 0)), colour_delta(tap(0, 0), tap(0, -1))]
+
+    for value in delta:
+        check_margin(value, threshold, "Edge delta")
+    edges = [step(threshold, delta[0]), step(threshold, delta[1])]
+    if edges[0] + edges[1] == 0.0:
+        return (0.0, 0.0)
+
+    if use_luma:
+        right, bottom = luma(tap(1, 0)), luma(tap(0, 1))
+        max_delta = [max(delta[0], abs(l - right)), max(delta[1], abs(l - bottom))]
+
+        # The luma detector compares left with left-left, the colour detector the centre
+        left_left, top_top = luma(tap(-2, 0)), luma(tap(0, -2))
+        max_delta = [max(max_delta[0], abs(left - left_left)), max(max_delta[1], abs(top - top_top))]
+    else:
+        max_delta = [max(delta[0], colour_delta(tap(0, 0), tap(1, 0))), max(delta[1], colour_delta(tap(0, 0), tap(0, 1)))]
+        max_delta = [max(max_delta[0], colour_delta(tap(0, 0), tap(-2, 0))), max(max_delta[1], colour_delta(tap(0, 0), tap(0, -2)))]
+
+    final_delta = max(max_delta)
+
+    # Local contrast adaptation. Inputs are multiples of 1/256 so this is exact, ties included
+    return (edges[0] * step(final_delta, ADAPTATION_FACTOR * delta[0]), edges[1] * step(final_delta, ADAPTATION_FACTOR * delta[1]))
+
+
+###### ###### ###### ###### ######
+# Blending weight calculation, SMAABlendingWeightCalculationCS
+#
+
+def decode_bilinear_edges(value):
+    """Peels the four edges off a @PSEUDO_GATHER4 fetch, weighted 1/32, 3/32, 7/32 and 21/32"""
+    total = hlsl_round(value * 32.0)
+    edges = [0.0] * 4
+    for index, weight in ((3, 21.0), (2, 7.0), (1, 3.0)):
+        edges[index] = step(weight, total)
+        total -= weight * edges[index]
+    edges[0] = saturate(total)
+    return edges
+
+
+def search_length(e, offset):
+    left = decode_bilinear_edges(e[0])
+    top = decode_bilinear_edges(e[1])
+    if offset == 0.0:
+        first = top[3]
+        second = first * top[2] * (1.0 - left[1]) * (1.0 - left[3])
+    else:
+        first = top[3] * (1.0 - left[1]) * (1.0 - left[3])
+        second = first * top[2] * (1.0 - left[0]) * (1.0 - left[2])
+    return (127.0 / 255.0) * (first + second)
+
+
+class BlendContext:
+    def __init__(self, edges, preset):
+        self.edges = edges
+        _, self.max_search_steps, self.max_diag_steps, corner_rounding = PRESETS[preset]
+        self.diagonals = self.max_diag_steps > 0
+        self.corners = self.max_diag_steps > 0
+        self.rounding = corner_rounding / 100.0
+
+    def e(self, x, y):
+        sample = self.edges.bilinear(x, y)
+        return (sample[0], sample[1])
+
+    def search_x_left(self, x, y, end):
+        e = (0.0, 1.0)
+        while x > end and e[1] > 0.8281 and e[0] == 0.0:
+            e = self.e(x, y)
+            x -= 2.0
+        return x - (255.0 / 127.0) * search_length(e, 0.0) + 3.25
+
+    def search_x_right(self, x, y, end):
+        e = (0.0, 1.0)
+        while x < end and e[1] > 0.8281 and e[0] == 0.0:
+            e = self.e(x, y)
+            x += 2.0
+        return x - (3.25 - (255.0 / 127.0) * search_length(e, 0.5))
+
+    def search_y_up(self, x, y, end):
+        e = (1.0, 0.0)
+        while y > end and e[0] > 0.8281 and e[1] == 0.0:
+            e = self.e(x, y)
+            y -= 2.0
+        return y - (255.0 / 127.0) * search_length((e[1], e[0]), 0.0) + 3.25
+
+    def search_y_down(self, x, y, end):
+        e = (1.0, 0.0)
+        while y < end and e[0] > 0.8281 and e[1] == 0.0:
+            e = self.e(x, y)
+            y += 2.0
+        return y - (3.25 - (255.0 / 127.0) * search_length((e[1], e[0]), 0.5))
+
+    def search_diag(self, x, y, direction, decode):
+        # SearchDiag1, or SearchDiag2 which fetches both edges at once with bilinear filtering
+        if decode:
+            x += 0.25
+        steps, w = -1.0, 1.0
+        e = (0.0, 0.0)
+        while steps < self.max_diag_steps - 1 and w > 0.9:
+            x += direction[0]
+            y += direction[1]
+            steps += 1.0
+            e = self.e(x, y)
+            if decode:
+                e = decode_diag(e)
+            w = (e[0] + e[1]) * 0.5
+        return steps, w, e
+
+    def diag_lookups(self, tx, ty, e, subsample):
+        """Area texel coordinates of both diagonals, None where the shader doesn't sample"""
+        first = second = None
+
+        if e[0] > 0.0:
+            dx, dz, end = self.search_diag(tx, ty, (-1.0, 1.0), False)
+            dx += 1.0 if end[1] > 0.9 else 0.0
+        else:
+            dx, dz = 0.0, 0.0
+        dy, dw, end = self.search_diag(tx, ty, (1.0, -1.0), False)
+
+        if dx + dy > 2.0:
+            c_xy = self.e(tx - dx + 0.25 - 1.0, ty + dx)
+            c_zw = self.e(tx + dy + 1.0, ty - dy - 0.25)
+            left, right = decode_diag(c_xy), decode_diag(c_zw)
+            # c.yxwz = decode(c.xyzw)
+            c = (left[1], left[0], right[1], right[0])
+            cc = [2.0 * c[0] + c[1], 2.0 * c[2] + c[3]]
+            if dz >= 0.9:
+                cc[0] = 0.0
+            if dw >= 0.9:
+                cc[1] = 0.0
+            first = (AREATEX_MAX_DISTANCE_DIAG * cc[0] + dx + AREATEX_DIAG_X,
+                     AREATEX_MAX_DISTANCE_DIAG * cc[1] + dy + AREATEX_SUBTEX_HEIGHT * subsample[2])
+
+        dx, dz, end = self.search_diag(tx, ty, (-1.0, -1.0), True)
+        if self.e(tx + 1.0, ty)[0] > 0.0:
+            dy, dw, end = self.search_diag(tx, ty, (1.0, 1.0), True)
+            dy += 1.0 if end[1] > 0.9 else 0.0
+        else:
+            dy, dw = 0.0, 0.0
+
+        if dx + dy > 2.0:
+            c = (self.e(tx - dx - 1.0, ty - dx)[1], self.e(tx - dx, ty - dx - 1.0)[0])
+            c_zw = self.e(tx + dy + 1.0, ty + dy)
+            c = c + (c_zw[1], c_zw[0])
+            cc = [2.0 * c[0] + c[1], 2.0 * c[2] + c[3]]
+            if dz >= 0.9:
+                cc[0] = 0.0
+            if dw >= 0.9:
+                cc[1] = 0.0
+            second = (AREATEX_MAX_DISTANCE_DIAG * cc[0] + dx + AREATEX_DIAG_X,
+                      AREATEX_MAX_DISTANCE_DIAG * cc[1] + dy + AREATEX_SUBTEX_HEIGHT * subsample[3])
+
+        return first, second
+
+    def area_coords(self, d, e1, e2, offset):
+        for value in (4.0 * e1, 4.0 * e2):
+            check_margin(value - math.floor(value), 0.5, "Crossing edge rounding")
+        return (AREATEX_MAX_DISTANCE * hlsl_round(4.0 * e1) + math.sqrt(d[0]),
+                AREATEX_MAX_DISTANCE * hlsl_round(4.0 * e2) + math.sqrt(d[1]) + AREATEX_SUBTEX_HEIGHT * offset)
+
+    def corner_rounding(self, d):
+        """How much each side's corner reduces the weights, halved for pixels in the centre of a line"""
+        left_right = (step(d[0], d[1]), step(d[1], d[0]))
+        total = left_right[0] + left_right[1]
+        return tuple((1.0 - self.rounding) * value / total for value in left_right)
+
+    def horizontal(self, tx, ty, subsample):
+        # offset[0], offset[1] and offset[2] of the shader, in pixels
+        end_left = tx - 0.25 - 2.0 * self.max_search_steps
+        end_right = tx + 1.25 + 2.0 * self.max_search_steps
+
+        cx = self.search_x_left(tx - 0.25, ty - 0.125, end_left)
+        cy = ty - 0.25
+        e1 = self.e(cx, cy)[0]
+        cz = self.search_x_right(tx + 1.25, ty - 0.125, end_right)
+
+        pixcoord = tx
+        d = (abs(round_checked(cx - pixcoord)), abs(round_checked(cz - pixcoord)))
+        e2 = self.e(cz + 1.0, cy)[0]
+        coords = self.area_coords(d, e1, e2, subsample[1])
+
+        factor = (1.0, 1.0)
+        if self.corners:
+            rounding = self.corner_rounding(d)
+            fx = 1.0 - rounding[0] * self.e(cx, ty + 1.0)[0] - rounding[1] * self.e(cz + 1.0, ty + 1.0)[0]
+            fy = 1.0 - rounding[0] * self.e(cx, ty - 2.0)[0] - rounding[1] * self.e(cz + 1.0, ty - 2.0)[0]
+            factor = (saturate(fx), saturate(fy))
+        return coords + factor
+
+    def vertical(self, tx, ty, subsample):
+        end_up = ty - 0.25 - 2.0 * self.max_search_steps
+        end_down = ty + 1.25 + 2.0 * self.max_search_steps
+
+        cy = self.search_y_up(tx - 0.125, ty - 0.25, end_up)
+        cx = tx - 0.25
+        e1 = self.e(cx, cy)[1]
+        cz = self.search_y_down(tx - 0.125, ty + 1.25, end_down)
+
+        pixcoord = ty
+        d = (abs(round_checked(cy - pixcoord)), abs(round_checked(cz - pixcoord)))
+        e2 = self.e(cx, cz + 1.0)[1]
+        coords = self.area_coords(d, e1, e2, subsample[0])
+
+        factor = (1.0, 1.0)
+        if self.corners:
+            rounding = self.corner_rounding(d)
+            fx = 1.0 - rounding[0] * self.e(tx + 1.0, cy)[1] - rounding[1] * self.e(tx + 1.0, cz + 1.0)[1]
+            fy = 1.0 - rounding[0] * self.e(tx - 2.0, cy)[1] - rounding[1] * self.e(tx - 2.0, cz + 1.0)[1]
+            factor = (saturate(fx), saturate(fy))
+        return coords + factor
+
+
+def decode_diag(e):
+    r = e[0] * abs(5.0 * e[0] - 5.0 * 0.75)
+    check_margin(r - math.floor(r), 0.5, "Diagonal decode")
+    check_margin(e[1] - math.floor(e[1]), 0.5, "Diagonal decode")
+    return (hlsl_round(r), hlsl_round(e[1]))
+
+
+def round_checked(value):
+    check_margin(value - math.floor(value), 0.5, "Search distance rounding")
+    return hlsl_round(value)
+
+
+def blending_lookups(edges, preset, subsample):
+    context = BlendContext(edges, preset)
+    area_h, area_v = Image(fill=(-1.0, -1.0, 0.0, 0.0)), Image(fill=(-1.0, -1.0, 0.0, 0.0))
+    area_diag = Image(fill=(-1.0, -1.0, -1.0, -1.0)) if context.diagonals else None
+
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            tx, ty = x + 0.5, y + 0.5
+            e = edges.at(x, y)
+
+            # Every edge gets its orthogonal lookup, even where a diagonal takes priority, so the tests check the
+            # searches on both sides of that decision
+            if e[1] > 0.0:
+                area_h.set(x, y, context.horizontal(tx, ty, subsample))
+                if context.diagonals:
+                    first, second = context.diag_lookups(tx, ty, e, subsample)
+                    area_diag.set(x, y, (first or (-1.0, -1.0)) + (second or (-1.0, -1.0)))
+            if e[0] > 0.0:
+                area_v.set(x, y, context.vertical(tx, ty, subsample))
+
+    return area_h, area_v, area_diag
+
+
+###### ###### ###### ###### ######
+# Neighbourhood blending and resolve, SMAANeighborhoodBlendingCS and SMAAResolveCS
+#
+
+AA_CROSS = 2
+
+
+def velocity_taa(frame, x, y):
+    """GetVelocityTAA, on velocity that's already decoded. Samples are point sampled at integer offsets"""
+    depth_image, velocity_image = frame["Depth"], frame["Velocity"]
+    depth = depth_image.point(x, y)[0]
+    depths = [depth_image.point(x + ox, y + oy)[0] for ox, oy in ((-AA_CROSS, -AA_CROSS), (AA_CROSS, -AA_CROSS), (-AA_CROSS, AA_CROSS), (AA_CROSS, AA_CROSS))]
+
+    offset = [0.0, 0.0]
+    depth_offset = [float(AA_CROSS), float(AA_CROSS)]
+    depth_offset_xx = float(AA_CROSS)
+    if depths[0] > depths[1]:
+        depth_offset_xx = -AA_CROSS
+    if depths[2] > depths[3]:
+        depth_offset[0] = -AA_CROSS
+    depths_xy = max(depths[0], depths[1])
+    depths_zw = max(depths[2], depths[3])
+    if depths_xy > depths_zw:
+        depth_offset[1] = -AA_CROSS
+        depth_offset[0] = depth_offset_xx
+    if max(depths_xy, depths_zw) > depth:
+        offset = depth_offset
+
+    velocity = velocity_image.point(x + offset[0], y + offset[1])
+    return (velocity[0], velocity[1])
+
+
+def neighbourhood_blending(frame, weights, reprojection):
+    colour = frame["Colour"]
+    output = Image()
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            tx, ty = x + 0.5, y + 0.5
+            a = (weights.bilinear(tx + 1.0, ty)[3], weights.bilinear(tx, ty + 1.0)[1], weights.at(x, y)[2], weights.at(x, y)[0])
+
+            if sum(a) < 1e-5:
+                result = list(colour.bilinear(tx, ty))
+                if reprojection:
+                    velocity = velocity_taa(frame, tx, ty)
+                    result[3] = math.sqrt(5.0 * math.hypot(*velocity))
+            else:
+                h = max(a[0], a[2]) > max(a[1], a[3])
+                offset = (a[0], 0.0, a[2], 0.0) if h else (0.0, a[1], 0.0, a[3])
+                blend = (a[0], a[2]) if h else (a[1], a[3])
+                blend = (blend[0] / (blend[0] + blend[1]), blend[1] / (blend[0] + blend[1]))
+
+                coord_a = (tx + offset[0], ty + offset[1])
+                coord_b = (tx - offset[2], ty - offset[3])
+                sample_a, sample_b = colour.bilinear(*coord_a), colour.bilinear(*coord_b)
+                result = [blend[0] * sample_a[i] + blend[1] * sample_b[i] for i in range(4)]
+
+                if reprojection:
+                    velocity_a, velocity_b = velocity_taa(frame, *coord_a), velocity_taa(frame, *coord_b)
+                    velocity = (velocity_a[0] + velocity_b[0], velocity_a[1] + velocity_b[1])
+                    result[3] = math.sqrt(5.0 * math.hypot(*velocity))
+
+            output.set(x, y, result)
+    return output
+
+
+def resolve(frame, current, previous):
+    output = Image()
+    for y in range(HEIGHT):
+        for x in range(WIDTH):
+            tx, ty = x + 0.5, y + 0.5
+            u, v = tx / WIDTH, ty / HEIGHT
+
+            velocity = velocity_taa(frame, tx, ty)
+            velocity = (-0.5 * velocity[0], 0.5 * velocity[1])
+
+            c = current.at(x, y)
+            limit = (saturate(u + velocity[0]), saturate(v + velocity[1]))
+            p = previous.bilinear(limit[0] * WIDTH, limit[1] * HEIGHT)
+
+            screen = (2.0 * u - 1.0 + velocity[0], 1.0 - 2.0 * v + velocity[1])
+            check_margin(max(abs(screen[0]), abs(screen[1])), 1.0, "Off screen test")
+            off_screen = max(abs(screen[0]), abs(screen[1])) >= 1.0
+
+            delta = abs(c[3] * c[3] - p[3] * p[3]) / 5.0
+            weight = 0.0 if off_screen else TEMPORAL_HISTORY_BIAS * saturate(1.0 - math.sqrt(delta) * REPROJECTION_WEIGHT)
+            output.set(x, y, [c[i] + (p[i] - c[i]) * weight for i in range(4)])
+    return output
+
+
+###### ###### ###### ###### ######
+# Goldens
+#
+
+def main():
+    output_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    written = []
+
+    def save(name, image):
+        path = os.path.join(output_dir, name + ".exr")
+        write_exr(path, image)
+        with open(path, "rb") as file:
+            written.append("%08x  %s" % (zlib.crc32(file.read()), name))
+
+    scenes = {}
+    for scene in SCENES:
+        for frame_index in (0, 1):
+            frame = make_scene(scene, frame_index)
+            frame["Weights"] = make_weights(scene, frame_index)
+            scenes[(scene, frame_index)] = frame
+
+            for name in SCENE_INPUTS[scene][frame_index]:
+                save("%s_Frame%d_%s" % (scene, frame_index, name), frame[name])
+
+    case_edges = {}
+    for scene, mode, preset, temporal in EDGE_CASES:
+        case = "%s_%s_%s%s" % (scene, mode, preset, "_T2x" if temporal else "")
+        subsample = T2X_SUBSAMPLE_INDICES if temporal else (0, 0, 0, 0)
+
+        edges = detect_edges(scenes[(scene, 1)], mode, PRESETS[preset][0])
+        case_edges[case] = edges.pixels
+        area_h, area_v, area_diag = blending_lookups(edges, preset, subsample)
+
+        save(case + "_Edges", edges)
+        save(case + "_AreaH", area_h)
+        save(case + "_AreaV", area_v)
+        if area_diag is not None:
+            save(case + "_AreaDiag", area_diag)
+
+    # The contrast scene is only worth having while the thresholds and detectors disagree on it
+    for a, b in (("Luminance_Low", "Luminance_Ultra"), ("Colour_Low", "Colour_Ultra"), ("Depth_Low", "Depth_Ultra"),
+                 ("Luminance_Low", "Colour_Low"), ("Luminance_Ultra", "Colour_Ultra"), ("Colour_Ultra", "Normal_Ultra")):
+        if case_edges["Contrast_" + a] == case_edges["Contrast_" + b]:
+            raise MarginError("Contrast_%s and Contrast_%s have the same edges, adjust the scene" % (a, b))
+
+    for scene in SCENES:
+        frame = scenes[(scene, 1)]
+        save(scene + "_Blended", neighbourhood_blending(frame, frame["Weights"], False))
+
+    for scene in TEMPORAL_SCENES:
+        previous, current = scenes[(scene, 0)], scenes[(scene, 1)]
+        history = neighbourhood_blending(previous, previous["Weights"], True)
+        blended = neighbourhood_blending(current, current["Weights"], True)
+        save(scene + "_T2x_History", history)
+        save(scene + "_T2x_Blended", blended)
+        save(scene + "_T2x_Resolved", resolve(current, blended, history))
+
+    print("\n".join(written))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,1045 @@
+#include "SMAACPU.h"
+
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+
+#if WITH_EDITORONLY_DATA
+#include "Engine/Texture2D.h"
+#include "ImageCore.h"
+#endif
+
+///// ///// ////////// ///// /////
+// Images and lookup tables
+//
+
+void FSMAACPUImage::Init(int32 InWidth, int32 InHeight)
+{
+	Width = InWidth;
+	Height = InHeight;
+	Pixels.SetNumZeroed(Width * Height);
+}
+
+const FVector4f& FSMAACPUImage::SamplePoint(float X, float Y) const
+{
+	const int32 TexelX = FMath::Clamp(FMath::FloorToInt32(X), 0, Width - 1);
+	const int32 TexelY = FMath::Clamp(FMath::FloorToInt32(Y), 0, Height - 1);
+	return At(TexelX, TexelY);
+}
+
+FVector4f FSMAACPUImage::SampleBilinear(float X, float Y) const
+{
+	const float TexelX = X - 0.5f;
+	const float TexelY = Y - 0.5f;
+	const float FloorX = FMath::FloorToFloat(TexelX);
+	const float FloorY = FMath::FloorToFloat(TexelY);
+	const float FracX = TexelX - FloorX;
+	const float FracY = TexelY - FloorY;
+
+	const int32 X0 = FMath::Clamp(int32(FloorX), 0, Width - 1);
+	const int32 X1 = FMath::Clamp(int32(FloorX) + 1, 0, Width - 1);
+	const int32 Y0 = FMath::Clamp(int32(FloorY), 0, Height - 1);
+	const int32 Y1 = FMath::Clamp(int32(FloorY) + 1, 0, Height - 1);
+
+	const FVector4f Top = FMath::Lerp(At(X0, Y0), At(X1, Y0), FracX);
+	const FVector4f Bottom = FMath::Lerp(At(X0, Y1), At(X1, Y1), FracX);
+	return FMath::Lerp(Top, Bottom, FracY);
+}
+
+bool FSMAALookupTables::InitFromAreaTexels(int32 Width, int32 Height, TArray<FVector2f> Texels)
+{
+	if (Width != AreaTextureWidth || Height != AreaTextureHeight || Texels.Num() != Width * Height)
+	{
+		return false;
+	}
+
+	Area = MoveTemp(Texels);
+	return true;
+}
+
+#if WITH_EDITORONLY_DATA
+bool FSMAALookupTables::InitFromTexture(UTexture2D* AreaTexture)
+{
+	if (!AreaTexture || !AreaTexture->Source.IsValid())
+	{
+		return false;
+	}
+
+	FImage SourceImage;
+	if (!AreaTexture->Source.GetMipImage(SourceImage, 0, 0, 0))
+	{
+		return false;
+	}
+
+	// Sample the data the same way the GPU would see it
+	SourceImage.GammaSpace = AreaTexture->SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+
+	FImage LinearImage;
+	SourceImage.CopyTo(LinearImage, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+
+	const TArrayView64<FLinearColor> Colours = LinearImage.AsRGBA32F();
+
+	TArray<FVector2f> Texels;
+	Texels.SetNumUninitialized(int32(Colours.Num()));
+	for (int32 Index = 0; Index < Texels.Num(); ++Index)
+	{
+		Texels[Index] = FVector2f(Colours[Index].R, Colours[Index].G);
+	}
+
+	return InitFromAreaTexels(LinearImage.SizeX, LinearImage.SizeY, MoveTemp(Texels));
+}
+#endif
+
+FVector2f FSMAALookupTables::SampleArea(float X, float Y) const
+{
+	const float FloorX = FMath::FloorToFloat(X);
+	const float FloorY = FMath::FloorToFloat(Y);
+	const float FracX = X - FloorX;
+	const float FracY = Y - FloorY;
+
+	const int32 X0 = FMath::Clamp(int32(FloorX), 0, AreaTextureWidth - 1);
+	const int32 X1 = FMath::Clamp(int32(FloorX) + 1, 0, AreaTextureWidth - 1);
+	const int32 Y0 = FMath::Clamp(int32(FloorY), 0, AreaTextureHeight - 1);
+	const int32 Y1 = FMath::Clamp(int32(FloorY) + 1, 0, AreaTextureHeight - 1);
+
+	const FVector2f Top = FMath::Lerp(Area[Y0 * AreaTextureWidth + X0], Area[Y0 * AreaTextureWidth + X1], FracX);
+	const FVector2f Bottom = FMath::Lerp(Area[Y1 * AreaTextureWidth + X0], Area[Y1 * AreaTextureWidth + X1], FracX);
+	return FMath::Lerp(Top, Bottom, FracY);
+}
+
+///// ///// ////////// ///// /////
+// Helpers
+//
+
+namespace SMAACPU
+{
+	// Matches SMAA_AREATEX_MAX_DISTANCE, SMAA_AREATEX_MAX_DISTANCE_DIAG and SMAA_AREATEX_SUBTEX_SIZE
+	constexpr float AreaTexMaxDistance = 16.f;
+	constexpr float AreaTexMaxDistanceDiag = 20.f;
+	constexpr float AreaTexSubtexHeight = 80.f;
+
+	// HLSL step()
+	FORCEINLINE float Step(float Edge, float Value)
+	{
+		return Value >= Edge ? 1.f : 0.f;
+	}
+
+	FORCEINLINE float Luma4(const FVector4f& Colour)
+	{
+		return (Colour.Y * 2.f) + (Colour.X + Colour.Z);
+	}
+
+	FORCEINLINE float MaxColourDelta(const FVector4f& A, const FVector4f& B)
+	{
+		return FMath::Max3(FMath::Abs(A.X - B.X), FMath::Abs(A.Y - B.Y), FMath::Abs(A.Z - B.Z));
+	}
+
+	FORCEINLINE FVector2f SampleEdges(const FSMAACPUImage& Edges, float X, float Y)
+	{
+		const FVector4f Sample = Edges.SampleBilinear(X, Y);
+		return FVector2f(Sample.X, Sample.Y);
+	}
+
+	bool IsDiagonalDetectionEnabled(ESMAAPreset Preset)
+	{
+		return Preset != ESMAAPreset::Low && Preset != ESMAAPreset::Medium;
+	}
+
+	bool IsCornerDetectionEnabled(ESMAAPreset Preset)
+	{
+		return Preset != ESMAAPreset::Low && Preset != ESMAAPreset::Medium;
+	}
+
+	// Splits the rows into one block per thread, so NumThreads bounds the parallelism
+	void ParallelForRows(int32 Height, int32 NumThreads, TFunctionRef<void(int32 /*Y*/)> Body)
+	{
+		const int32 NumBlocks = NumThreads > 0 ? FMath::Min(NumThreads, Height) : Height;
+		const int32 RowsPerBlock = FMath::DivideAndRoundUp(Height, FMath::Max(NumBlocks, 1));
+
+		ParallelFor(FMath::DivideAndRoundUp(Height, RowsPerBlock), [&](int32 Block)
+		{
+			const int32 End = FMath::Min(Height, (Block + 1) * RowsPerBlock);
+			for (int32 Y = Block * RowsPerBlock; Y < End; ++Y)
+			{
+				Body(Y);
+			}
+		}, NumThreads == 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+	}
+
+	///// ///// ////////// ///// /////
+	// Search table
+	//
+	// SearchTex holds, for each bilinearly fetched pair of edge values, how far the last search step
+	// really went. Rather than sampling it, decode the fetch back into its four edges and evaluate
+	// the same rules SearchTex.py does.
+
+	// A bilinear fetch at (-0.25, -0.125) returns (e0 + 3 e1 + 7 e2 + 21 e3) / 32 for four binary edges
+	bool DecodeBilinearEdges(float Value, int32 (&OutEdges)[4])
+	{
+		static const int32 Weights[4] = { 1, 3, 7, 21 };
+
+		const int32 Sum = FMath::RoundToInt32(Value * 32.f);
+		for (int32 Mask = 0; Mask < 16; ++Mask)
+		{
+			int32 MaskSum = 0;
+			for (int32 Bit = 0; Bit < 4; ++Bit)
+			{
+				OutEdges[Bit] = (Mask >> Bit) & 1;
+				MaskSum += OutEdges[Bit] * Weights[Bit];
+			}
+
+			if (MaskSum == Sum)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// SMAASearchLength, for offset 0 (left/up) and 0.5 (right/down)
+	float SearchLength(FVector2f E, bool bRightOrDown)
+	{
+		int32 Left[4];
+		int32 Top[4];
+		if (!DecodeBilinearEdges(E.X, Left) || !DecodeBilinearEdges(E.Y, Top))
+		{
+			return 0.f;
+		}
+
+		int32 Delta = 0;
+		if (!bRightOrDown)
+		{
+			if (Top[3] == 1)
+			{
+				Delta++;
+			}
+			if (Delta == 1 && Top[2] == 1 && Left[1] != 1 && Left[3] != 1)
+			{
+				Delta++;
+			}
+		}
+		else
+		{
+			if (Top[3] == 1 && Left[1] != 1 && Left[3] != 1)
+			{
+				Delta++;
+			}
+			if (Delta == 1 && Top[2] == 1 && Left[0] != 1 && Left[2] != 1)
+			{
+				Delta++;
+			}
+		}
+
+		// Stored as 127 * Delta in an 8 bit texture
+		return 127.f * float(Delta) / 255.f;
+	}
+
+	///// ///// ////////// ///// /////
+	// Blending weight helpers, see SMAAReference.usf. All coordinates are in pixels
+	//
+
+	struct FBlendContext
+	{
+		const FSMAACPUSettings& Settings;
+		const FSMAALookupTables& Tables;
+		const FSMAACPUImage& Edges;
+		bool bDiagonals;
+		bool bCorners;
+		float NormalisedCornerRounding;
+	};
+
+	FVector2f DecodeDiagBilinearAccess(FVector2f E)
+	{
+		E.X = E.X * FMath::Abs(5.f * E.X - 5.f * 0.75f);
+		return FVector2f(FMath::RoundHalfToEven(E.X), FMath::RoundHalfToEven(E.Y));
+	}
+
+	FVector2f SearchDiag1(const FBlendContext& Context, FVector2f TexCoord, FVector2f Dir, FVector2f& OutE)
+	{
+		FVector4f Coord(TexCoord.X, TexCoord.Y, -1.f, 1.f);
+		while (Coord.Z < float(Context.Settings.MaxDiagonalSearchSteps - 1) && Coord.W > 0.9f)
+		{
+			Coord.X += Dir.X;
+			Coord.Y += Dir.Y;
+			Coord.Z += 1.f;
+			OutE = SampleEdges(Context.Edges, Coord.X, Coord.Y);
+			Coord.W = FVector2f::DotProduct(OutE, FVector2f(0.5f, 0.5f));
+		}
+		return FVector2f(Coord.Z, Coord.W);
+	}
+
+	FVector2f SearchDiag2(const FBlendContext& Context, FVector2f TexCoord, FVector2f Dir, FVector2f& OutE)
+	{
+		FVector4f Coord(TexCoord.X + 0.25f, TexCoord.Y, -1.f, 1.f);
+		while (Coord.Z < float(Context.Settings.MaxDiagonalSearchSteps - 1) && Coord.W > 0.9f)
+		{
+			Coord.X += Dir.X;
+			Coord.Y += Dir.Y;
+			Coord.Z += 1.f;
+			OutE = DecodeDiagBilinearAccess(SampleEdges(Context.Edges, Coord.X, Coord.Y));
+			Coord.W = FVector2f::DotProduct(OutE, FVector2f(0.5f, 0.5f));
+		}
+		return FVector2f(Coord.Z, Coord.W);
+	}
+
+	FVector2f AreaDiag(const FBlendContext& Context, FVector2f Dist, FVector2f E, float Offset)
+	{
+		// Diagonal areas are on the second half of the texture
+		const float X = AreaTexMaxDistanceDiag * E.X + Dist.X + 0.5f * FSMAALookupTables::AreaTextureWidth;
+		const float Y = AreaTexMaxDistanceDiag * E.Y + Dist.Y + AreaTexSubtexHeight * Offset;
+		return Context.Tables.SampleArea(X, Y);
+	}
+
+	FVector2f CalculateDiagWeights(const FBlendContext& Context, FVector2f TexCoord, FVector2f E, const FVector4f& SubsampleIndices)
+	{
+		FVector2f Weights(0.f, 0.f);
+
+		// Search for the line ends
+		FVector4f D;
+		FVector2f End(0.f, 0.f);
+		if (E.X > 0.f)
+		{
+			const FVector2f Left = SearchDiag1(Context, TexCoord, FVector2f(-1.f, 1.f), End);
+			D.X = Left.X + float(End.Y > 0.9f);
+			D.Z = Left.Y;
+		}
+		else
+		{
+			D.X = 0.f;
+			D.Z = 0.f;
+		}
+		const FVector2f Right = SearchDiag1(Context, TexCoord, FVector2f(1.f, -1.f), End);
+		D.Y = Right.X;
+		D.W = Right.Y;
+
+		if (D.X + D.Y > 2.f)
+		{
+			// Fetch the crossing edges
+			const FVector2f C0 = SampleEdges(Context.Edges, TexCoord.X - D.X + 0.25f - 1.f, TexCoord.Y + D.X);
+			const FVector2f C1 = SampleEdges(Context.Edges, TexCoord.X + D.Y + 1.f, TexCoord.Y - D.Y - 0.25f);
+			const FVector2f Decoded0 = DecodeDiagBilinearAccess(C0);
+			const FVector2f Decoded1 = DecodeDiagBilinearAccess(C1);
+
+			// c.yxwz = decode(c.xyzw), then merge crossing edges at each side into a single value
+			FVector2f CC(2.f * Decoded0.Y + Decoded0.X, 2.f * Decoded1.Y + Decoded1.X);
+
+			// Remove the crossing edge if we didn't found the end of the line
+			if (Step(0.9f, D.Z) != 0.f) { CC.X = 0.f; }
+			if (Step(0.9f, D.W) != 0.f) { CC.Y = 0.f; }
+
+			Weights += AreaDiag(Context, FVector2f(D.X, D.Y), CC, SubsampleIndices.Z);
+		}
+
+		// Search for the line ends
+		const FVector2f UpLeft = SearchDiag2(Context, TexCoord, FVector2f(-1.f, -1.f), End);
+		D.X = UpLeft.X;
+		D.Z = UpLeft.Y;
+		if (Context.Edges.SampleBilinear(TexCoord.X + 1.f, TexCoord.Y).X > 0.f)
+		{
+			const FVector2f DownRight = SearchDiag2(Context, TexCoord, FVector2f(1.f, 1.f), End);
+			D.Y = DownRight.X + float(End.Y > 0.9f);
+			D.W = DownRight.Y;
+		}
+		else
+		{
+			D.Y = 0.f;
+			D.W = 0.f;
+		}
+
+		if (D.X + D.Y > 2.f)
+		{
+			// Fetch the crossing edges
+			const FVector4f Coords(TexCoord.X - D.X, TexCoord.Y - D.X, TexCoord.X + D.Y, TexCoord.Y + D.Y);
+			const float CX = Context.Edges.SampleBilinear(Coords.X - 1.f, Coords.Y).Y;
+			const float CY = Context.Edges.SampleBilinear(Coords.X, Coords.Y - 1.f).X;
+			const FVector2f CZW = SampleEdges(Context.Edges, Coords.Z + 1.f, Coords.W);
+			FVector2f CC(2.f * CX + CY, 2.f * CZW.Y + CZW.X);
+
+			// Remove the crossing edge if we didn't found the end of the line
+			if (Step(0.9f, D.Z) != 0.f) { CC.X = 0.f; }
+			if (Step(0.9f, D.W) != 0.f) { CC.Y = 0.f; }
+
+			const FVector2f Area = AreaDiag(Context, FVector2f(D.X, D.Y), CC, SubsampleIndices.W);
+			Weights += FVector2f(Area.Y, Area.X);
+		}
+
+		return Weights;
+	}
+
+	float SearchXLeft(const FBlendContext& Context, FVector2f TexCoord, float End)
+	{
+		FVector2f E(0.f, 1.f);
+		while (TexCoord.X > End && E.Y > 0.8281f && E.X == 0.f)
+		{
+			E = SampleEdges(Context.Edges, TexCoord.X, TexCoord.Y);
+			TexCoord.X -= 2.f;
+		}
+
+		const float Offset = -(255.f / 127.f) * SearchLength(E, false) + 3.25f;
+		return TexCoord.X + Offset;
+	}
+
+	float SearchXRight(const FBlendContext& Context, FVector2f TexCoord, float End)
+	{
+		FVector2f E(0.f, 1.f);
+		while (TexCoord.X < End && E.Y > 0.8281f && E.X == 0.f)
+		{
+			E = SampleEdges(Context.Edges, TexCoord.X, TexCoord.Y);
+			TexCoord.X += 2.f;
+		}
+
+		const float Offset = -(255.f / 127.f) * SearchLength(E, true) + 3.25f;
+		return TexCoord.X - Offset;
+	}
+
+	float SearchYUp(const FBlendContext& Context, FVector2f TexCoord, float End)
+	{
+		FVector2f E(1.f, 0.f);
+		while (TexCoord.Y > End && E.X > 0.8281f && E.Y == 0.f)
+		{
+			E = SampleEdges(Context.Edges, TexCoord.X, TexCoord.Y);
+			TexCoord.Y -= 2.f;
+		}
+
+		const float Offset = -(255.f / 127.f) * SearchLength(FVector2f(E.Y, E.X), false) + 3.25f;
+		return TexCoord.Y + Offset;
+	}
+
+	float SearchYDown(const FBlendContext& Context, FVector2f TexCoord, float End)
+	{
+		FVector2f E(1.f, 0.f);
+		while (TexCoord.Y < End && E.X > 0.8281f && E.Y == 0.f)
+		{
+			E = SampleEdges(Context.Edges, TexCoord.X, TexCoord.Y);
+			TexCoord.Y += 2.f;
+		}
+
+		const float Offset = -(255.f / 127.f) * SearchLength(FVector2f(E.Y, E.X), true) + 3.25f;
+		return TexCoord.Y - Offset;
+	}
+
+	FVector2f Area(const FBlendContext& Context, FVector2f Dist, float E1, float E2, float Offset)
+	{
+		// Rounding prevents precision errors of bilinear filtering
+		const float X = AreaTexMaxDistance * FMath::RoundHalfToEven(4.f * E1) + Dist.X;
+		const float Y = AreaTexMaxDistance * FMath::RoundHalfToEven(4.f * E2) + Dist.Y + AreaTexSubtexHeight * Offset;
+		return Context.Tables.SampleArea(X, Y);
+	}
+
+	void DetectHorizontalCornerPattern(const FBlendContext& Context, FVector2f& Weights, const FVector4f& TexCoord, FVector2f D)
+	{
+		if (!Context.bCorners)
+		{
+			return;
+		}
+
+		const FVector2f LeftRight(Step(D.X, D.Y), Step(D.Y, D.X));
+		FVector2f Rounding = (1.f - Context.NormalisedCornerRounding) * LeftRight;
+
+		// Reduce blending for pixels in the center of a line
+		Rounding /= LeftRight.X + LeftRight.Y;
+
+		FVector2f Factor(1.f, 1.f);
+		Factor.X -= Rounding.X * Context.Edges.SampleBilinear(TexCoord.X, TexCoord.Y + 1.f).X;
+		Factor.X -= Rounding.Y * Context.Edges.SampleBilinear(TexCoord.Z + 1.f, TexCoord.W + 1.f).X;
+		Factor.Y -= Rounding.X * Context.Edges.SampleBilinear(TexCoord.X, TexCoord.Y - 2.f).X;
+		Factor.Y -= Rounding.Y * Context.Edges.SampleBilinear(TexCoord.Z + 1.f, TexCoord.W - 2.f).X;
+
+		Weights.X *= FMath::Clamp(Factor.X, 0.f, 1.f);
+		Weights.Y *= FMath::Clamp(Factor.Y, 0.f, 1.f);
+	}
+
+	void DetectVerticalCornerPattern(const FBlendContext& Context, FVector2f& Weights, const FVector4f& TexCoord, FVector2f D)
+	{
+		if (!Context.bCorners)
+		{
+			return;
+		}
+
+		const FVector2f LeftRight(Step(D.X, D.Y), Step(D.Y, D.X));
+		FVector2f Rounding = (1.f - Context.NormalisedCornerRounding) * LeftRight;
+
+		Rounding /= LeftRight.X + LeftRight.Y;
+
+		FVector2f Factor(1.f, 1.f);
+		Factor.X -= Rounding.X * Context.Edges.SampleBilinear(TexCoord.X + 1.f, TexCoord.Y).Y;
+		Factor.X -= Rounding.Y * Context.Edges.SampleBilinear(TexCoord.Z + 1.f, TexCoord.W + 1.f).Y;
+		Factor.Y -= Rounding.X * Context.Edges.SampleBilinear(TexCoord.X - 2.f, TexCoord.Y).Y;
+		Factor.Y -= Rounding.Y * Context.Edges.SampleBilinear(TexCoord.Z - 2.f, TexCoord.W + 1.f).Y;
+
+		Weights.X *= FMath::Clamp(Factor.X, 0.f, 1.f);
+		Weights.Y *= FMath::Clamp(Factor.Y, 0.f, 1.f);
+	}
+
+	FVector4f BlendingWeightCalculation(const FBlendContext& Context, int32 PixelX, int32 PixelY)
+	{
+		const FVector2f TexCoord(PixelX + 0.5f, PixelY + 0.5f);
+		const float MaxSearchDistance = 2.f * Context.Settings.MaxSearchSteps;
+
+		// We will use these offsets for the searches later on (see @PSEUDO_GATHER4)
+		const FVector4f Offset0(TexCoord.X - 0.25f, TexCoord.Y - 0.125f, TexCoord.X + 1.25f, TexCoord.Y - 0.125f);
+		const FVector4f Offset1(TexCoord.X - 0.125f, TexCoord.Y - 0.25f, TexCoord.X - 0.125f, TexCoord.Y + 1.25f);
+
+		// And these for the searches, they indicate the ends of the loops
+		const FVector4f Offset2(Offset0.X - MaxSearchDistance, Offset0.Z + MaxSearchDistance, Offset1.Y - MaxSearchDistance, Offset1.W + MaxSearchDistance);
+
+		FVector4f Weights(0.f, 0.f, 0.f, 0.f);
+
+		FVector2f E = SampleEdges(Context.Edges, TexCoord.X, TexCoord.Y);
+
+		if (E.Y > 0.f) // Edge at north
+		{
+			FVector2f DiagWeights(0.f, 0.f);
+			if (Context.bDiagonals)
+			{
+				DiagWeights = CalculateDiagWeights(Context, TexCoord, E, Context.Settings.SubsampleIndices);
+				Weights.X = DiagWeights.X;
+				Weights.Y = DiagWeights.Y;
+			}
+
+			// We give priority to diagonals, so if we find a diagonal we skip horizontal/vertical processing
+			if (DiagWeights.X == -DiagWeights.Y)
+			{
+				FVector2f D;
+
+				// Find the distance to the left
+				FVector4f Coords;
+				Coords.X = SearchXLeft(Context, FVector2f(Offset0.X, Offset0.Y), Offset2.X);
+				Coords.Y = Offset1.Y;
+				D.X = Coords.X;
+
+				// Now fetch the left crossing edges, two at a time using bilinear filtering
+				const float E1 = Context.Edges.SampleBilinear(Coords.X, Coords.Y).X;
+
+				// Find the distance to the right
+				Coords.Z = SearchXRight(Context, FVector2f(Offset0.Z, Offset0.W), Offset2.Y);
+				D.Y = Coords.Z;
+
+				// We want the distances to be in pixel units
+				D.X = FMath::Abs(FMath::RoundHalfToEven(D.X - TexCoord.X));
+				D.Y = FMath::Abs(FMath::RoundHalfToEven(D.Y - TexCoord.X));
+
+				// The areas texture is compressed quadratically
+				const FVector2f SqrtD(FMath::Sqrt(D.X), FMath::Sqrt(D.Y));
+
+				// Fetch the right crossing edges
+				const float E2 = Context.Edges.SampleBilinear(Coords.Z + 1.f, Coords.Y).X;
+
+				FVector2f Area = SMAACPU::Area(Context, SqrtD, E1, E2, Context.Settings.SubsampleIndices.Y);
+
+				// Fix corners
+				DetectHorizontalCornerPattern(Context, Area, FVector4f(Coords.X, TexCoord.Y, Coords.Z, TexCoord.Y), D);
+
+				Weights.X = Area.X;
+				Weights.Y = Area.Y;
+			}
+			else
+			{
+				// Skip vertical processing
+				E.X = 0.f;
+			}
+		}
+
+		if (E.X > 0.f) // Edge at west
+		{
+			FVector2f D;
+
+			// Find the distance to the top
+			FVector4f Coords;
+			Coords.Y = SearchYUp(Context, FVector2f(Offset1.X, Offset1.Y), Offset2.Z);
+			Coords.X = Offset0.X;
+			D.X = Coords.Y;
+
+			// Fetch the top crossing edges
+			const float E1 = Context.Edges.SampleBilinear(Coords.X, Coords.Y).Y;
+
+			// Find the distance to the bottom
+			Coords.Z = SearchYDown(Context, FVector2f(Offset1.Z, Offset1.W), Offset2.W);
+			D.Y = Coords.Z;
+
+			// We want the distances to be in pixel units
+			D.X = FMath::Abs(FMath::RoundHalfToEven(D.X - TexCoord.Y));
+			D.Y = FMath::Abs(FMath::RoundHalfToEven(D.Y - TexCoord.Y));
+
+			const FVector2f SqrtD(FMath::Sqrt(D.X), FMath::Sqrt(D.Y));
+
+			// Fetch the bottom crossing edges
+			const float E2 = Context.Edges.SampleBilinear(Coords.X, Coords.Z + 1.f).Y;
+
+			FVector2f Area = SMAACPU::Area(Context, SqrtD, E1, E2, Context.Settings.SubsampleIndices.X);
+
+			// Fix corners
+			DetectVerticalCornerPattern(Context, Area, FVector4f(TexCoord.X, Coords.Y, TexCoord.X, Coords.Z), D);
+
+			Weights.Z = Area.X;
+			Weights.W = Area.Y;
+		}
+
+		return Weights;
+	}
+
+	///// ///// ////////// ///// /////
+	// Velocity, see GetVelocityTAA in SMAA_UE5.usf
+	//
+
+	constexpr float AACross = 2.f;
+
+	FVector2f GetVelocityTAA(const FSMAACPUFrame& Frame, FVector2f TexCoord)
+	{
+		FVector2f VelocityOffset(0.f, 0.f);
+		float Depth = Frame.Depth.SamplePoint(TexCoord.X, TexCoord.Y).X;
+
+		// Use the motion from the nearest depth in an x pattern around the pixel. Depth is inverted, so nearest is largest
+		const float DepthX = Frame.Depth.SamplePoint(TexCoord.X - AACross, TexCoord.Y - AACross).X;
+		const float DepthY = Frame.Depth.SamplePoint(TexCoord.X + AACross, TexCoord.Y - AACross).X;
+		const float DepthZ = Frame.Depth.SamplePoint(TexCoord.X - AACross, TexCoord.Y + AACross).X;
+		const float DepthW = Frame.Depth.SamplePoint(TexCoord.X + AACross, TexCoord.Y + AACross).X;
+
+		FVector2f DepthOffset(AACross, AACross);
+		float DepthOffsetXx = AACross;
+		if (DepthX > DepthY)
+		{
+			DepthOffsetXx = -AACross;
+		}
+		if (DepthZ > DepthW)
+		{
+			DepthOffset.X = -AACross;
+		}
+		const float DepthsXY = FMath::Max(DepthX, DepthY);
+		const float DepthsZW = FMath::Max(DepthZ, DepthW);
+		if (DepthsXY > DepthsZW)
+		{
+			DepthOffset.Y = -AACross;
+			DepthOffset.X = DepthOffsetXx;
+		}
+		const float DepthsXYZW = FMath::Max(DepthsXY, DepthsZW);
+		if (DepthsXYZW > Depth)
+		{
+			VelocityOffset = DepthOffset;
+			Depth = DepthsXYZW;
+		}
+
+		const FVector4f Velocity = Frame.Velocity.SamplePoint(TexCoord.X + VelocityOffset.X, TexCoord.Y + VelocityOffset.Y);
+		return FVector2f(Velocity.X, Velocity.Y);
+	}
+
+	bool HasReprojection(const FSMAACPUFrame& Frame)
+	{
+		return Frame.Velocity.IsValid() && Frame.Depth.IsValid();
+	}
+}
+
+///// ///// ////////// ///// /////
+// Stages
+//
+
+float GetSMAAPresetThreshold(ESMAAPreset Preset)
+{
+	switch (Preset)
+	{
+	case ESMAAPreset::Low:
+		return 0.15f;
+	case ESMAAPreset::Medium:
+	case ESMAAPreset::High:
+		return 0.1f;
+	case ESMAAPreset::Ultra:
+	case ESMAAPreset::Custom:
+	default:
+		return 0.05f;
+	}
+}
+
+bool SMAACPUSupportsEdgeMode(const FSMAACPUFrame& Frame, ESMAAEdgeDetectors EdgeMode)
+{
+	switch (EdgeMode)
+	{
+	case ESMAAEdgeDetectors::Depth:
+		return Frame.Depth.IsValid();
+	case ESMAAEdgeDetectors::Normal:
+		return Frame.Normal.IsValid();
+	case ESMAAEdgeDetectors::Luminance:
+	case ESMAAEdgeDetectors::Colour:
+		return Frame.Colour.IsValid();
+	default:
+		return false;
+	}
+}
+
+void SMAACPUEdgeDetection(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, FSMAACPUImage& OutEdges)
+{
+	using namespace SMAACPU;
+
+	check(SMAACPUSupportsEdgeMode(Frame, Settings.EdgeMode));
+
+	const int32 Width = Frame.Colour.Width;
+	const int32 Height = Frame.Colour.Height;
+	OutEdges.Init(Width, Height);
+
+	const float Threshold = GetSMAAPresetThreshold(Settings.Quality);
+	const float DepthThreshold = 0.1f * Threshold;
+
+	// Normals go through the colour detector, as on the GPU
+	const FSMAACPUImage& Source = Settings.EdgeMode == ESMAAEdgeDetectors::Normal ? Frame.Normal
+		: Settings.EdgeMode == ESMAAEdgeDetectors::Depth ? Frame.Depth
+		: Frame.Colour;
+
+	ParallelForRows(Height, Settings.NumThreads, [&](int32 Y)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			auto Fetch = [&Source, X, Y](int32 OffsetX, int32 OffsetY) -> const FVector4f&
+			{
+				return Source.At(FMath::Clamp(X + OffsetX, 0, Source.Width - 1), FMath::Clamp(Y + OffsetY, 0, Source.Height - 1));
+			};
+
+			FVector2f Edges(0.f, 0.f);
+
+			if (Settings.EdgeMode == ESMAAEdgeDetectors::Depth)
+			{
+				const float P = Fetch(0, 0).X;
+				const FVector2f Delta(FMath::Abs(P - Fetch(-1, 0).X), FMath::Abs(P - Fetch(0, -1).X));
+				Edges = FVector2f(Step(DepthThreshold, Delta.X), Step(DepthThreshold, Delta.Y));
+			}
+			else if (Settings.EdgeMode == ESMAAEdgeDetectors::Luminance)
+			{
+				const float L = Luma4(Fetch(0, 0));
+				const float LLeft = Luma4(Fetch(-1, 0));
+				const float LTop = Luma4(Fetch(0, -1));
+
+				FVector4f Delta;
+				Delta.X = FMath::Abs(L - LLeft);
+				Delta.Y = FMath::Abs(L - LTop);
+				Edges = FVector2f(Step(Threshold, Delta.X), Step(Threshold, Delta.Y));
+
+				if (Edges.X + Edges.Y != 0.f)
+				{
+					// Calculate right and bottom deltas
+					Delta.Z = FMath::Abs(L - Luma4(Fetch(1, 0)));
+					Delta.W = FMath::Abs(L - Luma4(Fetch(0, 1)));
+
+					FVector2f MaxDelta(FMath::Max(Delta.X, Delta.Z), FMath::Max(Delta.Y, Delta.W));
+
+					// Calculate left-left and top-top deltas
+					Delta.Z = FMath::Abs(LLeft - Luma4(Fetch(-2, 0)));
+					Delta.W = FMath::Abs(LTop - Luma4(Fetch(0, -2)));
+
+					MaxDelta = FVector2f(FMath::Max(MaxDelta.X, Delta.Z), FMath::Max(MaxDelta.Y, Delta.W));
+					const float FinalDelta = FMath::Max(MaxDelta.X, MaxDelta.Y);
+
+					// Local contrast adaptation
+					Edges.X *= Step(FinalDelta, Settings.AdaptationFactor * Delta.X);
+					Edges.Y *= Step(FinalDelta, Settings.AdaptationFactor * Delta.Y);
+				}
+			}
+			else
+			{
+				const FVector4f& C = Fetch(0, 0);
+
+				FVector4f Delta;
+				Delta.X = MaxColourDelta(C, Fetch(-1, 0));
+				Delta.Y = MaxColourDelta(C, Fetch(0, -1));
+				Edges = FVector2f(Step(Threshold, Delta.X), Step(Threshold, Delta.Y));
+
+				if (Edges.X + Edges.Y != 0.f)
+				{
+					// Calculate right and bottom deltas
+					Delta.Z = MaxColourDelta(C, Fetch(1, 0));
+					Delta.W = MaxColourDelta(C, Fetch(0, 1));
+
+					FVector2f MaxDelta(FMath::Max(Delta.X, Delta.Z), FMath::Max(Delta.Y, Delta.W));
+
+					// Calculate left-left and top-top deltas. SMAAColorEdgeDetectionCS compares against the centre
+					Delta.Z = MaxColourDelta(C, Fetch(-2, 0));
+					Delta.W = MaxColourDelta(C, Fetch(0, -2));
+
+					MaxDelta = FVector2f(FMath::Max(MaxDelta.X, Delta.Z), FMath::Max(MaxDelta.Y, Delta.W));
+					const float FinalDelta = FMath::Max(MaxDelta.X, MaxDelta.Y);
+
+					// Local contrast adaptation
+					Edges.X *= Step(FinalDelta, Settings.AdaptationFactor * Delta.X);
+					Edges.Y *= Step(FinalDelta, Settings.AdaptationFactor * Delta.Y);
+				}
+			}
+
+			OutEdges.At(X, Y) = FVector4f(Edges.X, Edges.Y, 1.f, 1.f);
+		}
+	});
+}
+
+void SMAACPUBlendingWeights(const FSMAACPUSettings& Settings, const FSMAALookupTables& Tables, const FSMAACPUImage& Edges, FSMAACPUImage& OutBlend)
+{
+	using namespace SMAACPU;
+
+	check(Tables.IsValid());
+
+	OutBlend.Init(Edges.Width, Edges.Height);
+
+	const FBlendContext Context{
+		Settings,
+		Tables,
+		Edges,
+		IsDiagonalDetectionEnabled(Settings.Quality),
+		IsCornerDetectionEnabled(Settings.Quality),
+		float(Settings.CornerRounding) / 100.f
+	};
+
+	ParallelForRows(Edges.Height, Settings.NumThreads, [&](int32 Y)
+	{
+		for (int32 X = 0; X < Edges.Width; ++X)
+		{
+			OutBlend.At(X, Y) = BlendingWeightCalculation(Context, X, Y);
+		}
+	});
+}
+
+void SMAACPUNeighbourhoodBlending(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, const FSMAACPUImage& Blend, FSMAACPUImage& OutColour)
+{
+	using namespace SMAACPU;
+
+	const FSMAACPUImage& Colour = Frame.Colour;
+	OutColour.Init(Colour.Width, Colour.Height);
+
+	const bool bReprojection = HasReprojection(Frame);
+
+	ParallelForRows(Colour.Height, Settings.NumThreads, [&](int32 Y)
+	{
+		for (int32 X = 0; X < Colour.Width; ++X)
+		{
+			const FVector2f TexCoord(X + 0.5f, Y + 0.5f);
+
+			// Fetch the blending weights for current pixel
+			FVector4f A;
+			A.X = Blend.SampleBilinear(TexCoord.X + 1.f, TexCoord.Y).W; // Right
+			A.Y = Blend.SampleBilinear(TexCoord.X, TexCoord.Y + 1.f).Y; // Top
+			const FVector4f Centre = Blend.SampleBilinear(TexCoord.X, TexCoord.Y);
+			A.W = Centre.X; // Bottom
+			A.Z = Centre.Z; // Left
+
+			FVector4f Result;
+
+			// Is there any blending weight with a value greater than 0.0?
+			if (A.X + A.Y + A.Z + A.W < 1e-5f)
+			{
+				Result = Colour.SampleBilinear(TexCoord.X, TexCoord.Y);
+
+				if (bReprojection)
+				{
+					// Pack velocity into the alpha channel
+					Result.W = FMath::Sqrt(5.f * GetVelocityTAA(Frame, TexCoord).Length());
+				}
+			}
+			else
+			{
+				const bool bHorizontal = FMath::Max(A.X, A.Z) > FMath::Max(A.Y, A.W);
+
+				// Calculate the blending offsets
+				const FVector4f BlendingOffset = bHorizontal ? FVector4f(A.X, 0.f, A.Z, 0.f) : FVector4f(0.f, A.Y, 0.f, A.W);
+				FVector2f BlendingWeight = bHorizontal ? FVector2f(A.X, A.Z) : FVector2f(A.Y, A.W);
+				BlendingWeight /= BlendingWeight.X + BlendingWeight.Y;
+
+				// Calculate the texture coordinates
+				const FVector2f CoordA(TexCoord.X + BlendingOffset.X, TexCoord.Y + BlendingOffset.Y);
+				const FVector2f CoordB(TexCoord.X - BlendingOffset.Z, TexCoord.Y - BlendingOffset.W);
+
+				// We exploit bilinear filtering to mix current pixel with the chosen neighbor
+				Result = BlendingWeight.X * Colour.SampleBilinear(CoordA.X, CoordA.Y);
+				Result += BlendingWeight.Y * Colour.SampleBilinear(CoordB.X, CoordB.Y);
+
+				if (bReprojection)
+				{
+					// Antialias velocity for proper reprojection in a later stage
+					const FVector2f Velocity = GetVelocityTAA(Frame, CoordA) + GetVelocityTAA(Frame, CoordB);
+					Result.W = FMath::Sqrt(5.f * Velocity.Length());
+				}
+			}
+
+			OutColour.At(X, Y) = Result;
+		}
+	});
+}
+
+void SMAACPUTemporalResolve(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, const FSMAACPUImage& Current, const FSMAACPUImage& Past, FSMAACPUImage& OutResolved)
+{
+	using namespace SMAACPU;
+
+	check(Current.Width == Past.Width && Current.Height == Past.Height);
+
+	OutResolved.Init(Current.Width, Current.Height);
+
+	const bool bReprojection = HasReprojection(Frame);
+	const FVector2f InvSize(1.f / Current.Width, 1.f / Current.Height);
+
+	ParallelForRows(Current.Height, Settings.NumThreads, [&](int32 Y)
+	{
+		for (int32 X = 0; X < Current.Width; ++X)
+		{
+			const FVector2f TexCoord(X + 0.5f, Y + 0.5f);
+			const FVector4f& CurrentColour = Current.At(X, Y);
+
+			if (!bReprojection)
+			{
+				// Just blend the pixels
+				OutResolved.At(X, Y) = FMath::Lerp(CurrentColour, Past.At(X, Y), Settings.TemporalHistoryBias);
+				continue;
+			}
+
+			// Velocity is assumed to be calculated for motion blur, so we need to inverse it for reprojection
+			const FVector2f Velocity = FVector2f(-0.5f, 0.5f) * GetVelocityTAA(Frame, TexCoord);
+			const FVector2f UV = TexCoord * InvSize;
+
+			// Reproject current coordinates and fetch previous pixel. Bilinear, as SMAAResolveCS samples it
+			const FVector2f Limit(FMath::Clamp(UV.X + Velocity.X, 0.f, 1.f), FMath::Clamp(UV.Y + Velocity.Y, 0.f, 1.f));
+			const FVector4f PreviousColour = Past.SampleBilinear(Limit.X * Past.Width, Limit.Y * Past.Height);
+
+			// Don't reproject from off screen
+			const FVector2f ScreenPos = FVector2f(2.f * UV.X - 1.f, 1.f - 2.f * UV.Y) + Velocity;
+			const bool bOffScreen = FMath::Max(FMath::Abs(ScreenPos.X), FMath::Abs(ScreenPos.Y)) >= 1.f;
+
+			// Attenuate the previous pixel if the velocity is different
+			const float Delta = FMath::Abs(CurrentColour.W * CurrentColour.W - PreviousColour.W * PreviousColour.W) / 5.f;
+			float Weight = Settings.TemporalHistoryBias * FMath::Clamp(1.f - FMath::Sqrt(Delta) * Settings.ReprojectionWeight, 0.f, 1.f);
+			if (bOffScreen)
+			{
+				Weight = 0.f;
+			}
+
+			OutResolved.At(X, Y) = FMath::Lerp(CurrentColour, PreviousColour, Weight);
+		}
+	});
+}
+
+FSMAACPUStageTimings RunSMAACPU(const FSMAACPUSettings& Settings, const FSMAALookupTables& Tables, const FSMAACPUFrame& Frame, const FSMAACPUImage* History, FSMAACPUImage& OutColour)
+{
+	FSMAACPUStageTimings Timings;
+
+	FSMAACPUImage Edges;
+	FSMAACPUImage Blend;
+
+	double StartTime = FPlatformTime::Seconds();
+	SMAACPUEdgeDetection(Settings, Frame, Edges);
+	Timings.EdgeDetection = FPlatformTime::Seconds() - StartTime;
+
+	StartTime = FPlatformTime::Seconds();
+	SMAACPUBlendingWeights(Settings, Tables, Edges, Blend);
+	Timings.BlendingWeights = FPlatformTime::Seconds() - StartTime;
+
+	// Edges are not needed past this point
+	Edges = FSMAACPUImage();
+
+	const bool bResolve = History && History->Width == Frame.Colour.Width && History->Height == Frame.Colour.Height;
+
+	FSMAACPUImage Blended;
+	StartTime = FPlatformTime::Seconds();
+	SMAACPUNeighbourhoodBlending(Settings, Frame, Blend, bResolve ? Blended : OutColour);
+	Timings.NeighbourhoodBlending = FPlatformTime::Seconds() - StartTime;
+
+	if (bResolve)
+	{
+		StartTime = FPlatformTime::Seconds();
+		SMAACPUTemporalResolve(Settings, Frame, Blended, *History, OutColour);
+		Timings.TemporalResolve = FPlatformTime::Seconds() - StartTime;
+	}
+
+	return Timings;
+}
+
+///// ///// ////////// ///// /////
+// Banded processing
+//
+
+int32 GetSMAACPUBandApron(const FSMAACPUSettings& Settings)
+{
+	return GetSMAASearchApron(Settings.Quality, Settings.MaxSearchSteps, Settings.MaxDiagonalSearchSteps);
+}
+
+FSMAACPUStageTimings RunSMAACPUBanded(const FSMAACPUSettings& Settings, const FSMAALookupTables& Tables, const FSMAACPUBandedIO& IO, int32 BandHeight)
+{
+	check(IO.ReadRows && IO.WriteRows);
+
+	FSMAACPUStageTimings Timings;
+
+	// The first band is read ahead of the loop, and would outlive this call if the loop never consumed it
+	if (IO.Width <= 0 || IO.Height <= 0)
+	{
+		return Timings;
+	}
+
+	BandHeight = FMath::Clamp(BandHeight, 1, FMath::Max(IO.Height, 1));
+	const int32 Apron = GetSMAACPUBandApron(Settings);
+	const int32 NumBands = FMath::DivideAndRoundUp(IO.Height, BandHeight);
+
+	struct FBand
+	{
+		FSMAACPUFrame Frame;
+
+		// First image row held in Frame
+		int32 FirstRow = 0;
+	};
+
+	auto ReadBand = [&IO, Apron, BandHeight](int32 BandIndex)
+	{
+		const int32 BandStart = BandIndex * BandHeight;
+		const int32 BandEnd = FMath::Min(IO.Height, BandStart + BandHeight);
+
+		FBand Band;
+		Band.FirstRow = FMath::Max(0, BandStart - Apron);
+		IO.ReadRows(Band.FirstRow, FMath::Min(IO.Height, BandEnd + Apron) - Band.FirstRow, Band.Frame);
+		return Band;
+	};
+
+	TFuture<FBand> NextBand = Async(EAsyncExecution::ThreadPool, [&ReadBand]() { return ReadBand(0); });
+	TFuture<void> PendingWrite;
+
+	for (int32 BandIndex = 0; BandIndex < NumBands; ++BandIndex)
+	{
+		FBand Band = NextBand.Consume();
+		if (BandIndex + 1 < NumBands)
+		{
+			NextBand = Async(EAsyncExecution::ThreadPool, [&ReadBand, BandIndex]() { return ReadBand(BandIndex + 1); });
+		}
+
+		// The apron rows are processed too, but only the band's own rows are kept
+		FSMAACPUImage Blended;
+		{
+			FSMAACPUImage Edges;
+			FSMAACPUImage Blend;
+
+			double StartTime = FPlatformTime::Seconds();
+			SMAACPUEdgeDetection(Settings, Band.Frame, Edges);
+			Timings.EdgeDetection += FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			SMAACPUBlendingWeights(Settings, Tables, Edges, Blend);
+			Timings.BlendingWeights += FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			SMAACPUNeighbourhoodBlending(Settings, Band.Frame, Blend, Blended);
+			Timings.NeighbourhoodBlending += FPlatformTime::Seconds() - StartTime;
+		}
+
+		const int32 BandStart = BandIndex * BandHeight;
+		const int32 BandRows = FMath::Min(IO.Height, BandStart + BandHeight) - BandStart;
+
+		FSMAACPUImage Rows;
+		Rows.Init(Blended.Width, BandRows);
+		FMemory::Memcpy(Rows.Pixels.GetData(), &Blended.At(0, BandStart - Band.FirstRow), Rows.Pixels.Num() * sizeof(FVector4f));
+
+		// Keep at most one write in flight
+		if (PendingWrite.IsValid())
+		{
+			PendingWrite.Wait();
+		}
+
+		PendingWrite = Async(EAsyncExecution::ThreadPool, [&IO, BandStart, Rows = MoveTemp(Rows)]()
+		{
+			IO.WriteRows(BandStart, Rows);
+		});
+	}
+
+	if (PendingWrite.IsValid())
+	{
+		PendingWrite.Wait();
+	}
+
+	return Timings;
+}
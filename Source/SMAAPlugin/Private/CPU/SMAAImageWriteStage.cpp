@@ -0,0 +1,382 @@
+#include "SMAAImageWriteStage.h"
+
+#include "PostProcess/PostProcessSMAA.h"
+#include "SMAADeveloperSettings.h"
+#include "Containers/Ticker.h"
+#include "Engine/Texture2D.h"
+#include "GlobalShader.h"
+#include "HAL/IConsoleManager.h"
+#include "ImagePixelData.h"
+#include "ImageWriteTask.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RenderingThread.h"
+#include "RHIGPUReadback.h"
+#include "ShaderParameterStruct.h"
+#include "TextureResource.h"
+
+/**
+ * Decodes the area texture into a float target, for reading it back when its source data isn't available
+ */
+class FSMAAAreaTextureReadbackCS : public FGlobalShader
+{
+public:
+	static const int ThreadgroupSizeX = 8;
+	static const int ThreadgroupSizeY = 8;
+	static const int ThreadgroupSizeZ = 1;
+
+	DECLARE_GLOBAL_SHADER(FSMAAAreaTextureReadbackCS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAAAreaTextureReadbackCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, AreaTexture)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, DecodedArea)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return true;
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), ThreadgroupSizeX);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), ThreadgroupSizeY);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), ThreadgroupSizeZ);
+		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAAAreaTextureReadbackCS, "/SMAAPlugin/Private/SMAA_AreaTextureReadback.usf",
+	"AreaTextureReadbackCS", SF_Compute);
+
+namespace SMAAImageWriteStage
+{
+	using FTablesPtr = TSharedPtr<const FSMAALookupTables, ESPMode::ThreadSafe>;
+
+	// Copies the decoded texels out of a finished readback on the render thread
+	FTablesPtr DecodeReadback(FRHIGPUTextureReadback& Readback, FIntPoint Size)
+	{
+		int32 RowPitchInPixels = 0;
+		const FLinearColor* Colours = static_cast<const FLinearColor*>(Readback.Lock(RowPitchInPixels));
+		if (!Colours)
+		{
+			return nullptr;
+		}
+
+		TArray<FVector2f> Texels;
+		Texels.SetNumUninitialized(Size.X * Size.Y);
+		for (int32 Y = 0; Y < Size.Y; ++Y)
+		{
+			for (int32 X = 0; X < Size.X; ++X)
+			{
+				const FLinearColor& Colour = Colours[Y * RowPitchInPixels + X];
+				Texels[Y * Size.X + X] = FVector2f(Colour.R, Colour.G);
+			}
+		}
+		Readback.Unlock();
+
+		TSharedRef<FSMAALookupTables, ESPMode::ThreadSafe> Tables = MakeShared<FSMAALookupTables, ESPMode::ThreadSafe>();
+		return Tables->InitFromAreaTexels(Size.X, Size.Y, MoveTemp(Texels)) ? FTablesPtr(Tables) : nullptr;
+	}
+
+	/**
+	 * Reads the area texture back from the GPU. The copy is only queued, and the core ticker checks once per frame
+	 * whether it has landed, so neither thread ever waits for the GPU.
+	 */
+	TSharedFuture<FTablesPtr> ReadBackAreaTexture(UTexture2D* AreaTexture)
+	{
+		TSharedRef<TPromise<FTablesPtr>, ESPMode::ThreadSafe> Promise = MakeShared<TPromise<FTablesPtr>, ESPMode::ThreadSafe>();
+		TSharedFuture<FTablesPtr> Future = Promise->GetFuture().Share();
+
+		FTextureResource* Resource = AreaTexture ? AreaTexture->GetResource() : nullptr;
+		if (!Resource)
+		{
+			Promise->SetValue(nullptr);
+			return Future;
+		}
+
+		struct FReadback
+		{
+			TUniquePtr<FRHIGPUTextureReadback> Readback;
+			FIntPoint Size = FIntPoint::ZeroValue;
+			std::atomic<bool> bPollQueued = false;
+			std::atomic<bool> bDone = false;
+		};
+		TSharedRef<FReadback, ESPMode::ThreadSafe> State = MakeShared<FReadback, ESPMode::ThreadSafe>();
+
+		ENQUEUE_RENDER_COMMAND(SMAAReadBackAreaTexture)([Resource, Promise, State](FRHICommandListImmediate& RHICmdList)
+		{
+			FRHITexture* TextureRHI = Resource->GetTexture2DRHI();
+			if (!TextureRHI)
+			{
+				Promise->SetValue(nullptr);
+				State->bDone = true;
+				return;
+			}
+
+			State->Size = FIntPoint(TextureRHI->GetSizeXYZ().X, TextureRHI->GetSizeXYZ().Y);
+			State->Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("SMAA.AreaTextureReadback"));
+
+			FRDGBuilder GraphBuilder(RHICmdList);
+
+			FRDGTextureRef Area = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(TextureRHI, TEXT("SMAA.AreaTexture")));
+			FRDGTextureRef Decoded = GraphBuilder.CreateTexture(
+				FRDGTextureDesc::Create2D(State->Size, PF_A32B32G32R32F, FClearValueBinding::Black, TexCreate_ShaderResource | TexCreate_UAV),
+				TEXT("SMAA.DecodedAreaTexture"));
+
+			FSMAAAreaTextureReadbackCS::FParameters* PassParameters =
+				GraphBuilder.AllocParameters<FSMAAAreaTextureReadbackCS::FParameters>();
+			PassParameters->AreaTexture = Area;
+			PassParameters->DecodedArea = GraphBuilder.CreateUAV(Decoded);
+
+			TShaderMapRef<FSMAAAreaTextureReadbackCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FComputeShaderUtils::AddPass(
+				GraphBuilder, RDG_EVENT_NAME("SMAA/AreaTextureReadback (CS)"), ComputeShader, PassParameters,
+				FComputeShaderUtils::GetGroupCount(FIntVector(State->Size.X, State->Size.Y, 1),
+					FIntVector(FSMAAAreaTextureReadbackCS::ThreadgroupSizeX,
+						FSMAAAreaTextureReadbackCS::ThreadgroupSizeY,
+						FSMAAAreaTextureReadbackCS::ThreadgroupSizeZ)));
+
+			AddEnqueueCopyPass(GraphBuilder, State->Readback.Get(), Decoded);
+			GraphBuilder.Execute();
+		});
+
+		FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Promise, State](float)
+		{
+			if (State->bDone)
+			{
+				return false;
+			}
+
+			// One check in flight at a time, in case the render thread is behind
+			if (!State->bPollQueued.exchange(true))
+			{
+				ENQUEUE_RENDER_COMMAND(SMAAPollAreaTextureReadback)([Promise, State](FRHICommandListImmediate&)
+				{
+					State->bPollQueued = false;
+					if (State->bDone || !State->Readback.IsValid() || !State->Readback->IsReady())
+					{
+						return;
+					}
+
+					Promise->SetValue(DecodeReadback(*State->Readback, State->Size));
+					State->Readback.Reset();
+					State->bDone = true;
+				});
+			}
+			return true;
+		}));
+
+		return Future;
+	}
+
+	// The tables decoded from the last area texture, so every stage after the first starts with them ready
+	TWeakObjectPtr<UTexture2D> CachedAreaTexture;
+	TOptional<TSharedFuture<FTablesPtr>> CachedTables;
+
+	TSharedFuture<FTablesPtr> GetLookupTables(UTexture2D* AreaTexture)
+	{
+		check(IsInGameThread());
+
+		// A failed decode is tried again, the texture may not have had a resource yet
+		const bool bFailed = CachedTables.IsSet() && CachedTables->IsReady() && !CachedTables->Get().IsValid();
+		if (CachedTables.IsSet() && !bFailed && CachedAreaTexture.Get() == AreaTexture)
+		{
+			return CachedTables.GetValue();
+		}
+
+		CachedAreaTexture = AreaTexture;
+
+#if WITH_EDITORONLY_DATA
+		TSharedRef<FSMAALookupTables, ESPMode::ThreadSafe> SourceTables = MakeShared<FSMAALookupTables, ESPMode::ThreadSafe>();
+		if (SourceTables->InitFromTexture(AreaTexture))
+		{
+			TPromise<FTablesPtr> Promise;
+			Promise.SetValue(SourceTables);
+			CachedTables = Promise.GetFuture().Share();
+			return CachedTables.GetValue();
+		}
+#endif
+
+		CachedTables = ReadBackAreaTexture(AreaTexture);
+		return CachedTables.GetValue();
+	}
+
+	FVector4f ToVector(const FColor& Colour)
+	{
+		return FVector4f(Colour.R, Colour.G, Colour.B, Colour.A) / 255.f;
+	}
+
+	FVector4f ToVector(const FFloat16Color& Colour)
+	{
+		return FVector4f(Colour.R.GetFloat(), Colour.G.GetFloat(), Colour.B.GetFloat(), Colour.A.GetFloat());
+	}
+
+	FVector4f ToVector(const FLinearColor& Colour)
+	{
+		return FVector4f(Colour.R, Colour.G, Colour.B, Colour.A);
+	}
+
+	void FromVector(const FVector4f& Value, FColor& OutColour)
+	{
+		// 8 bit captures are already display encoded, which is also what the post process SMAA pass sees
+		OutColour = FLinearColor(Value.X, Value.Y, Value.Z, Value.W).QuantizeRound();
+	}
+
+	void FromVector(const FVector4f& Value, FFloat16Color& OutColour)
+	{
+		OutColour = FFloat16Color(FLinearColor(Value.X, Value.Y, Value.Z, Value.W));
+	}
+
+	void FromVector(const FVector4f& Value, FLinearColor& OutColour)
+	{
+		OutColour = FLinearColor(Value.X, Value.Y, Value.Z, Value.W);
+	}
+
+	// Streams the image through the banded path, so only the output copy is full size
+	template<typename PixelType>
+	void ProcessPixels(const FSMAACPUSettings& Settings, const FSMAALookupTables& Tables, int32 BandHeight, TImagePixelData<PixelType>& PixelData)
+	{
+		const FIntPoint Size = PixelData.GetSize();
+		if (Size.X <= 0 || Size.Y <= 0 || PixelData.Pixels.Num() != int64(Size.X) * Size.Y)
+		{
+			return;
+		}
+
+		const TArray64<PixelType>& Source = PixelData.Pixels;
+		TArray64<PixelType> Output;
+		Output.SetNumUninitialized(Source.Num());
+
+		FSMAACPUBandedIO IO;
+		IO.Width = Size.X;
+		IO.Height = Size.Y;
+		IO.ReadRows = [&Source, Size](int32 FirstRow, int32 NumRows, FSMAACPUFrame& OutFrame)
+		{
+			OutFrame.Colour.Init(Size.X, NumRows);
+			for (int32 Y = 0; Y < NumRows; ++Y)
+			{
+				const PixelType* Row = &Source[int64(FirstRow + Y) * Size.X];
+				for (int32 X = 0; X < Size.X; ++X)
+				{
+					OutFrame.Colour.At(X, Y) = ToVector(Row[X]);
+				}
+			}
+		};
+		IO.WriteRows = [&Output, Size](int32 FirstRow, const FSMAACPUImage& Rows)
+		{
+			for (int32 Y = 0; Y < Rows.Height; ++Y)
+			{
+				PixelType* Row = &Output[int64(FirstRow + Y) * Size.X];
+				for (int32 X = 0; X < Size.X; ++X)
+				{
+					FromVector(Rows.At(X, Y), Row[X]);
+				}
+			}
+		};
+
+		RunSMAACPUBanded(Settings, Tables, IO, BandHeight);
+
+		PixelData.Pixels = MoveTemp(Output);
+	}
+}
+
+TSharedRef<FSMAAImageWriteStage, ESPMode::ThreadSafe> FSMAAImageWriteStage::Create(const FSMAACPUSettings& InSettings, UTexture2D* AreaTexture)
+{
+	check(IsInGameThread());
+
+	TSharedRef<FSMAAImageWriteStage, ESPMode::ThreadSafe> Stage = MakeShared<FSMAAImageWriteStage, ESPMode::ThreadSafe>();
+	Stage->Settings = InSettings;
+
+	// Only colour is captured
+	if (Stage->Settings.EdgeMode != ESMAAEdgeDetectors::Luminance && Stage->Settings.EdgeMode != ESMAAEdgeDetectors::Colour)
+	{
+		Stage->Settings.EdgeMode = ESMAAEdgeDetectors::Luminance;
+	}
+
+	if (!AreaTexture)
+	{
+		USMAADeveloperSettings::Get()->LoadTextures();
+		AreaTexture = USMAADeveloperSettings::Get()->SMAAAreaTexture;
+	}
+
+	Stage->Tables = SMAAImageWriteStage::GetLookupTables(AreaTexture);
+	return Stage;
+}
+
+FSMAACPUSettings FSMAAImageWriteStage::GetSettingsFromCVars()
+{
+	check(IsInGameThread());
+
+	auto GetInt = [](const TCHAR* Name, int32 Default)
+	{
+		const IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(Name);
+		return CVar ? CVar->GetInt() : Default;
+	};
+
+	auto GetFloat = [](const TCHAR* Name, float Default)
+	{
+		const IConsoleVariable* CVar = IConsoleManager::Get().FindConsoleVariable(Name);
+		return CVar ? CVar->GetFloat() : Default;
+	};
+
+	// Same ranges as the getters in PostProcessSMAA.cpp
+	FSMAACPUSettings Settings;
+	Settings.Quality = ESMAAPreset(FMath::Clamp(GetInt(TEXT("r.SMAA.Quality"), 3), 0, int32(ESMAAPreset::Custom)));
+	Settings.EdgeMode = ESMAAEdgeDetectors(FMath::Clamp(GetInt(TEXT("r.SMAA.EdgeDetector"), 1), 0, 3));
+	Settings.MaxSearchSteps = uint8(FMath::Clamp(GetInt(TEXT("r.SMAA.MaxSearchSteps"), 8), 0, 112));
+	Settings.MaxDiagonalSearchSteps = uint8(FMath::Clamp(GetInt(TEXT("r.SMAA.MaxSearchStepsDiagonal"), 16), 0, 20));
+	Settings.CornerRounding = uint8(FMath::Clamp(GetInt(TEXT("r.SMAA.CornerRounding"), 25), 0, 100));
+	Settings.AdaptationFactor = FMath::Clamp(GetFloat(TEXT("r.SMAA.AdaptationFactor"), 2.f), 0.f, 10.f);
+
+	// The GPU bakes these into all but the Custom preset
+	GetSMAAPresetSearchSettings(Settings.Quality, Settings.MaxSearchSteps, Settings.MaxDiagonalSearchSteps, Settings.CornerRounding);
+	return Settings;
+}
+
+void FSMAAImageWriteStage::Process(FImagePixelData* PixelData) const
+{
+	if (!PixelData || !Tables.IsValid())
+	{
+		return;
+	}
+
+	if (!Tables.IsReady())
+	{
+		// Without source data the tables are decoded by a game thread ticker and a render command, so waiting on
+		// either thread would never finish. Pass the pixels through instead
+		if (IsInGameThread() || IsInRenderingThread())
+		{
+			UE_LOG(LogSMAA, Warning, TEXT("SMAA lookup tables are still being read back, writing the image without SMAA"));
+			return;
+		}
+
+		check(!IsInGameThread() && !IsInRenderingThread());
+	}
+
+	const SMAAImageWriteStage::FTablesPtr& LookupTables = Tables.Get();
+	if (!LookupTables.IsValid())
+	{
+		return;
+	}
+
+	switch (PixelData->GetType())
+	{
+		case EImagePixelType::Color:
+			SMAAImageWriteStage::ProcessPixels(Settings, *LookupTables, BandHeight, *static_cast<TImagePixelData<FColor>*>(PixelData));
+			break;
+		case EImagePixelType::Float16:
+			SMAAImageWriteStage::ProcessPixels(Settings, *LookupTables, BandHeight, *static_cast<TImagePixelData<FFloat16Color>*>(PixelData));
+			break;
+		case EImagePixelType::Float32:
+			SMAAImageWriteStage::ProcessPixels(Settings, *LookupTables, BandHeight, *static_cast<TImagePixelData<FLinearColor>*>(PixelData));
+			break;
+	}
+}
+
+void FSMAAImageWriteStage::AddToTask(FImageWriteTask& Task)
+{
+	Task.PixelPreProcessors.Add([Stage = AsShared()](FImagePixelData* PixelData)
+	{
+		Stage->Process(PixelData);
+	});
+}
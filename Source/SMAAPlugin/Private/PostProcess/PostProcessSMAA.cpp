@@ -1,10 +1,16 @@
 #include "PostProcess/PostProcessSMAA.h"
+#include "PostProcess/SMAAEdgeStats.h"
+#include "PostProcess/SMAAGroupShapeBenchmark.h"
+#include "PostProcess/SMAAMemoryStats.h"
+#include "PostProcess/SMAAStaticFrame.h"
 
 #include "PostProcess/PostProcessing.h"
 #include "PostProcess/PostProcessMaterialInputs.h"
 #include "Rendering/Texture2DResource.h"
 #include "ScenePrivate.h"
+#include "SMAAGPU.h"
 #include "SMAASceneExtension.h"
+#include "SMAAShaderPermutations.h"
 #include "SceneViewExtension.h"
 
 #include "SceneView.h"
@@ -13,6 +19,11 @@
 #include "Engine/TextureRenderTarget2D.h"
 #include "DynamicResolutionState.h"
 #include "FXRenderingUtils.h"
+#include "RHIGPUReadback.h"
+#include "RenderingThread.h"
+#include "Engine/Texture2D.h"
+
+DEFINE_LOG_CATEGORY(LogSMAA);
 
 DECLARE_GPU_STAT(SMAAPass);
 DECLARE_GPU_STAT_NAMED(SMAADispatch, TEXT("SMAA Dispatch"));
@@ -23,7 +34,16 @@ TAutoConsoleVariable<int32> CVarSMAAQuality(
 		TEXT(" 0: Low Preset \n")
 			TEXT(" 1: Medium Preset \n")
 				TEXT(" 2: High Preset \n")
-					TEXT(" 3: Ultra Preset (Default) \n"),
+					TEXT(" 3: Ultra Preset (Default) \n")
+						TEXT(" 4: Custom, Ultra with the search parameters from r.SMAA.MaxSearchSteps, MaxSearchStepsDiagonal and CornerRounding \n")
+							TEXT("Presets 0 - 3 compile their search parameters in, so the searches are bounded at compile time."),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAAMode(
+	TEXT("r.SMAA.Mode"), 1,
+	TEXT("SMAA mode of the main views. Scene captures follow r.SMAA.SceneCaptures.\n")
+		TEXT(" 0 - SMAA 1x: no projection jitter, velocity, resolve or history, for the lowest cost\n")
+			TEXT(" 1 - SMAA T2x: jittered and resolved against the last frame (Default)"),
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 
 TAutoConsoleVariable<int32> CVarSMAAEdgeMode(
@@ -45,15 +65,15 @@ TAutoConsoleVariable<int32> CVarSMAAPredicationSource(
 	ECVF_RenderThreadSafe);
 
 TAutoConsoleVariable<int32> CVarSMAAMaxSearchSteps(TEXT("r.SMAA.MaxSearchSteps"), 8,
-	TEXT("Maximum steps performed in Horizontal/Vert patterns [0 - 112]"),
+	TEXT("Maximum steps performed in Horizontal/Vert patterns [0 - 112]. r.SMAA.Quality 4 only"),
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 
 TAutoConsoleVariable<int32> CVarSMAAMaxDiagonalSearchSteps(TEXT("r.SMAA.MaxSearchStepsDiagonal"), 16,
-	TEXT("Maximum steps performed in Diagonal patterns [0 - 20]"),
+	TEXT("Maximum steps performed in Diagonal patterns [0 - 20]. r.SMAA.Quality 4 only"),
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 
 TAutoConsoleVariable<int32> CVarSMAACornerRounding(TEXT("r.SMAA.CornerRounding"), 25,
-	TEXT("Specifies how much sharp corners will be rounded [0 - 100]"),
+	TEXT("Specifies how much sharp corners will be rounded [0 - 100]. r.SMAA.Quality 4 only"),
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 
 TAutoConsoleVariable<float> CVarSMAAAdaptationFactor(TEXT("r.SMAA.AdaptationFactor"), 2.0,
@@ -85,51 +105,253 @@ TAutoConsoleVariable<float> CVarSMAATemporalHistoryBias(TEXT("r.SMAA.TemporalHis
 	TEXT("Controls base weight from prior frames [0 - 1) (Default 0.4)"),
 	ECVF_Scalability | ECVF_RenderThreadSafe);
 
+TAutoConsoleVariable<int32> CVarSMAAPackedEdgeInput(TEXT("r.SMAA.PackedEdgeInput"), 0,
+	TEXT("Runs a prepass packing luma and the predication signal into a single RG16F texture,\n")
+		TEXT("which the luminance edge detector then reads instead of full scene colour and the predicate.\n")
+			TEXT(" 0 - off (Default)\n")
+				TEXT(" 1 - on (only affects r.SMAA.EdgeDetector 1)"),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAARasterPath(TEXT("r.SMAA.RasterPath"), 2,
+	TEXT("Runs edge detection, blend weights and neighbourhood blending as pixel shaders, with edge detection\n")
+		TEXT("writing a stencil mask so blend weights are only computed on edge pixels.\n")
+			TEXT(" 0 - compute\n")
+				TEXT(" 1 - raster\n")
+					TEXT(" 2 - raster on mobile platforms, compute elsewhere (Default)"),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAATileOverlap(TEXT("r.SMAA.TileOverlap"), 0,
+	TEXT("Pixels on each side of the view rect rendered only as context for neighbouring tiles, e.g. by\n")
+		TEXT("Movie Render Queue's high resolution tiling. Edges and blend weights cover the whole view,\n")
+			TEXT("but only the interior is anti-aliased, so tiles join without seams when the overlap is at\n")
+				TEXT("least the search apron of the view's preset: 14 pixels at Low, 22 at Medium, 38 at High and\n")
+					TEXT("70 at Ultra, while Custom derives it from r.SMAA.MaxSearchSteps and r.SMAA.MaxDiagonalSearchSteps.\n")
+						TEXT(" -1 - the search apron of the view's preset\n")
+							TEXT(" 0 - off (Default)"),
+	ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAASearchALU(TEXT("r.SMAA.SearchALU"), 1,
+	TEXT("How blend weight calculation measures the last step of each edge search.\n")
+		TEXT(" 0 - look it up in the search texture\n")
+			TEXT(" 1 - decode it arithmetically, without the search texture (Default)"),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAASharedRuns(TEXT("r.SMAA.SharedRuns"), 0,
+	TEXT("How blend weight calculation finds the ends of horizontal and vertical lines. Compute path only.\n")
+		TEXT(" 0 - every edge pixel searches its line on its own (Default)\n")
+			TEXT(" 1 - each thread group links its pixels into runs in groupshared memory and searches only the runs\n")
+				TEXT("     leaving the group, once per row and column. Same result, with the searches no longer\n")
+					TEXT("     repeated by every pixel along long edges\n")
+						TEXT(" 2 - as 1, but every pixel also searches on its own, and pixels where the two disagree are\n")
+							TEXT("     counted as Shared Run Mismatches in 'stat SMAA' and CSV. Turns on r.SMAA.EdgeStats. Debugging only"),
+	ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAAEdgeTileCulling(TEXT("r.SMAA.EdgeTileCulling"), 1,
+	TEXT("With the depth or world normal edge detector, classifies 8x8 tiles by their depth range first, and skips\n")
+		TEXT("edge detection and blend weights on tiles that can't hold edges, such as sky or flat floors.\n")
+			TEXT("Compute path only.\n")
+				TEXT(" 0 - off\n")
+					TEXT(" 1 - on (Default)"),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<float> CVarSMAAHistoryHeadroom(TEXT("r.SMAA.HistoryHeadroom"), 1.125,
+	TEXT("How much larger than the scene colour texture the T2x history is allocated [1 - 2] (Default 1.125)\n")
+		TEXT("The history keeps its size while the scene colour texture fits, so small resolution changes reuse it\n")
+			TEXT("rather than reallocating it. The resolve rescales into whatever view rect the history was written at."),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAASkipStencil(TEXT("r.SMAA.SkipStencil"), 0,
+	TEXT("Custom stencil value that excludes pixels from SMAA, e.g. for world space UI or objects that are already smooth\n")
+		TEXT("8x8 tiles made up only of excluded pixels skip every pass and keep their scene colour. Needs custom depth\n")
+			TEXT("with stencil (r.CustomDepth 3). Compute path only, ignored with a warning where r.SMAA.RasterPath picks raster,\n")
+				TEXT("which it does on mobile by default.\n")
+					TEXT(" 0 - off (Default)\n")
+						TEXT(" 1 - 255 - the stencil value to skip"),
+	ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAAStaticReuse(TEXT("r.SMAA.StaticReuse"), 0,
+	TEXT("Shows a view's last SMAA output again while the view holds still, skipping every pass, e.g. for editor viewports,\n")
+		TEXT("pause menus and idle screens. The CPU checks the view matrices and settings haven't changed; a GPU pass then\n")
+			TEXT("checks for foreground velocity and zeroes the other passes' dispatches when two frames in a row were still.\n")
+				TEXT("Compute path only, and off while edges are published, r.SMAA.EdgeStats or a group shape benchmark run.\n")
+					TEXT("The detection's GPU time is under \"SMAA Static Detect\", reused frames under stat SMAA. Keeps a history in 1x.\n")
+						TEXT(" 0 - off (Default)\n")
+							TEXT(" 1 - still when nothing draws velocity. Animated materials and lighting changes freeze\n")
+								TEXT(" 2 - also compares a hash of the scene colour with that of the frame with the same jitter"),
+	ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAACompileGroupShapes(TEXT("r.SMAA.CompileGroupShapes"), 0,
+	TEXT("Compiles the compute passes for every thread group shape and with swizzled group order, so r.SMAA.GroupShape.*\n")
+		TEXT("and r.SMAA.GroupSwizzle can pick between them. Multiplies those passes' permutations by eight. Those settings\n")
+		TEXT("are ignored without it, and are best set in each platform's device profile from what\n")
+		TEXT("r.SMAA.BenchmarkGroupShapes finds fastest.\n")
+			TEXT(" 0 - 8x8 in row order only (Default)\n")
+				TEXT(" 1 - all shapes"),
+	ECVF_ReadOnly | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAAGroupShapeEdgeDetection(TEXT("r.SMAA.GroupShape.EdgeDetection"), 0,
+	TEXT("Thread group shape of compute edge detection. Its cross shaped taps favour square groups.\n")
+	TEXT(" 0 - 8x8 (Default)\n")
+		TEXT(" 1 - 16x16\n")
+			TEXT(" 2 - 32x2\n")
+				TEXT(" 3 - 8x4\n")
+					TEXT("See r.SMAA.CompileGroupShapes."),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAAGroupShapeBlendWeights(TEXT("r.SMAA.GroupShape.BlendWeights"), 0,
+	TEXT("Thread group shape of compute blend weight calculation, whose horizontal and vertical searches read far along rows and columns.\n")
+	TEXT(" 0 - 8x8 (Default)\n")
+		TEXT(" 1 - 16x16\n")
+			TEXT(" 2 - 32x2\n")
+				TEXT(" 3 - 8x4\n")
+					TEXT("See r.SMAA.CompileGroupShapes."),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAAGroupShapeBlending(TEXT("r.SMAA.GroupShape.Blending"), 0,
+	TEXT("Thread group shape of compute neighbourhood blending.\n")
+	TEXT(" 0 - 8x8 (Default)\n")
+		TEXT(" 1 - 16x16\n")
+			TEXT(" 2 - 32x2\n")
+				TEXT(" 3 - 8x4\n")
+					TEXT("See r.SMAA.CompileGroupShapes."),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAAGroupShapeResolve(TEXT("r.SMAA.GroupShape.Resolve"), 0,
+	TEXT("Thread group shape of the compute T2x resolve.\n")
+	TEXT(" 0 - 8x8 (Default)\n")
+		TEXT(" 1 - 16x16\n")
+			TEXT(" 2 - 32x2\n")
+				TEXT(" 3 - 8x4\n")
+					TEXT("See r.SMAA.CompileGroupShapes."),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+TAutoConsoleVariable<int32> CVarSMAAGroupSwizzle(TEXT("r.SMAA.GroupSwizzle"), 0,
+	TEXT("Compute passes that walk their thread groups in Morton order within blocks of 8x8 groups, so groups running\n")
+		TEXT("together read neighbouring texels. A bitmask. Needs r.SMAA.CompileGroupShapes 1.\n")
+			TEXT(" 1 - edge detection\n")
+				TEXT(" 2 - blend weights\n")
+					TEXT(" 4 - neighbourhood blending\n")
+						TEXT(" 8 - T2x resolve"),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+///// ///// ////////// ///// /////
+// SMAA Uniform Buffer
+//
+
+/**
+ * Parameters shared by every SMAA pass of a view. Built once per view per frame.
+ */
+BEGIN_GLOBAL_SHADER_PARAMETER_STRUCT(FSMAAUniformParameters, )
+	SHADER_PARAMETER(FVector4f, ViewportMetrics)
+	SHADER_PARAMETER(float, NormalisedCornerRounding)
+	SHADER_PARAMETER(float, MaxSearchSteps)
+	SHADER_PARAMETER(float, MaxDiagonalSearchSteps)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, AreaTexture)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SearchTexture)
+	SHADER_PARAMETER_SAMPLER(SamplerState, PointTextureSampler)
+	SHADER_PARAMETER_SAMPLER(SamplerState, BilinearTextureSampler)
+END_GLOBAL_SHADER_PARAMETER_STRUCT()
+
+IMPLEMENT_GLOBAL_SHADER_PARAMETER_STRUCT(FSMAAUniformParameters, "SMAA");
+
 ///// ///// ////////// ///// /////
 // SMAA Shaders
 //
 
+// Edge detectors whose edges can be ruled out from a tile's depth range
+static bool SupportsSMAAEdgeTileCulling(ESMAAEdgeDetectors EdgeMode)
+{
+	return EdgeMode == ESMAAEdgeDetectors::Depth || EdgeMode == ESMAAEdgeDetectors::Normal;
+}
+
+// Swizzled dispatches walk blocks of this many groups square. Must match SMAA_SWIZZLE_BLOCK in SMAA_UE5.usf
+static constexpr int32 SMAASwizzleBlock = 8;
+
+// Shapes other than 8x8 in row order are only compiled on request, see r.SMAA.CompileGroupShapes
+static bool ShouldCompileSMAAGroupShape(ESMAAGroupShape Shape, bool bSwizzle)
+{
+	return (Shape == ESMAAGroupShape::Group8x8 && !bSwizzle) || AreSMAAGroupShapesCompiled();
+}
+
+static void ModifySMAAGroupShapeEnvironment(ESMAAGroupShape Shape, FShaderCompilerEnvironment& OutEnvironment)
+{
+	const FIntPoint GroupSize = GetSMAAGroupSize(Shape);
+	OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), GroupSize.X);
+	OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), GroupSize.Y);
+	OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), 1);
+}
+
+// Groups to dispatch over Size pixels. Swizzled dispatches are padded to whole blocks, which the shader skips, and
+// need the unpadded group count
+static FIntVector GetSMAAGroupCount(FIntPoint Size, const FSMAAGroupConfig& Config, FUintVector2& OutGroupCount)
+{
+	const FIntPoint GroupCount = FIntPoint::DivideAndRoundUp(Size, GetSMAAGroupSize(Config.Shape));
+	OutGroupCount = FUintVector2(GroupCount.X, GroupCount.Y);
+
+	if (!Config.bSwizzle)
+	{
+		return FIntVector(GroupCount.X, GroupCount.Y, 1);
+	}
+
+	const FIntPoint PaddedCount = FIntPoint::DivideAndRoundUp(GroupCount, SMAASwizzleBlock) * SMAASwizzleBlock;
+	return FIntVector(PaddedCount.X, PaddedCount.Y, 1);
+}
+
 /**
  * SMAA Edge Detection
  */
 class FSMAAEdgeDetectionCS : public FGlobalShader
 {
 public:
-	static const int ThreadgroupSizeX = 8;
-	static const int ThreadgroupSizeY = 8;
-	static const int ThreadgroupSizeZ = 1;
-
 	DECLARE_GLOBAL_SHADER(FSMAAEdgeDetectionCS);
 	SHADER_USE_PARAMETER_STRUCT(FSMAAEdgeDetectionCS, FGlobalShader);
 
 	class FSMAAPresetConfigDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_PRESET", ESMAAPreset);
 	class FSMAAEdgeModeConfigDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_EDMODE", ESMAAEdgeDetectors);
 	class FSMAAPredicateConfigDim : SHADER_PERMUTATION_BOOL("SMAA_PREDICATION");
+	class FSMAAPackedInputDim : SHADER_PERMUTATION_BOOL("SMAA_PACKED_INPUT");
+	class FSMAAEdgeStatsDim : SHADER_PERMUTATION_BOOL("SMAA_EDGE_STATS");
+	class FSMAATileMaskDim : SHADER_PERMUTATION_BOOL("SMAA_TILE_MASK");
+	class FSMAAGroupShapeDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_GROUP_SHAPE", ESMAAGroupShape);
+	class FSMAAGroupSwizzleDim : SHADER_PERMUTATION_BOOL("SMAA_GROUP_SWIZZLE");
 
 	using FPermutationDomain =
-		TShaderPermutationDomain<FSMAAPresetConfigDim, FSMAAEdgeModeConfigDim, FSMAAPredicateConfigDim>;
+		TShaderPermutationDomain<FSMAAPresetConfigDim, FSMAAEdgeModeConfigDim, FSMAAPredicateConfigDim, FSMAAPackedInputDim, FSMAAEdgeStatsDim, FSMAATileMaskDim, FSMAAGroupShapeDim, FSMAAGroupSwizzleDim>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_BUFFER_ACCESS(StaticIndirectArgs, ERHIAccess::IndirectArgs)
 	RDG_TEXTURE_ACCESS(DepthTexture, ERHIAccess::SRVCompute)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputDepth)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputSceneColor)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, Predicate)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, PackedEdgeInput)
 	SHADER_PARAMETER(float, AdaptationFactor)
 	SHADER_PARAMETER(float, PredicationThreshold)
 	SHADER_PARAMETER(float, PredicationScale)
 	SHADER_PARAMETER(float, PredicationStrength)
-	SHADER_PARAMETER_SAMPLER(SamplerState, PointTextureSampler)
-	SHADER_PARAMETER_SAMPLER(SamplerState, BilinearTextureSampler)
-	SHADER_PARAMETER(FVector4f, ViewportMetrics)
-	SHADER_PARAMETER(float, NormalisedCornerRounding)
-	SHADER_PARAMETER(float, MaxDiagonalSearchSteps)
-	SHADER_PARAMETER(float, MaxSearchSteps)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
 	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
 	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, EdgesTexture)
+	SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, EdgeStats)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint>, TileMask)
+	SHADER_PARAMETER(FUintVector2, GroupCount)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
 	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+
+		// The packed input only carries luma
+		if (PermutationVector.Get<FSMAAPackedInputDim>() && PermutationVector.Get<FSMAAEdgeModeConfigDim>() != ESMAAEdgeDetectors::Luminance)
+		{
+			return false;
+		}
+
+		if (!ShouldCompileSMAAGroupShape(PermutationVector.Get<FSMAAGroupShapeDim>(), PermutationVector.Get<FSMAAGroupSwizzleDim>()))
+		{
+			return false;
+		}
+
 		return true;
 
 		//TODO: Kory
@@ -141,6 +363,54 @@ public:
 		//return false;
 	}
 
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		ModifySMAAGroupShapeEnvironment(PermutationVector.Get<FSMAAGroupShapeDim>(), OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
+		OutEnvironment.SetDefine(TEXT("ENGINE_MAJOR_VERSION"), ENGINE_MAJOR_VERSION);
+		OutEnvironment.SetDefine(TEXT("ENGINE_MINOR_VERSION"), ENGINE_MINOR_VERSION);
+
+		if (PermutationVector.Get<FSMAAEdgeStatsDim>() && FDataDrivenShaderPlatformInfo::GetSupportsWaveOperations(Parameters.Platform) == ERHIFeatureSupport::RuntimeGuaranteed)
+		{
+			OutEnvironment.CompilerFlags.Add(CFLAG_WaveOperations);
+		}
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAAEdgeDetectionCS, "/SMAAPlugin/Private/SMAA_EdgeDetection.usf", "EdgeDetectionCS",
+	SF_Compute);
+
+/**
+ * SMAA Edge Input Prepass
+ */
+class FSMAAEdgeInputPrepassCS : public FGlobalShader
+{
+public:
+	static const int ThreadgroupSizeX = 8;
+	static const int ThreadgroupSizeY = 8;
+	static const int ThreadgroupSizeZ = 1;
+
+	DECLARE_GLOBAL_SHADER(FSMAAEdgeInputPrepassCS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAAEdgeInputPrepassCS, FGlobalShader);
+
+	class FSMAAPredicateConfigDim : SHADER_PERMUTATION_BOOL("SMAA_PREDICATION");
+
+	using FPermutationDomain = TShaderPermutationDomain<FSMAAPredicateConfigDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_BUFFER_ACCESS(StaticIndirectArgs, ERHIAccess::IndirectArgs)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputSceneColor)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, Predicate)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
+	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, PackedEdgeInput)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return true;
+	}
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
 		FShaderCompilerEnvironment& OutEnvironment)
 	{
@@ -152,107 +422,183 @@ public:
 		OutEnvironment.SetDefine(TEXT("ENGINE_MINOR_VERSION"), ENGINE_MINOR_VERSION);
 	}
 };
-IMPLEMENT_GLOBAL_SHADER(FSMAAEdgeDetectionCS, "/SMAAPlugin/Private/SMAA_EdgeDetection.usf", "EdgeDetectionCS",
-	SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSMAAEdgeInputPrepassCS, "/SMAAPlugin/Private/SMAA_EdgeInputPrepass.usf",
+	"EdgeInputPrepassCS", SF_Compute);
 
 /**
- * SMAA Blending Weight Calculation
+ * SMAA Tile Classification
  */
-class FSMAABlendingWeightsCS : public FGlobalShader
+class FSMAATileClassifyCS : public FGlobalShader
 {
 public:
+	// One group per tile, SMAA_TILE_SIZE in SMAA_UE5.usf. Later passes look tiles up by pixel, whatever their group shape
 	static const int ThreadgroupSizeX = 8;
 	static const int ThreadgroupSizeY = 8;
 	static const int ThreadgroupSizeZ = 1;
 
+	DECLARE_GLOBAL_SHADER(FSMAATileClassifyCS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAATileClassifyCS, FGlobalShader);
+
+	class FSMAAPresetConfigDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_PRESET", ESMAAPreset);
+	// 0 no depth test, 1 depth range, 2 sky only
+	class FSMAADepthModeDim : SHADER_PERMUTATION_RANGE_INT("SMAA_TILE_DEPTH_MODE", 0, 3);
+	class FSMAASkipStencilDim : SHADER_PERMUTATION_BOOL("SMAA_TILE_SKIP_STENCIL");
+
+	using FPermutationDomain = TShaderPermutationDomain<FSMAAPresetConfigDim, FSMAADepthModeDim, FSMAASkipStencilDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_BUFFER_ACCESS(StaticIndirectArgs, ERHIAccess::IndirectArgs)
+	RDG_TEXTURE_ACCESS(DepthTexture, ERHIAccess::SRVCompute)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputDepth)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<uint2>, CustomStencil)
+	SHADER_PARAMETER(uint32, SkipStencil)
+	SHADER_PARAMETER(FIntVector4, ViewRect)
+	SHADER_PARAMETER_ARRAY(FIntVector4, SkipRects, [FSMAAViewSettings::MaxSkipRects])
+	SHADER_PARAMETER(uint32, NumSkipRects)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
+	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, TileMask)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return true;
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), ThreadgroupSizeX);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), ThreadgroupSizeY);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), ThreadgroupSizeZ);
+		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
+		OutEnvironment.SetDefine(TEXT("ENGINE_MAJOR_VERSION"), ENGINE_MAJOR_VERSION);
+		OutEnvironment.SetDefine(TEXT("ENGINE_MINOR_VERSION"), ENGINE_MINOR_VERSION);
+		OutEnvironment.SetDefine(TEXT("SMAA_MAX_SKIP_RECTS"), FSMAAViewSettings::MaxSkipRects);
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAATileClassifyCS, "/SMAAPlugin/Private/SMAA_TileClassify.usf",
+	"TileClassifyCS", SF_Compute);
+
+/**
+ * SMAA Blending Weight Calculation
+ */
+class FSMAABlendingWeightsCS : public FGlobalShader
+{
+public:
 	DECLARE_GLOBAL_SHADER(FSMAABlendingWeightsCS);
 	SHADER_USE_PARAMETER_STRUCT(FSMAABlendingWeightsCS, FGlobalShader);
 
 	class FSMAAPresetConfigDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_PRESET", ESMAAPreset);
+	class FSMAAEdgeStatsDim : SHADER_PERMUTATION_BOOL("SMAA_EDGE_STATS");
+	class FSMAASearchALUDim : SHADER_PERMUTATION_BOOL("SMAA_SEARCH_ALU");
+	class FSMAATileMaskDim : SHADER_PERMUTATION_BOOL("SMAA_TILE_MASK");
+	class FSMAAGroupShapeDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_GROUP_SHAPE", ESMAAGroupShape);
+	class FSMAAGroupSwizzleDim : SHADER_PERMUTATION_BOOL("SMAA_GROUP_SWIZZLE");
+	class FSMAASharedRunsDim : SHADER_PERMUTATION_RANGE_INT("SMAA_SHARED_RUNS", 0, 3);
 
-	using FPermutationDomain = TShaderPermutationDomain<FSMAAPresetConfigDim>;
+	using FPermutationDomain = TShaderPermutationDomain<FSMAAPresetConfigDim, FSMAAEdgeStatsDim, FSMAASearchALUDim, FSMAATileMaskDim, FSMAAGroupShapeDim, FSMAAGroupSwizzleDim, FSMAASharedRunsDim>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_BUFFER_ACCESS(StaticIndirectArgs, ERHIAccess::IndirectArgs)
 	RDG_TEXTURE_ACCESS(DepthTexture, ERHIAccess::SRVCompute)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputEdges)
-	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, AreaTexture)
-	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SearchTexture)
 	SHADER_PARAMETER(FVector2f, TemporalJitterPixels)
-	// SHADER_PARAMETER_SRV(Texture2D, AreaTexture)
-	SHADER_PARAMETER_SAMPLER(SamplerState, PointTextureSampler)
-	SHADER_PARAMETER_SAMPLER(SamplerState, BilinearTextureSampler)
-	SHADER_PARAMETER(FVector4f, ViewportMetrics)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
 	SHADER_PARAMETER(FVector4f, SubpixelWeights)
-	SHADER_PARAMETER(float, NormalisedCornerRounding)
-	SHADER_PARAMETER(float, MaxDiagonalSearchSteps)
-	SHADER_PARAMETER(float, MaxSearchSteps)
 	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
 	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, BlendTexture)
+	SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, EdgeStats)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint>, TileMask)
+	SHADER_PARAMETER(FUintVector2, GroupCount)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
 	{
-		return true;
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+
+		// Validating shared runs counts its mismatches with the edge stats
+		if (PermutationVector.Get<FSMAASharedRunsDim>() == 2 && !PermutationVector.Get<FSMAAEdgeStatsDim>())
+		{
+			return false;
+		}
+
+		return ShouldCompileSMAAGroupShape(PermutationVector.Get<FSMAAGroupShapeDim>(), PermutationVector.Get<FSMAAGroupSwizzleDim>());
 	}
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
 		FShaderCompilerEnvironment& OutEnvironment)
 	{
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), ThreadgroupSizeX);
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), ThreadgroupSizeY);
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), ThreadgroupSizeZ);
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		ModifySMAAGroupShapeEnvironment(PermutationVector.Get<FSMAAGroupShapeDim>(), OutEnvironment);
 		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
 		OutEnvironment.SetDefine(TEXT("ENGINE_MAJOR_VERSION"), ENGINE_MAJOR_VERSION);
 		OutEnvironment.SetDefine(TEXT("ENGINE_MINOR_VERSION"), ENGINE_MINOR_VERSION);
+
+		if (PermutationVector.Get<FSMAAEdgeStatsDim>() && FDataDrivenShaderPlatformInfo::GetSupportsWaveOperations(Parameters.Platform) == ERHIFeatureSupport::RuntimeGuaranteed)
+		{
+			OutEnvironment.CompilerFlags.Add(CFLAG_WaveOperations);
+		}
 	}
 };
 IMPLEMENT_GLOBAL_SHADER(FSMAABlendingWeightsCS, "/SMAAPlugin/Private/SMAA_BlendWeighting.usf",
 	"BlendWeightingCS", SF_Compute);
 
+// Where the last compute pass writes: its own texture, the post process chain's override output, or both when T2x also
+// needs its result as history. SMAA_OUTPUT_TARGET in the shaders
+enum class ESMAAOutputTarget : uint8
+{
+	Own,
+	Override,
+	Both,
+
+	MAX
+};
+
 /**
  * SMAA Neighbour Blending
  */
 class FSMAANeighbourhoodBlendingCS : public FGlobalShader
 {
 public:
-	static const int ThreadgroupSizeX = 8;
-	static const int ThreadgroupSizeY = 8;
-	static const int ThreadgroupSizeZ = 1;
-
 	DECLARE_GLOBAL_SHADER(FSMAANeighbourhoodBlendingCS);
 	SHADER_USE_PARAMETER_STRUCT(FSMAANeighbourhoodBlendingCS, FGlobalShader);
 
 	class FSMAAPresetConfigDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_PRESET", ESMAAPreset);
 	class FSMAAReprojectionDim : SHADER_PERMUTATION_BOOL("SMAA_REPROJECTION");
+	class FSMAATileMaskDim : SHADER_PERMUTATION_BOOL("SMAA_TILE_MASK");
+	class FSMAAGroupShapeDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_GROUP_SHAPE", ESMAAGroupShape);
+	class FSMAAGroupSwizzleDim : SHADER_PERMUTATION_BOOL("SMAA_GROUP_SWIZZLE");
+	class FSMAAOutputTargetDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_OUTPUT_TARGET", ESMAAOutputTarget);
 
 	using FPermutationDomain =
-		TShaderPermutationDomain<FSMAAPresetConfigDim, FSMAAReprojectionDim>;
+		TShaderPermutationDomain<FSMAAPresetConfigDim, FSMAAReprojectionDim, FSMAATileMaskDim, FSMAAGroupShapeDim, FSMAAGroupSwizzleDim, FSMAAOutputTargetDim>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_BUFFER_ACCESS(StaticIndirectArgs, ERHIAccess::IndirectArgs)
 	RDG_TEXTURE_ACCESS(DepthTexture, ERHIAccess::SRVCompute)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneColour)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, VelocityTexture)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputBlend)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneDepth)
-	SHADER_PARAMETER_SAMPLER(SamplerState, PointTextureSampler)
-	SHADER_PARAMETER_SAMPLER(SamplerState, BilinearTextureSampler)
-	SHADER_PARAMETER(FVector4f, ViewportMetrics)
-	SHADER_PARAMETER(float, NormalisedCornerRounding)
-	SHADER_PARAMETER(float, MaxDiagonalSearchSteps)
-	SHADER_PARAMETER(float, MaxSearchSteps)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
 	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
 	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, FinalFrame)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, OverrideOutput)
+	SHADER_PARAMETER(FIntPoint, OverrideOutputOffset)
+	SHADER_PARAMETER(FIntVector4, OutputRect)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint>, TileMask)
+	SHADER_PARAMETER(FUintVector2, GroupCount)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
 	{
-		return true;
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		return ShouldCompileSMAAGroupShape(PermutationVector.Get<FSMAAGroupShapeDim>(), PermutationVector.Get<FSMAAGroupSwizzleDim>());
 	}
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
 		FShaderCompilerEnvironment& OutEnvironment)
 	{
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), ThreadgroupSizeX);
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), ThreadgroupSizeY);
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), ThreadgroupSizeZ);
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		ModifySMAAGroupShapeEnvironment(PermutationVector.Get<FSMAAGroupShapeDim>(), OutEnvironment);
 		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
 		OutEnvironment.SetDefine(TEXT("ENGINE_MAJOR_VERSION"), ENGINE_MAJOR_VERSION);
 		OutEnvironment.SetDefine(TEXT("ENGINE_MINOR_VERSION"), ENGINE_MINOR_VERSION);
@@ -267,49 +613,59 @@ IMPLEMENT_GLOBAL_SHADER(FSMAANeighbourhoodBlendingCS, "/SMAAPlugin/Private/SMAA_
 class FSMAATemporalResolveCS : public FGlobalShader
 {
 public:
-	static const int ThreadgroupSizeX = 8;
-	static const int ThreadgroupSizeY = 8;
-	static const int ThreadgroupSizeZ = 1;
-
 	DECLARE_GLOBAL_SHADER(FSMAATemporalResolveCS);
 	SHADER_USE_PARAMETER_STRUCT(FSMAATemporalResolveCS, FGlobalShader);
 
 	class FSMAAPresetConfigDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_PRESET", ESMAAPreset);
 	class FSMAAReprojectionDim : SHADER_PERMUTATION_BOOL("SMAA_REPROJECTION");
+	class FSMAATileMaskDim : SHADER_PERMUTATION_BOOL("SMAA_TILE_MASK");
+	class FSMAAGroupShapeDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_GROUP_SHAPE", ESMAAGroupShape);
+	class FSMAAGroupSwizzleDim : SHADER_PERMUTATION_BOOL("SMAA_GROUP_SWIZZLE");
+	class FSMAAOutputTargetDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_OUTPUT_TARGET", ESMAAOutputTarget);
 
 	using FPermutationDomain =
-		TShaderPermutationDomain<FSMAAPresetConfigDim, FSMAAReprojectionDim>;
+		TShaderPermutationDomain<FSMAAPresetConfigDim, FSMAAReprojectionDim, FSMAATileMaskDim, FSMAAGroupShapeDim, FSMAAGroupSwizzleDim, FSMAAOutputTargetDim>;
 
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_BUFFER_ACCESS(StaticIndirectArgs, ERHIAccess::IndirectArgs)
 	RDG_TEXTURE_ACCESS(DepthTexture, ERHIAccess::SRVCompute)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, CurrentSceneColour)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, PastSceneColour)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneDepth)
 	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, VelocityTexture)
 
-	SHADER_PARAMETER_SAMPLER(SamplerState, PointTextureSampler)
-	SHADER_PARAMETER_SAMPLER(SamplerState, BilinearTextureSampler)
-	SHADER_PARAMETER(FVector4f, ViewportMetrics)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
 	SHADER_PARAMETER(FVector4f, LimitedViewportSize)
-	SHADER_PARAMETER(float, NormalisedCornerRounding)
-	SHADER_PARAMETER(float, MaxDiagonalSearchSteps)
-	SHADER_PARAMETER(float, MaxSearchSteps)
 	SHADER_PARAMETER(float, ReprojectionWeight)
 	SHADER_PARAMETER(float, TemporalHistoryBias)
+	SHADER_PARAMETER(FVector4f, HistoryUVScaleBias)
+	SHADER_PARAMETER(FVector4f, HistoryUVMinMax)
 	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
 	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, Resolved)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, OverrideOutput)
+	SHADER_PARAMETER(FIntPoint, OverrideOutputOffset)
+	SHADER_PARAMETER(FIntVector4, OutputRect)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint>, TileMask)
+	SHADER_PARAMETER(FUintVector2, GroupCount)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
 	{
-		return true;
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+
+		// The resolve's output is always next frame's history
+		if (PermutationVector.Get<FSMAAOutputTargetDim>() == ESMAAOutputTarget::Override)
+		{
+			return false;
+		}
+
+		return ShouldCompileSMAAGroupShape(PermutationVector.Get<FSMAAGroupShapeDim>(), PermutationVector.Get<FSMAAGroupSwizzleDim>());
 	}
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
 		FShaderCompilerEnvironment& OutEnvironment)
 	{
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), ThreadgroupSizeX);
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), ThreadgroupSizeY);
-		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), ThreadgroupSizeZ);
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		ModifySMAAGroupShapeEnvironment(PermutationVector.Get<FSMAAGroupShapeDim>(), OutEnvironment);
 		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
 		OutEnvironment.SetDefine(TEXT("ENGINE_MAJOR_VERSION"), ENGINE_MAJOR_VERSION);
 		OutEnvironment.SetDefine(TEXT("ENGINE_MINOR_VERSION"), ENGINE_MINOR_VERSION);
@@ -318,155 +674,1294 @@ public:
 
 IMPLEMENT_GLOBAL_SHADER(FSMAATemporalResolveCS, "/SMAAPlugin/Private/SMAA_T2XResolve.usf", "TemporalResolveCS", SF_Compute);
 
-ESMAAPreset GetSMAAPreset()
+/**
+ * SMAA Static Frame Reuse
+ */
+class FSMAAStaticReuseCS : public FGlobalShader
 {
-	return ESMAAPreset(FMath::Clamp(CVarSMAAQuality.GetValueOnRenderThread(), 0, 3));
-}
+public:
+	static const int ThreadgroupSizeX = 8;
+	static const int ThreadgroupSizeY = 8;
+	static const int ThreadgroupSizeZ = 1;
 
-ESMAAEdgeDetectors GetSMAAEdgeDetectors()
-{
-	return ESMAAEdgeDetectors(FMath::Clamp(CVarSMAAEdgeMode.GetValueOnRenderThread(), 0, 3));
-}
+	DECLARE_GLOBAL_SHADER(FSMAAStaticReuseCS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAAStaticReuseCS, FGlobalShader);
 
-ESMAAPredicationTexture GetPredicateSource()
-{
-	return ESMAAPredicationTexture(FMath::Clamp(CVarSMAAPredicationSource.GetValueOnRenderThread(), 0, 3));
-}
+	class FSMAAOutputTargetDim : SHADER_PERMUTATION_ENUM_CLASS("SMAA_OUTPUT_TARGET", ESMAAOutputTarget);
 
-uint8 GetSMAAMaxSearchSteps()
-{
-	return FMath::Clamp(CVarSMAAMaxSearchSteps.GetValueOnRenderThread(), 0, 112);
-}
+	using FPermutationDomain = TShaderPermutationDomain<FSMAAOutputTargetDim>;
 
-uint8 GetSMAAMaxDiagonalSearchSteps()
-{
-	return FMath::Clamp(CVarSMAAMaxDiagonalSearchSteps.GetValueOnRenderThread(), 0, 20);
-}
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_BUFFER_ACCESS(StaticIndirectArgs, ERHIAccess::IndirectArgs)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, PastSceneColour)
+	SHADER_PARAMETER(FIntPoint, HistoryOffset)
+	SHADER_PARAMETER(FIntVector4, OutputRect)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, FinalFrame)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, OverrideOutput)
+	SHADER_PARAMETER(FIntPoint, OverrideOutputOffset)
+	END_SHADER_PARAMETER_STRUCT()
 
-uint8 GetSMAACornerRounding()
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return true;
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), ThreadgroupSizeX);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), ThreadgroupSizeY);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), ThreadgroupSizeZ);
+		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAAStaticReuseCS, "/SMAAPlugin/Private/SMAA_StaticFrame.usf", "StaticReuseCS", SF_Compute);
+
+template<typename DomainType>
+struct TSMAAPermutationDescriber;
+
+template<typename... DimTypes>
+struct TSMAAPermutationDescriber<TShaderPermutationDomain<DimTypes...>>
 {
-	return FMath::Clamp(CVarSMAACornerRounding.GetValueOnRenderThread(), 0, 100);
-}
+	static FString Describe(int32 PermutationId)
+	{
+		const TShaderPermutationDomain<DimTypes...> PermutationVector(PermutationId);
 
-float GetSMAAAdaptationFactor()
+		FString Description;
+		((Description += FString::Printf(TEXT("%s%s=%d"), Description.IsEmpty() ? TEXT("") : TEXT(" "), DimTypes::DefineName,
+			DimTypes::ToDefineValue(PermutationVector.template Get<DimTypes>()))), ...);
+		return Description;
+	}
+};
+
+TArray<const FGlobalShaderType*> GetSMAAPassShaderTypes()
 {
-	return FMath::Clamp(CVarSMAAAdaptationFactor.GetValueOnRenderThread(), 0.f, 10.f);
+	return {
+		&FSMAAEdgeDetectionCS::GetStaticType(),
+		&FSMAABlendingWeightsCS::GetStaticType(),
+		&FSMAANeighbourhoodBlendingCS::GetStaticType(),
+		&FSMAATemporalResolveCS::GetStaticType()
+	};
 }
 
-float GetSMAAReprojectionWeight()
+FString DescribeSMAAShaderPermutation(const FGlobalShaderType* ShaderType, int32 PermutationId)
 {
-	return FMath::Clamp(CVarSMAAReprojectionWeight.GetValueOnRenderThread(), 0.f, 100.f);
+	if (ShaderType == &FSMAAEdgeDetectionCS::GetStaticType())
+	{
+		return TSMAAPermutationDescriber<FSMAAEdgeDetectionCS::FPermutationDomain>::Describe(PermutationId);
+	}
+	if (ShaderType == &FSMAABlendingWeightsCS::GetStaticType())
+	{
+		return TSMAAPermutationDescriber<FSMAABlendingWeightsCS::FPermutationDomain>::Describe(PermutationId);
+	}
+	if (ShaderType == &FSMAANeighbourhoodBlendingCS::GetStaticType())
+	{
+		return TSMAAPermutationDescriber<FSMAANeighbourhoodBlendingCS::FPermutationDomain>::Describe(PermutationId);
+	}
+	if (ShaderType == &FSMAATemporalResolveCS::GetStaticType())
+	{
+		return TSMAAPermutationDescriber<FSMAATemporalResolveCS::FPermutationDomain>::Describe(PermutationId);
+	}
+	return FString::Printf(TEXT("%d"), PermutationId);
+}
+
+///// ///// ////////// ///// /////
+// SMAA Raster Shaders
+//
+// Pixel shader versions of the edge detection, blend weight and neighbourhood blending passes, for GPUs where
+// raster is faster than compute. Edge detection marks edge pixels in stencil, so the hardware rejects every other
+// pixel before the blend weight shader runs.
+//
+
+static void ModifySMAARasterCompilationEnvironment(FShaderCompilerEnvironment& OutEnvironment)
+{
+	OutEnvironment.SetDefine(TEXT("ENGINE_MAJOR_VERSION"), ENGINE_MAJOR_VERSION);
+	OutEnvironment.SetDefine(TEXT("ENGINE_MINOR_VERSION"), ENGINE_MINOR_VERSION);
+}
+
+/**
+ * SMAA Edge Detection, raster
+ */
+class FSMAAEdgeDetectionPS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSMAAEdgeDetectionPS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAAEdgeDetectionPS, FGlobalShader);
+
+	using FPermutationDomain = TShaderPermutationDomain<
+		FSMAAEdgeDetectionCS::FSMAAPresetConfigDim,
+		FSMAAEdgeDetectionCS::FSMAAEdgeModeConfigDim,
+		FSMAAEdgeDetectionCS::FSMAAPredicateConfigDim,
+		FSMAAEdgeDetectionCS::FSMAAPackedInputDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_TEXTURE_ACCESS(DepthTexture, ERHIAccess::SRVGraphics)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputDepth)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputSceneColor)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, Predicate)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, PackedEdgeInput)
+	SHADER_PARAMETER(float, AdaptationFactor)
+	SHADER_PARAMETER(float, PredicationThreshold)
+	SHADER_PARAMETER(float, PredicationScale)
+	SHADER_PARAMETER(float, PredicationStrength)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
+	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+	RENDER_TARGET_BINDING_SLOTS()
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+
+		// The packed input only carries luma
+		return !PermutationVector.Get<FSMAAEdgeDetectionCS::FSMAAPackedInputDim>()
+			|| PermutationVector.Get<FSMAAEdgeDetectionCS::FSMAAEdgeModeConfigDim>() == ESMAAEdgeDetectors::Luminance;
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		ModifySMAARasterCompilationEnvironment(OutEnvironment);
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAAEdgeDetectionPS, "/SMAAPlugin/Private/SMAA_EdgeDetection.usf", "EdgeDetectionPS", SF_Pixel);
+
+/**
+ * SMAA Blending Weight Calculation, raster
+ */
+class FSMAABlendingWeightsPS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSMAABlendingWeightsPS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAABlendingWeightsPS, FGlobalShader);
+
+	using FPermutationDomain = TShaderPermutationDomain<FSMAABlendingWeightsCS::FSMAAPresetConfigDim, FSMAABlendingWeightsCS::FSMAASearchALUDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_TEXTURE_ACCESS(DepthTexture, ERHIAccess::SRVGraphics)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputEdges)
+	SHADER_PARAMETER(FVector2f, TemporalJitterPixels)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
+	SHADER_PARAMETER(FVector4f, SubpixelWeights)
+	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+	RENDER_TARGET_BINDING_SLOTS()
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return true;
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		ModifySMAARasterCompilationEnvironment(OutEnvironment);
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAABlendingWeightsPS, "/SMAAPlugin/Private/SMAA_BlendWeighting.usf", "BlendWeightingPS", SF_Pixel);
+
+/**
+ * SMAA Neighbourhood Blending, raster
+ */
+class FSMAANeighbourhoodBlendingPS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSMAANeighbourhoodBlendingPS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAANeighbourhoodBlendingPS, FGlobalShader);
+
+	using FPermutationDomain = TShaderPermutationDomain<
+		FSMAANeighbourhoodBlendingCS::FSMAAPresetConfigDim,
+		FSMAANeighbourhoodBlendingCS::FSMAAReprojectionDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	RDG_TEXTURE_ACCESS(DepthTexture, ERHIAccess::SRVGraphics)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneColour)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, VelocityTexture)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputBlend)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneDepth)
+	SHADER_PARAMETER_RDG_UNIFORM_BUFFER(FSMAAUniformParameters, SMAA)
+	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+	SHADER_PARAMETER(FIntPoint, OutputOffset)
+	RENDER_TARGET_BINDING_SLOTS()
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return true;
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		ModifySMAARasterCompilationEnvironment(OutEnvironment);
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAANeighbourhoodBlendingPS, "/SMAAPlugin/Private/SMAA_NeighbourhoodBlend.usf", "NeighbourhoodBlendingPS", SF_Pixel);
+
+ESMAAPreset GetSMAAPreset()
+{
+	return ESMAAPreset(FMath::Clamp(CVarSMAAQuality.GetValueOnRenderThread(), 0, int32(ESMAAPreset::Custom)));
+}
+
+bool GetSMAATemporal()
+{
+	return CVarSMAAMode.GetValueOnRenderThread() != 0;
+}
+
+ESMAAEdgeDetectors GetSMAAEdgeDetectors()
+{
+	return ESMAAEdgeDetectors(FMath::Clamp(CVarSMAAEdgeMode.GetValueOnRenderThread(), 0, 3));
+}
+
+ESMAAPredicationTexture GetPredicateSource()
+{
+	return ESMAAPredicationTexture(FMath::Clamp(CVarSMAAPredicationSource.GetValueOnRenderThread(), 0, 3));
+}
+
+uint8 GetSMAAMaxSearchSteps()
+{
+	return FMath::Clamp(CVarSMAAMaxSearchSteps.GetValueOnRenderThread(), 0, 112);
+}
+
+uint8 GetSMAAMaxDiagonalSearchSteps()
+{
+	return FMath::Clamp(CVarSMAAMaxDiagonalSearchSteps.GetValueOnRenderThread(), 0, 20);
+}
+
+uint8 GetSMAACornerRounding()
+{
+	return FMath::Clamp(CVarSMAACornerRounding.GetValueOnRenderThread(), 0, 100);
+}
+
+float GetSMAAAdaptationFactor()
+{
+	return FMath::Clamp(CVarSMAAAdaptationFactor.GetValueOnRenderThread(), 0.f, 10.f);
+}
+
+float GetSMAAReprojectionWeight()
+{
+	return FMath::Clamp(CVarSMAAReprojectionWeight.GetValueOnRenderThread(), 0.f, 100.f);
+}
+
+float GetSMAAPredicationThreshold()
+{
+	return FMath::Clamp(CVarSMAAPredicationThreshold.GetValueOnRenderThread(), 0.f, 1.f);
+}
+
+float GetSMAAPredicationScale()
+{
+	return FMath::Clamp(CVarSMAAPredicationScale.GetValueOnRenderThread(), 1.f, 5.f);
+}
+
+float GetSMAAPredicationStrength()
+{
+	return FMath::Clamp(CVarSMAAPredicationStrength.GetValueOnRenderThread(), 0.f, 1.f);
+}
+
+float GetSMAATemporalHistoryBias()
+{
+	return FMath::Clamp(CVarSMAATemporalHistoryBias.GetValueOnRenderThread(), 0.f, (1.f - SMALL_NUMBER));
+}
+
+bool GetSMAAPackedEdgeInput()
+{
+	return CVarSMAAPackedEdgeInput.GetValueOnRenderThread() != 0;
+}
+
+uint8 GetSMAARasterPath()
+{
+	return FMath::Clamp(CVarSMAARasterPath.GetValueOnRenderThread(), 0, 2);
+}
+
+FIntPoint GetSMAATileOverlap()
+{
+	// Negative asks for the search apron, which needs the view's preset and is resolved per view
+	return FIntPoint(FMath::Max(CVarSMAATileOverlap.GetValueOnRenderThread(), -1));
+}
+
+bool GetSMAASearchALU()
+{
+	return CVarSMAASearchALU.GetValueOnRenderThread() != 0;
+}
+
+uint8 GetSMAASharedRuns()
+{
+	return FMath::Clamp(CVarSMAASharedRuns.GetValueOnRenderThread(), 0, 2);
+}
+
+bool GetSMAAEdgeTileCulling()
+{
+	return CVarSMAAEdgeTileCulling.GetValueOnRenderThread() != 0;
+}
+
+float GetSMAAHistoryHeadroom()
+{
+	return FMath::Clamp(CVarSMAAHistoryHeadroom.GetValueOnRenderThread(), 1.f, 2.f);
+}
+
+uint8 GetSMAASkipStencil()
+{
+	return static_cast<uint8>(FMath::Clamp(CVarSMAASkipStencil.GetValueOnRenderThread(), 0, 255));
+}
+
+uint8 GetSMAAStaticReuse()
+{
+	return static_cast<uint8>(FMath::Clamp(CVarSMAAStaticReuse.GetValueOnRenderThread(), 0, 2));
+}
+
+FIntPoint GetSMAAGroupSize(ESMAAGroupShape Shape)
+{
+	switch (Shape)
+	{
+	case ESMAAGroupShape::Group16x16:
+		return FIntPoint(16, 16);
+	case ESMAAGroupShape::Group32x2:
+		return FIntPoint(32, 2);
+	case ESMAAGroupShape::Group8x4:
+		return FIntPoint(8, 4);
+	case ESMAAGroupShape::Group8x8:
+	default:
+		return FIntPoint(8, 8);
+	}
+}
+
+const TCHAR* GetSMAAGroupShapeName(ESMAAGroupShape Shape)
+{
+	static const TCHAR* Names[] = { TEXT("8x8"), TEXT("16x16"), TEXT("32x2"), TEXT("8x4") };
+	static_assert(UE_ARRAY_COUNT(Names) == uint32(ESMAAGroupShape::MAX), "Missing group shape name");
+	return Names[FMath::Min(uint32(Shape), uint32(ESMAAGroupShape::MAX) - 1)];
+}
+
+const TCHAR* GetSMAAComputePassName(ESMAAComputePass Pass)
+{
+	static const TCHAR* Names[] = { TEXT("EdgeDetection"), TEXT("BlendWeights"), TEXT("NeighbourhoodBlending"), TEXT("TemporalResolve") };
+	static_assert(UE_ARRAY_COUNT(Names) == uint32(ESMAAComputePass::MAX), "Missing compute pass name");
+	return Names[FMath::Min(uint32(Pass), uint32(ESMAAComputePass::MAX) - 1)];
+}
+
+bool AreSMAAGroupShapesCompiled()
+{
+	return CVarSMAACompileGroupShapes.GetValueOnAnyThread() != 0;
+}
+
+FSMAAGroupConfig GetSMAAGroupConfig(ESMAAComputePass Pass)
+{
+	FSMAAGroupConfig Config;
+	if (!AreSMAAGroupShapesCompiled())
+	{
+		return Config;
+	}
+
+	const TAutoConsoleVariable<int32>* ShapeCVars[] = {
+		&CVarSMAAGroupShapeEdgeDetection,
+		&CVarSMAAGroupShapeBlendWeights,
+		&CVarSMAAGroupShapeBlending,
+		&CVarSMAAGroupShapeResolve
+	};
+	static_assert(UE_ARRAY_COUNT(ShapeCVars) == uint32(ESMAAComputePass::MAX), "Missing group shape cvar");
+
+	const int32 Shape = (*ShapeCVars[uint32(Pass)]).GetValueOnRenderThread();
+	Config.Shape = static_cast<ESMAAGroupShape>(FMath::Clamp(Shape, 0, int32(ESMAAGroupShape::MAX) - 1));
+	Config.bSwizzle = (CVarSMAAGroupSwizzle.GetValueOnRenderThread() & (1 << uint32(Pass))) != 0;
+	return Config;
+}
+
+int32 GetSMAASearchApron(ESMAAPreset Quality, int32 MaxSearchSteps, int32 MaxDiagonalSearchSteps)
+{
+	// Orthogonal searches take two pixels per step, plus the crossing edge and corner fetches around their ends
+	const int32 SearchPixels = 2 * MaxSearchSteps + 4;
+
+	// Diagonal searches take one pixel per step, plus the crossing edge fetches. Low and Medium don't run them
+	const bool bDiagonal = Quality != ESMAAPreset::Low && Quality != ESMAAPreset::Medium;
+	const int32 DiagonalPixels = bDiagonal ? MaxDiagonalSearchSteps + 3 : 0;
+
+	// Edge detection reads two pixels up and one down, and neighbourhood blending reads the weights one pixel down
+	return FMath::Max(SearchPixels, DiagonalPixels) + 2;
+}
+
+bool GetSMAAPresetSearchSettings(ESMAAPreset Quality, uint8& OutMaxSearchSteps, uint8& OutMaxDiagonalSearchSteps, uint8& OutCornerRounding)
+{
+	// Must match the presets in SMAAReference.usf. Low and Medium disable diagonal and corner detection
+	switch (Quality)
+	{
+	case ESMAAPreset::Low:
+		OutMaxSearchSteps = 4;
+		OutMaxDiagonalSearchSteps = 0;
+		OutCornerRounding = 0;
+		return true;
+	case ESMAAPreset::Medium:
+		OutMaxSearchSteps = 8;
+		OutMaxDiagonalSearchSteps = 0;
+		OutCornerRounding = 0;
+		return true;
+	case ESMAAPreset::High:
+		OutMaxSearchSteps = 16;
+		OutMaxDiagonalSearchSteps = 8;
+		OutCornerRounding = 25;
+		return true;
+	case ESMAAPreset::Ultra:
+		OutMaxSearchSteps = 32;
+		OutMaxDiagonalSearchSteps = 16;
+		OutCornerRounding = 25;
+		return true;
+	default:
+		return false;
+	}
+}
+
+FSMAAInputs GetSMAAInputsFromCVars()
+{
+	FSMAAInputs Inputs;
+	Inputs.Quality = GetSMAAPreset();
+	Inputs.bTemporal = GetSMAATemporal();
+	Inputs.EdgeMode = GetSMAAEdgeDetectors();
+	Inputs.PredicationSource = GetPredicateSource();
+	Inputs.MaxSearchSteps = GetSMAAMaxSearchSteps();
+	Inputs.MaxDiagonalSearchSteps = GetSMAAMaxDiagonalSearchSteps();
+	Inputs.CornerRounding = GetSMAACornerRounding();
+	Inputs.AdaptationFactor = GetSMAAAdaptationFactor();
+	Inputs.ReprojectionWeight = GetSMAAReprojectionWeight();
+	Inputs.PredicationThreshold = GetSMAAPredicationThreshold();
+	Inputs.PredicationScale = GetSMAAPredicationScale();
+	Inputs.PredicationStrength = GetSMAAPredicationStrength();
+	Inputs.TemporalHistoryBias = GetSMAATemporalHistoryBias();
+	Inputs.bPackedEdgeInput = GetSMAAPackedEdgeInput();
+	Inputs.TileOverlap = GetSMAATileOverlap();
+	Inputs.RasterPath = GetSMAARasterPath();
+	Inputs.bSearchALU = GetSMAASearchALU();
+	Inputs.SharedRuns = GetSMAASharedRuns();
+	Inputs.bEdgeTileCulling = GetSMAAEdgeTileCulling();
+	Inputs.HistoryHeadroom = GetSMAAHistoryHeadroom();
+	Inputs.SkipStencil = GetSMAASkipStencil();
+	Inputs.StaticReuse = GetSMAAStaticReuse();
+	for (uint32 Pass = 0; Pass < uint32(ESMAAComputePass::MAX); ++Pass)
+	{
+		Inputs.GroupConfigs[Pass] = GetSMAAGroupConfig(ESMAAComputePass(Pass));
+	}
+	return Inputs;
+}
+
+//// FlipNames
+//TCHAR* FlipNames[2] = {
+//	TEXT("SMAA0"),
+//	TEXT("SMAA1")
+//};
+
+FVector4f SubpixelJitterWeights[2] = {
+	FVector4f(1, 1, 1, 0),
+	FVector4f(2, 2, 2, 0)
+};
+
+// Extent for this frame's output, which becomes the next frame's history. Keeps the history's extent while the
+// backing texture fits in it and hasn't shrunk by more than the headroom, otherwise grows it with headroom to spare
+static FIntPoint GetSMAAHistoryExtent(FIntPoint BackingSize, const FSMAAHistory& History, float Headroom)
+{
+	if (History.IsValid())
+	{
+		const FIntPoint HistoryExtent = History.ReferenceBufferSize;
+		const bool bFits = HistoryExtent.X >= BackingSize.X && HistoryExtent.Y >= BackingSize.Y;
+		const bool bWasteful = HistoryExtent.X > FMath::CeilToInt(BackingSize.X * Headroom * Headroom)
+			|| HistoryExtent.Y > FMath::CeilToInt(BackingSize.Y * Headroom * Headroom);
+
+		if (bFits && !bWasteful)
+		{
+			return HistoryExtent;
+		}
+	}
+
+	// Round up so extents that differ by a few pixels share pooled targets
+	const FIntPoint Grown(FMath::CeilToInt(BackingSize.X * Headroom), FMath::CeilToInt(BackingSize.Y * Headroom));
+	return FIntPoint::DivideAndRoundUp(Grown, 8) * 8;
 }
 
-float GetSMAAPredicationThreshold()
-{
-	return FMath::Clamp(CVarSMAAPredicationThreshold.GetValueOnRenderThread(), 0.f, 1.f);
-}
+///// ///// ////////// ///// /////
+// SMAA Pass Builder
+//
+
+/**
+ * Sets up the resources shared by all SMAA passes of a view once (backing size, scene texture SRVs,
+ * predicate, lookup textures and the SMAA uniform buffer), and adds the individual passes on top.
+ * Used by both the regular and the visualisation paths.
+ */
+class FSMAAPassBuilder
+{
+public:
+	FSMAAPassBuilder(FRDGBuilder& InGraphBuilder, const FViewInfo& InView, const FSMAAInputs& InInputs, const FPostProcessMaterialInputs& InOutInputs)
+		: GraphBuilder(InGraphBuilder)
+		, View(InView)
+		, Inputs(InInputs)
+		, PostProcessInputs(InOutInputs)
+	{
+	}
+
+	// Returns false if the lookup textures aren't available yet, in which case no passes can be added
+	bool Init(const FSMAAViewData& ViewData)
+	{
+		if (!ViewData.SMAAAreaTextureRT.IsValid() || (!Inputs.bSearchALU && !ViewData.SMAASearchTextureRT.IsValid()))
+		{
+			return false;
+		}
+
+		FIntPoint InputExtents = Inputs.SceneColor.Texture->Desc.Extent; // View.ViewRect.Size();
+		BackingSize = InputExtents;
+		QuantizeSceneBufferSize(InputExtents, BackingSize);
+
+		const FSceneTextureUniformParameters* SceneTextures = PostProcessInputs.SceneTextures.SceneTextures->GetContents();
+
+		SceneDepth = SceneTextures->SceneDepthTexture;
+		DepthSRV = GraphBuilder.CreateSRV(SceneTextures->SceneDepthTexture);
+		ColourSRV = GraphBuilder.CreateSRV(Inputs.SceneColor.Texture);
+		// SMAA 1x never reads velocity, and the view may not have rendered any
+		VelocitySRV = Inputs.bTemporal && Inputs.SceneVelocity.IsValid()
+			? GraphBuilder.CreateSRV(Inputs.SceneVelocity.Texture)
+			: GraphBuilder.CreateSRV(GSystemTextures.GetBlackDummy(GraphBuilder));
+
+		// Wanted Predicate Texture
+		bPredicate = ESMAAPredicationTexture::None != Inputs.PredicationSource;
+		switch (Inputs.PredicationSource)
+		{
+			case ESMAAPredicationTexture::Depth:
+				PredicateSRV = DepthSRV;
+				break;
+			case ESMAAPredicationTexture::WorldNormal:
+				PredicateSRV = GraphBuilder.CreateSRV(SceneTextures->GBufferATexture);
+				break;
+			case ESMAAPredicationTexture::MRS:
+				PredicateSRV = GraphBuilder.CreateSRV(SceneTextures->GBufferBTexture);
+				break;
+			case ESMAAPredicationTexture::None:;
+			case ESMAAPredicationTexture::MAX:;
+			default:
+				PredicateSRV = GraphBuilder.CreateSRV(GSystemTextures.GetWhiteDummy(GraphBuilder));
+				bPredicate = false;
+		}
+
+		// The lookup textures are pooled, so registering them again for further views is only a lookup
+		FSMAAUniformParameters* UniformParameters = GraphBuilder.AllocParameters<FSMAAUniformParameters>();
+		UniformParameters->ViewportMetrics = FVector4f(1.0 / BackingSize.X, 1.0 / BackingSize.Y, BackingSize.X, BackingSize.Y);
+		UniformParameters->NormalisedCornerRounding = Inputs.CornerRounding * 0.01f;
+		UniformParameters->MaxSearchSteps = Inputs.MaxSearchSteps;
+		UniformParameters->MaxDiagonalSearchSteps = Inputs.MaxDiagonalSearchSteps;
+		UniformParameters->AreaTexture = GraphBuilder.RegisterExternalTexture(ViewData.SMAAAreaTextureRT);
+		UniformParameters->SearchTexture = Inputs.bSearchALU
+			? GSystemTextures.GetBlackDummy(GraphBuilder)
+			: GraphBuilder.RegisterExternalTexture(ViewData.SMAASearchTextureRT);
+		UniformParameters->PointTextureSampler = TStaticSamplerState<SF_Point, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		UniformParameters->BilinearTextureSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		UniformBuffer = GraphBuilder.CreateUniformBuffer(UniformParameters);
+
+		bRaster = Inputs.RasterPath == 1 || (Inputs.RasterPath == 2 && IsMobilePlatform(View.GetShaderPlatform()));
+
+		// Tiled renders only write the interior, the overlap is context for the searches
+		OutputRect = FIntRect(FIntPoint::ZeroValue, BackingSize);
+		if (IsTiled())
+		{
+			OutputRect = View.ViewRect;
+			OutputRect.Min += Inputs.TileOverlap;
+			OutputRect.Max -= Inputs.TileOverlap;
+			OutputRect.Max = OutputRect.Max.ComponentMax(OutputRect.Min);
+		}
+
+		// Anything outside the view rect counts as masked too, so letterboxing and dynamic resolution skip it
+		SkipRects.Reset();
+		for (const FIntRect& Rect : Inputs.SkipRects)
+		{
+			const FIntRect BufferRect = Rect + View.ViewRect.Min;
+			if (SkipRects.Num() < FSMAAViewSettings::MaxSkipRects && BufferRect.Area() > 0)
+			{
+				SkipRects.Add(BufferRect);
+			}
+		}
+		bSkipTiles = !bRaster
+			&& (Inputs.SkipStencil != 0 || SkipRects.Num() > 0 || View.ViewRect != FIntRect(FIntPoint::ZeroValue, BackingSize));
+
+		return true;
+	}
+
+	FIntPoint GetBackingSize() const
+	{
+		return BackingSize;
+	}
+
+	bool IsTiled() const
+	{
+		return Inputs.TileOverlap.X > 0 || Inputs.TileOverlap.Y > 0;
+	}
+
+	// The raster passes don't collect edge statistics
+	bool IsRaster() const
+	{
+		return bRaster;
+	}
+
+	// Creates an intermediate the size of the scene colour backing texture
+	FRDGTextureRef CreateTexture(const TCHAR* Name)
+	{
+		return CreateTexture(Name, BackingSize);
+	}
+
+	// Creates an intermediate at least the size of the scene colour backing texture, e.g. a T2x history with headroom
+	FRDGTextureRef CreateTexture(const TCHAR* Name, FIntPoint Extent)
+	{
+		check(Extent.X >= BackingSize.X && Extent.Y >= BackingSize.Y);
+
+		FRDGTextureDesc TextureDesc =
+			FRDGTextureDesc::Create2D(Extent, PF_FloatRGBA, FClearValueBinding::Black,
+				TexCreate_ShaderResource | TexCreate_UAV | TexCreate_RenderTargetable);
+
+		return CreateTransientTexture(TextureDesc, Name);
+	}
+
+	// Platform size of every texture created through the builder and every buffer counted with it, see FSMAAViewMemory
+	uint64 GetTransientBytes() const
+	{
+		return TransientBytes;
+	}
+
+	// Counts a buffer the view's passes use that was created outside the builder
+	void CountBuffer(const FRDGBufferDesc& Desc)
+	{
+		TransientBytes += GetSMAABufferSizeBytes(Desc);
+	}
+
+	void AddEdgeDetection(FRDGTextureRef EdgesTexture, FRDGBufferUAVRef EdgeStats = nullptr)
+	{
+		// Luma and predicate packed into one texel for the luminance edge detector
+		const bool bPackedEdgeInput = Inputs.bPackedEdgeInput && Inputs.EdgeMode == ESMAAEdgeDetectors::Luminance;
+		FRDGTextureRef PackedEdgeInput = bPackedEdgeInput ? AddEdgeInputPrepass() : nullptr;
+
+		if (bRaster)
+		{
+			AddEdgeDetectionRaster(EdgesTexture, PackedEdgeInput);
+			return;
+		}
+
+		// Sky and flat surfaces can't produce depth or normal edges, and masked tiles aren't wanted. Find both before
+		// sampling per pixel
+		const bool bDepthCulling = Inputs.bEdgeTileCulling && SupportsSMAAEdgeTileCulling(Inputs.EdgeMode);
+		if (bDepthCulling || bSkipTiles)
+		{
+			TileMask = AddTileClassification(bDepthCulling);
+		}
+
+		const FSMAAGroupConfig& GroupConfig = Inputs.GroupConfigs[uint32(ESMAAComputePass::EdgeDetection)];
+
+		FSMAAEdgeDetectionCS::FPermutationDomain PermutationVector;
+
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPresetConfigDim>(Inputs.Quality);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAEdgeModeConfigDim>(Inputs.EdgeMode);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPredicateConfigDim>(bPredicate);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPackedInputDim>(bPackedEdgeInput);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAEdgeStatsDim>(EdgeStats != nullptr);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAATileMaskDim>(TileMask != nullptr);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAGroupShapeDim>(GroupConfig.Shape);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAGroupSwizzleDim>(GroupConfig.bSwizzle);
+
+		FSMAAEdgeDetectionCS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAAEdgeDetectionCS::FParameters>();
+
+		PassParameters->DepthTexture = SceneDepth;
+		SetEdgeDetectionParameters(PassParameters, PackedEdgeInput);
+		PassParameters->EdgesTexture = GraphBuilder.CreateUAV(EdgesTexture);
+		PassParameters->EdgeStats = EdgeStats;
+		PassParameters->TileMask = TileMask;
+
+		TShaderMapRef<FSMAAEdgeDetectionCS> ComputeShaderSMAAED(View.ShaderMap, PermutationVector);
+		AddComputePass(RDG_EVENT_NAME("SMAA/EdgeDetection (CS)"), ComputeShaderSMAAED, PassParameters,
+			ESMAAStaticPass::EdgeDetection, &PassParameters->GroupCount);
+	}
+
+	void AddBlendingWeights(FRDGTextureRef EdgesTexture, FRDGTextureRef BlendTexture, const FVector4f& SubpixelWeights, FRDGBufferUAVRef EdgeStats = nullptr)
+	{
+		if (bRaster)
+		{
+			AddBlendingWeightsRaster(EdgesTexture, BlendTexture, SubpixelWeights);
+			return;
+		}
+
+		const FSMAAGroupConfig& GroupConfig = Inputs.GroupConfigs[uint32(ESMAAComputePass::BlendWeights)];
+
+		FSMAABlendingWeightsCS::FPermutationDomain PermutationVector;
+
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAPresetConfigDim>(Inputs.Quality);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAEdgeStatsDim>(EdgeStats != nullptr);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAASearchALUDim>(Inputs.bSearchALU);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAATileMaskDim>(TileMask != nullptr);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAGroupShapeDim>(GroupConfig.Shape);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAGroupSwizzleDim>(GroupConfig.bSwizzle);
+		// Validation needs somewhere to count, so shared runs go unchecked when the caller collects no edge stats
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAASharedRunsDim>(Inputs.SharedRuns == 2 && !EdgeStats ? 1 : Inputs.SharedRuns);
+
+		FSMAABlendingWeightsCS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAABlendingWeightsCS::FParameters>();
+
+		PassParameters->DepthTexture = SceneDepth;
+		PassParameters->InputEdges = GraphBuilder.CreateSRV(EdgesTexture);
+		PassParameters->TemporalJitterPixels = FVector2f(View.TemporalJitterPixels);
+		PassParameters->SubpixelWeights = SubpixelWeights;
+		PassParameters->SMAA = UniformBuffer;
+		PassParameters->View = View.ViewUniformBuffer;
+		PassParameters->BlendTexture = GraphBuilder.CreateUAV(BlendTexture);
+		PassParameters->EdgeStats = EdgeStats;
+		PassParameters->TileMask = TileMask;
+
+		TShaderMapRef<FSMAABlendingWeightsCS> ComputeShaderSMAABW(View.ShaderMap, PermutationVector);
+		AddComputePass(RDG_EVENT_NAME("SMAA/BlendWeights (CS)"), ComputeShaderSMAABW, PassParameters,
+			ESMAAStaticPass::BlendWeights, &PassParameters->GroupCount);
+	}
+
+	/**
+	 * Whether the last pass can write the post process chain's override output itself, sparing the engine a copy into
+	 * it. Its view rect must be the size of ours, though it may sit anywhere in a texture of any size. Render targets
+	 * take any format; compute needs a typed UAV store of it, and UAVs can't be sRGB.
+	 */
+	bool CanWriteOverrideOutput(const FScreenPassRenderTarget& InOverrideOutput, bool bRasterPass) const
+	{
+		if (!InOverrideOutput.IsValid() || InOverrideOutput.ViewRect.Size() != View.ViewRect.Size())
+		{
+			return false;
+		}
+
+		const FRDGTextureDesc& Desc = InOverrideOutput.Texture->Desc;
+		if (bRasterPass)
+		{
+			return EnumHasAnyFlags(Desc.Flags, TexCreate_RenderTargetable);
+		}
+
+		return EnumHasAnyFlags(Desc.Flags, TexCreate_UAV)
+			&& !EnumHasAnyFlags(Desc.Flags, TexCreate_SRGB)
+			&& UE::PixelFormat::HasCapabilities(Desc.Format, EPixelFormatCapabilities::TypedUAVStore);
+	}
+
+	// The last pass also writes, or only writes, this. See CanWriteOverrideOutput
+	void SetOverrideOutput(const FScreenPassRenderTarget& InOverrideOutput)
+	{
+		OverrideOutput = InOverrideOutput;
+		OverrideOutputOffset = OverrideOutput.ViewRect.Min - View.ViewRect.Min;
+
+		// Outside the view rect is someone else's, e.g. another split screen view's
+		OutputRect.Clip(View.ViewRect);
+	}
+
+	// OutputTexture may be null when this is the last pass and only the override output is wanted
+	void AddNeighbourhoodBlending(FRDGTextureRef BlendTexture, FRDGTextureRef OutputTexture, bool bLastPass)
+	{
+		const ESMAAOutputTarget OutputTarget = GetOutputTarget(OutputTexture, bLastPass);
+
+		if (bRaster)
+		{
+			// A draw has the one viewport, so it writes either target but not both
+			check(OutputTarget != ESMAAOutputTarget::Both);
+			AddNeighbourhoodBlendingRaster(BlendTexture, OutputTarget == ESMAAOutputTarget::Override ? OverrideOutput.Texture : OutputTexture,
+				OutputTarget == ESMAAOutputTarget::Override ? OverrideOutputOffset : FIntPoint::ZeroValue);
+			return;
+		}
+
+		const FSMAAGroupConfig& GroupConfig = Inputs.GroupConfigs[uint32(ESMAAComputePass::NeighbourhoodBlending)];
+
+		FSMAANeighbourhoodBlendingCS::FPermutationDomain PermutationVector;
+
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAPresetConfigDim>(Inputs.Quality);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAReprojectionDim>(Inputs.bTemporal);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAATileMaskDim>(bSkipTiles && TileMask != nullptr);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAGroupShapeDim>(GroupConfig.Shape);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAGroupSwizzleDim>(GroupConfig.bSwizzle);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAOutputTargetDim>(OutputTarget);
+
+		FSMAANeighbourhoodBlendingCS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAANeighbourhoodBlendingCS::FParameters>();
+
+		PassParameters->DepthTexture = SceneDepth;
+		SetNeighbourhoodBlendingParameters(PassParameters, BlendTexture);
+		PassParameters->FinalFrame = OutputTexture ? GraphBuilder.CreateUAV(OutputTexture) : nullptr;
+		SetOverrideOutputParameters(PassParameters, OutputTarget);
+		PassParameters->OutputRect = FIntVector4(OutputRect.Min.X, OutputRect.Min.Y, OutputRect.Max.X, OutputRect.Max.Y);
+		PassParameters->TileMask = TileMask;
+
+		TShaderMapRef<FSMAANeighbourhoodBlendingCS> ComputeShaderSMAANB(View.ShaderMap, PermutationVector);
+		AddComputePass(RDG_EVENT_NAME("SMAA/NeighbourhoodBlending (CS)"), ComputeShaderSMAANB, PassParameters,
+			ESMAAStaticPass::NeighbourhoodBlending, &PassParameters->GroupCount);
+	}
+
+	void AddTemporalResolve(FRDGTextureRef CurrentTexture, FRDGTextureRef PastTexture, const FSMAAHistory& History, FRDGTextureRef OutputTexture)
+	{
+		// Maps this frame's buffer UVs to the history's, which may have been written at another resolution or view
+		// rect. Current buffer UV -> view UV -> history view rect -> history buffer UV
+		const FVector2f CurrentViewMin(View.ViewRect.Min);
+		const FVector2f CurrentViewSize(View.ViewRect.Size());
+		const FVector2f HistoryViewMin(History.ViewportRect.Min);
+		const FVector2f HistoryViewMax(History.ViewportRect.Max);
+		const FVector2f HistoryViewSize(History.ViewportRect.Size());
+		const FVector2f HistoryExtent(History.ReferenceBufferSize);
+
+		const FVector2f UVScale = FVector2f(BackingSize) / CurrentViewSize * HistoryViewSize / HistoryExtent;
+		const FVector2f UVBias = (HistoryViewMin - CurrentViewMin * HistoryViewSize / CurrentViewSize) / HistoryExtent;
+
+		// Keep bilinear taps inside the history's view rect
+		const FVector2f UVMin = (HistoryViewMin + 0.5f) / HistoryExtent;
+		const FVector2f UVMax = (HistoryViewMax - 0.5f) / HistoryExtent;
+
+		const FSMAAGroupConfig& GroupConfig = Inputs.GroupConfigs[uint32(ESMAAComputePass::TemporalResolve)];
+
+		// Always the last pass, and its own output is next frame's history
+		check(OutputTexture);
+		const ESMAAOutputTarget OutputTarget = GetOutputTarget(OutputTexture, true);
+
+		FSMAATemporalResolveCS::FPermutationDomain PermutationVector;
+
+		PermutationVector.Set<FSMAATemporalResolveCS::FSMAAPresetConfigDim>(Inputs.Quality);
+		PermutationVector.Set<FSMAATemporalResolveCS::FSMAAReprojectionDim>(true);
+		PermutationVector.Set<FSMAATemporalResolveCS::FSMAATileMaskDim>(bSkipTiles && TileMask != nullptr);
+		PermutationVector.Set<FSMAATemporalResolveCS::FSMAAGroupShapeDim>(GroupConfig.Shape);
+		PermutationVector.Set<FSMAATemporalResolveCS::FSMAAGroupSwizzleDim>(GroupConfig.bSwizzle);
+		PermutationVector.Set<FSMAATemporalResolveCS::FSMAAOutputTargetDim>(OutputTarget);
+
+		FSMAATemporalResolveCS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAATemporalResolveCS::FParameters>();
+
+		PassParameters->DepthTexture = SceneDepth;
+		PassParameters->CurrentSceneColour = GraphBuilder.CreateSRV(CurrentTexture);
+		PassParameters->PastSceneColour = GraphBuilder.CreateSRV(PastTexture);
+		PassParameters->VelocityTexture = VelocitySRV;
+		PassParameters->SceneDepth = DepthSRV;
+		PassParameters->SMAA = UniformBuffer;
+		PassParameters->View = View.ViewUniformBuffer;
+		PassParameters->ReprojectionWeight = Inputs.ReprojectionWeight;
+		PassParameters->TemporalHistoryBias = Inputs.TemporalHistoryBias;
+		PassParameters->HistoryUVScaleBias = FVector4f(UVScale.X, UVScale.Y, UVBias.X, UVBias.Y);
+		PassParameters->HistoryUVMinMax = FVector4f(UVMin.X, UVMin.Y, UVMax.X, UVMax.Y);
+		PassParameters->Resolved = GraphBuilder.CreateUAV(OutputTexture);
+		SetOverrideOutputParameters(PassParameters, OutputTarget);
+		PassParameters->OutputRect = FIntVector4(OutputRect.Min.X, OutputRect.Min.Y, OutputRect.Max.X, OutputRect.Max.Y);
+		PassParameters->TileMask = TileMask;
+
+		TShaderMapRef<FSMAATemporalResolveCS> ComputeShaderSMAATR(View.ShaderMap, PermutationVector);
+		AddComputePass(RDG_EVENT_NAME("SMAA/TemporalResolve (CS)"), ComputeShaderSMAATR, PassParameters,
+			ESMAAStaticPass::TemporalResolve, &PassParameters->GroupCount);
+	}
+
+	// Groups each pass dispatches when it runs, for static frame detection to write into its indirect arguments
+	TStaticArray<FIntVector, uint32(ESMAAStaticPass::MAX)> GetDispatchGroupCounts() const
+	{
+		TStaticArray<FIntVector, uint32(ESMAAStaticPass::MAX)> GroupCounts;
+		for (uint32 Pass = 0; Pass < uint32(ESMAAStaticPass::MAX); ++Pass)
+		{
+			GroupCounts[Pass] = GetDispatchGroupCount(ESMAAStaticPass(Pass));
+		}
+		return GroupCounts;
+	}
+
+	// From here on compute passes dispatch indirectly, with the arguments static frame detection wrote
+	void SetStaticArgs(FRDGBufferRef InStaticArgs)
+	{
+		check(!bRaster);
+		StaticArgs = InStaticArgs;
+	}
+
+	// Writes the last output into this frame's in place of the skipped passes. Dispatches nothing unless static
+	void AddStaticReuse(FRDGTextureRef PastTexture, const FSMAAHistory& History, FRDGTextureRef OutputTexture)
+	{
+		check(StaticArgs);
+		const ESMAAOutputTarget OutputTarget = GetOutputTarget(OutputTexture, true);
+
+		FSMAAStaticReuseCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAAStaticReuseCS::FSMAAOutputTargetDim>(OutputTarget);
+
+		FSMAAStaticReuseCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSMAAStaticReuseCS::FParameters>();
+		PassParameters->PastSceneColour = PastTexture;
+		PassParameters->HistoryOffset = History.ViewportRect.Min - View.ViewRect.Min;
+		PassParameters->OutputRect = FIntVector4(OutputRect.Min.X, OutputRect.Min.Y, OutputRect.Max.X, OutputRect.Max.Y);
+		PassParameters->FinalFrame = OutputTexture ? GraphBuilder.CreateUAV(OutputTexture) : nullptr;
+		SetOverrideOutputParameters(PassParameters, OutputTarget);
+
+		TShaderMapRef<FSMAAStaticReuseCS> ComputeShader(View.ShaderMap, PermutationVector);
+		AddComputePass(RDG_EVENT_NAME("SMAA/StaticReuse (CS)"), ComputeShader, PassParameters, ESMAAStaticPass::Reuse);
+	}
+
+private:
+	FIntPoint GetTileCount() const
+	{
+		return FIntPoint::DivideAndRoundUp(BackingSize,
+			FIntPoint(FSMAATileClassifyCS::ThreadgroupSizeX, FSMAATileClassifyCS::ThreadgroupSizeY));
+	}
+
+	// Swizzled passes also take their unpadded group count, see GetSMAAGroupCount
+	FIntVector GetDispatchGroupCount(ESMAAStaticPass Pass, FUintVector2* OutGroupCount = nullptr) const
+	{
+		FUintVector2 GroupCount;
+		FUintVector2& UnpaddedCount = OutGroupCount ? *OutGroupCount : GroupCount;
+
+		switch (Pass)
+		{
+		case ESMAAStaticPass::EdgeInputPrepass:
+			return FComputeShaderUtils::GetGroupCount(BackingSize,
+				FIntPoint(FSMAAEdgeInputPrepassCS::ThreadgroupSizeX, FSMAAEdgeInputPrepassCS::ThreadgroupSizeY));
+		case ESMAAStaticPass::TileClassify:
+			return FIntVector(GetTileCount().X, GetTileCount().Y, 1);
+		case ESMAAStaticPass::EdgeDetection:
+			return GetSMAAGroupCount(BackingSize, Inputs.GroupConfigs[uint32(ESMAAComputePass::EdgeDetection)], UnpaddedCount);
+		case ESMAAStaticPass::BlendWeights:
+			return GetSMAAGroupCount(BackingSize, Inputs.GroupConfigs[uint32(ESMAAComputePass::BlendWeights)], UnpaddedCount);
+		case ESMAAStaticPass::NeighbourhoodBlending:
+			return GetSMAAGroupCount(OutputRect.Size(), Inputs.GroupConfigs[uint32(ESMAAComputePass::NeighbourhoodBlending)], UnpaddedCount);
+		case ESMAAStaticPass::TemporalResolve:
+			return GetSMAAGroupCount(OutputRect.Size(), Inputs.GroupConfigs[uint32(ESMAAComputePass::TemporalResolve)], UnpaddedCount);
+		case ESMAAStaticPass::Reuse:
+		default:
+			return FComputeShaderUtils::GetGroupCount(OutputRect.Size(),
+				FIntPoint(FSMAAStaticReuseCS::ThreadgroupSizeX, FSMAAStaticReuseCS::ThreadgroupSizeY));
+		}
+	}
+
+	// Dispatches directly, or through static frame detection's arguments for Pass when it ran
+	template<typename ShaderType>
+	void AddComputePass(FRDGEventName&& PassName, const TShaderRef<ShaderType>& ComputeShader, typename ShaderType::FParameters* PassParameters,
+		ESMAAStaticPass Pass, FUintVector2* OutGroupCount = nullptr)
+	{
+		const FIntVector GroupCount = GetDispatchGroupCount(Pass, OutGroupCount);
+
+		if (StaticArgs)
+		{
+			PassParameters->StaticIndirectArgs = StaticArgs;
+			FComputeShaderUtils::AddPass(GraphBuilder, MoveTemp(PassName), ComputeShader, PassParameters,
+				StaticArgs, uint32(Pass) * sizeof(FRHIDispatchIndirectParameters));
+		}
+		else
+		{
+			FComputeShaderUtils::AddPass(GraphBuilder, MoveTemp(PassName), ComputeShader, PassParameters, GroupCount);
+		}
+	}
+
+	ESMAAOutputTarget GetOutputTarget(FRDGTextureRef OutputTexture, bool bLastPass) const
+	{
+		if (!bLastPass || !OverrideOutput.IsValid())
+		{
+			check(OutputTexture);
+			return ESMAAOutputTarget::Own;
+		}
+
+		return OutputTexture ? ESMAAOutputTarget::Both : ESMAAOutputTarget::Override;
+	}
+
+	template<typename ParametersType>
+	void SetOverrideOutputParameters(ParametersType* PassParameters, ESMAAOutputTarget OutputTarget)
+	{
+		if (OutputTarget != ESMAAOutputTarget::Own)
+		{
+			PassParameters->OverrideOutput = GraphBuilder.CreateUAV(OverrideOutput.Texture);
+			PassParameters->OverrideOutputOffset = OverrideOutputOffset;
+		}
+	}
+
+	FRDGTextureRef CreateTransientTexture(const FRDGTextureDesc& Desc, const TCHAR* Name)
+	{
+		TransientBytes += GetSMAATextureSizeBytes(Desc);
+		return GraphBuilder.CreateTexture(Desc, Name);
+	}
+
+	// Inputs shared by the compute and raster edge detectors
+	template<typename ParametersType>
+	void SetEdgeDetectionParameters(ParametersType* PassParameters, FRDGTextureRef PackedEdgeInput)
+	{
+		// Pass colour for Depth, Luma, and Colour
+		if (Inputs.EdgeMode < ESMAAEdgeDetectors::Normal)
+		{
+			PassParameters->InputSceneColor = ColourSRV;
+		}
+		else if (ESMAAEdgeDetectors::Normal == Inputs.EdgeMode)
+		{
+			//PassParameters->InputSceneColor = GraphBuilder.CreateSRV(Inputs.WorldNormal.Texture);
+			PassParameters->InputSceneColor = GraphBuilder.CreateSRV(PostProcessInputs.SceneTextures.SceneTextures->GetContents()->GBufferATexture);
+		}
+
+		PassParameters->InputDepth = DepthSRV;
+		PassParameters->SMAA = UniformBuffer;
+		PassParameters->View = View.ViewUniformBuffer;
+		PassParameters->Predicate = PredicateSRV;
+		PassParameters->AdaptationFactor = Inputs.AdaptationFactor;
+		PassParameters->PredicationThreshold = Inputs.PredicationThreshold;
+		PassParameters->PredicationScale = Inputs.PredicationScale;
+		PassParameters->PredicationStrength = Inputs.PredicationStrength;
+		if (PackedEdgeInput)
+		{
+			PassParameters->PackedEdgeInput = GraphBuilder.CreateSRV(PackedEdgeInput);
+		}
+	}
+
+	// Inputs shared by the compute and raster neighbourhood blending passes
+	template<typename ParametersType>
+	void SetNeighbourhoodBlendingParameters(ParametersType* PassParameters, FRDGTextureRef BlendTexture)
+	{
+		PassParameters->SceneColour = ColourSRV;
+		PassParameters->InputBlend = GraphBuilder.CreateSRV(BlendTexture);
+		PassParameters->SceneDepth = DepthSRV;
+		PassParameters->VelocityTexture = VelocitySRV;
+		PassParameters->SMAA = UniformBuffer;
+		PassParameters->View = View.ViewUniformBuffer;
+	}
+
+	// Full screen triangle over Rect of a target the size of Extent
+	template<typename PixelShaderType>
+	void AddRasterPass(FRDGEventName&& PassName, const TShaderRef<PixelShaderType>& PixelShader, typename PixelShaderType::FParameters* PassParameters,
+		FIntPoint Extent, FIntRect Rect, FRHIDepthStencilState* DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI())
+	{
+		Rect.Clip(FIntRect(FIntPoint::ZeroValue, Extent));
+		const FScreenPassTextureViewport Viewport(Extent, Rect);
+
+		TShaderMapRef<FScreenPassVS> VertexShader(View.ShaderMap);
+		const FScreenPassPipelineState PipelineState(VertexShader, PixelShader, TStaticBlendState<>::GetRHI(), DepthStencilState, EdgeStencilRef);
+
+		AddDrawScreenPass(GraphBuilder, MoveTemp(PassName), View, Viewport, Viewport, PipelineState, PassParameters, EScreenPassDrawFlags::None,
+			[PixelShader, PassParameters](FRHICommandList& RHICmdList)
+			{
+				SetShaderParameters(RHICmdList, PixelShader, PixelShader.GetPixelShader(), *PassParameters);
+			});
+	}
+
+	// Writes the edges and marks every pixel with an edge in the stencil mask
+	void AddEdgeDetectionRaster(FRDGTextureRef EdgesTexture, FRDGTextureRef PackedEdgeInput)
+	{
+		FSMAAEdgeDetectionPS::FPermutationDomain PermutationVector;
 
-float GetSMAAPredicationScale()
-{
-	return FMath::Clamp(CVarSMAAPredicationScale.GetValueOnRenderThread(), 1.f, 5.f);
-}
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPresetConfigDim>(Inputs.Quality);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAEdgeModeConfigDim>(Inputs.EdgeMode);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPredicateConfigDim>(bPredicate);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPackedInputDim>(PackedEdgeInput != nullptr);
 
-float GetSMAAPredicationStrength()
-{
-	return FMath::Clamp(CVarSMAAPredicationStrength.GetValueOnRenderThread(), 0.f, 1.f);
-}
+		EdgeStencil = CreateTransientTexture(
+			FRDGTextureDesc::Create2D(EdgesTexture->Desc.Extent, PF_DepthStencil, FClearValueBinding::DepthZero, TexCreate_DepthStencilTargetable),
+			TEXT("SMAA.EdgeStencil"));
 
-float GetSMAATemporalHistoryBias()
-{
-	return FMath::Clamp(CVarSMAATemporalHistoryBias.GetValueOnRenderThread(), 0.f, (1.f - SMALL_NUMBER));
-}
+		FSMAAEdgeDetectionPS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAAEdgeDetectionPS::FParameters>();
 
-//// FlipNames
-//TCHAR* FlipNames[2] = {
-//	TEXT("SMAA0"),
-//	TEXT("SMAA1")
-//};
+		PassParameters->DepthTexture = SceneDepth.GetTexture();
+		SetEdgeDetectionParameters(PassParameters, PackedEdgeInput);
 
-FVector4f SubpixelJitterWeights[2] = {
-	FVector4f(1, 1, 1, 0),
-	FVector4f(2, 2, 2, 0)
-};
+		// Discarded pixels keep the cleared value, no edge
+		PassParameters->RenderTargets[0] = FRenderTargetBinding(EdgesTexture, ERenderTargetLoadAction::EClear);
+		PassParameters->RenderTargets.DepthStencil = FDepthStencilBinding(EdgeStencil,
+			ERenderTargetLoadAction::ENoAction, ERenderTargetLoadAction::EClear, FExclusiveDepthStencil::DepthNop_StencilWrite);
 
-FScreenPassTexture AddSMAAPasses(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, const FPostProcessMaterialInputs& InOutInputs, TSharedRef<struct FSMAAViewData> ViewData)
-{
-	check(Inputs.SceneColor.IsValid());
-	check(Inputs.Quality != ESMAAPreset::MAX);
-	check(Inputs.EdgeMode != ESMAAEdgeDetectors::MAX);
-	RDG_EVENT_SCOPE(GraphBuilder, "SMAA T2x");
+		TShaderMapRef<FSMAAEdgeDetectionPS> PixelShader(View.ShaderMap, PermutationVector);
+		AddRasterPass(RDG_EVENT_NAME("SMAA/EdgeDetection (PS)"), PixelShader, PassParameters,
+			EdgesTexture->Desc.Extent, FIntRect(FIntPoint::ZeroValue, BackingSize),
+			TStaticDepthStencilState<false, CF_Always, true, CF_Always, SO_Keep, SO_Keep, SO_Replace>::GetRHI());
+	}
 
-	FIntPoint InputExtents = Inputs.SceneColor.Texture->Desc.Extent; // View.ViewRect.Size();
-	FIntRect InputRect = View.ViewRect;
-	InputRect.Min = FIntPoint(0, 0);
-	InputRect.Min = InputExtents;
-	FIntPoint BackingSize = InputExtents;
-	QuantizeSceneBufferSize(InputExtents, BackingSize);
+	// Only shades the pixels edge detection marked, the rest keep the cleared zero weights
+	void AddBlendingWeightsRaster(FRDGTextureRef EdgesTexture, FRDGTextureRef BlendTexture, const FVector4f& SubpixelWeights)
+	{
+		FSMAABlendingWeightsPS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAPresetConfigDim>(Inputs.Quality);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAASearchALUDim>(Inputs.bSearchALU);
 
-	FIntRect OutputRect = View.ViewRect;
-	FIntPoint OutputExtents = View.ViewRect.Size();
+		FSMAABlendingWeightsPS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAABlendingWeightsPS::FParameters>();
 
-	FScreenPassTexture Output = Inputs.OverrideOutput;
+		PassParameters->DepthTexture = SceneDepth.GetTexture();
+		PassParameters->InputEdges = GraphBuilder.CreateSRV(EdgesTexture);
+		PassParameters->TemporalJitterPixels = FVector2f(View.TemporalJitterPixels);
+		PassParameters->SubpixelWeights = SubpixelWeights;
+		PassParameters->SMAA = UniformBuffer;
+		PassParameters->View = View.ViewUniformBuffer;
+		PassParameters->RenderTargets[0] = FRenderTargetBinding(BlendTexture, ERenderTargetLoadAction::EClear);
 
-	if (!Output.IsValid())
+		// The stencil can only be bound with a target of the same size, which an override output may not be
+		FRHIDepthStencilState* DepthStencilState = TStaticDepthStencilState<false, CF_Always>::GetRHI();
+		if (EdgeStencil && EdgeStencil->Desc.Extent == BlendTexture->Desc.Extent)
+		{
+			PassParameters->RenderTargets.DepthStencil = FDepthStencilBinding(EdgeStencil,
+				ERenderTargetLoadAction::ENoAction, ERenderTargetLoadAction::ELoad, FExclusiveDepthStencil::DepthNop_StencilRead);
+			DepthStencilState = TStaticDepthStencilState<false, CF_Always, true, CF_Equal>::GetRHI();
+		}
+
+		TShaderMapRef<FSMAABlendingWeightsPS> PixelShader(View.ShaderMap, PermutationVector);
+		AddRasterPass(RDG_EVENT_NAME("SMAA/BlendWeights (PS)"), PixelShader, PassParameters,
+			BlendTexture->Desc.Extent, FIntRect(FIntPoint::ZeroValue, BackingSize), DepthStencilState);
+	}
+
+	/**
+	 * Not stencil tested: a pixel also blends with the weights of its right and bottom neighbours, which the mask
+	 * doesn't cover. Pixels without weights take the shader's early out instead.
+	 */
+	void AddNeighbourhoodBlendingRaster(FRDGTextureRef BlendTexture, FRDGTextureRef OutputTexture, FIntPoint OutputOffset)
 	{
-		FRDGTextureDesc WriteOutTextureDesc =
-			FRDGTextureDesc::Create2D(BackingSize, PF_FloatRGBA, FClearValueBinding::Black,
-				TexCreate_ShaderResource | TexCreate_UAV | TexCreate_RenderTargetable);
+		FSMAANeighbourhoodBlendingPS::FPermutationDomain PermutationVector;
+
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAPresetConfigDim>(Inputs.Quality);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAReprojectionDim>(Inputs.bTemporal);
+
+		FSMAANeighbourhoodBlendingPS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAANeighbourhoodBlendingPS::FParameters>();
+
+		PassParameters->DepthTexture = SceneDepth.GetTexture();
+		SetNeighbourhoodBlendingParameters(PassParameters, BlendTexture);
+		PassParameters->OutputOffset = OutputOffset;
+
+		// Tiled renders keep the overlap already in the output
+		PassParameters->RenderTargets[0] = FRenderTargetBinding(OutputTexture, IsTiled() ? ERenderTargetLoadAction::ELoad : ERenderTargetLoadAction::ENoAction);
 
-		Output = FScreenPassTexture(
-			GraphBuilder.CreateTexture(WriteOutTextureDesc, TEXT("SMAA.Output")),
-			OutputRect);
+		TShaderMapRef<FSMAANeighbourhoodBlendingPS> PixelShader(View.ShaderMap, PermutationVector);
+		AddRasterPass(RDG_EVENT_NAME("SMAA/NeighbourhoodBlending (PS)"), PixelShader, PassParameters,
+			OutputTexture->Desc.Extent, OutputRect + OutputOffset);
 	}
 
-	FRHISamplerState* BilinearClampSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
-	FRHISamplerState* PointClampSampler = TStaticSamplerState<SF_Point, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+	// One texel per 8x8 tile, SMAA_TILE_EDGES where the tile may have edges and SMAA_TILE_SKIPPED where every pixel
+	// is masked out
+	FRDGTextureRef AddTileClassification(bool bDepthCulling)
+	{
+		const FIntPoint TileCount = GetTileCount();
+
+		FRDGTextureRef TileMask = CreateTransientTexture(
+			FRDGTextureDesc::Create2D(TileCount, PF_R8_UINT, FClearValueBinding::None, TexCreate_ShaderResource | TexCreate_UAV),
+			TEXT("SMAA.TileMask"));
+
+		FSMAATileClassifyCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAATileClassifyCS::FSMAAPresetConfigDim>(Inputs.Quality);
+		PermutationVector.Set<FSMAATileClassifyCS::FSMAADepthModeDim>(!bDepthCulling ? 0 : Inputs.EdgeMode == ESMAAEdgeDetectors::Normal ? 2 : 1);
+		PermutationVector.Set<FSMAATileClassifyCS::FSMAASkipStencilDim>(Inputs.SkipStencil != 0);
+
+		const FSceneTextureUniformParameters* SceneTextures = PostProcessInputs.SceneTextures.SceneTextures->GetContents();
+
+		FSMAATileClassifyCS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAATileClassifyCS::FParameters>();
+
+		PassParameters->DepthTexture = SceneDepth;
+		PassParameters->InputDepth = DepthSRV;
+		PassParameters->CustomStencil = SceneTextures->CustomStencilTexture;
+		PassParameters->SkipStencil = Inputs.SkipStencil;
+		PassParameters->ViewRect = FIntVector4(View.ViewRect.Min.X, View.ViewRect.Min.Y, View.ViewRect.Max.X, View.ViewRect.Max.Y);
+		for (int32 RectIndex = 0; RectIndex < SkipRects.Num(); ++RectIndex)
+		{
+			const FIntRect& Rect = SkipRects[RectIndex];
+			PassParameters->SkipRects[RectIndex] = FIntVector4(Rect.Min.X, Rect.Min.Y, Rect.Max.X, Rect.Max.Y);
+		}
+		PassParameters->NumSkipRects = SkipRects.Num();
+		PassParameters->SMAA = UniformBuffer;
+		PassParameters->View = View.ViewUniformBuffer;
+		PassParameters->TileMask = GraphBuilder.CreateUAV(TileMask);
+
+		TShaderMapRef<FSMAATileClassifyCS> ComputeShader(View.ShaderMap, PermutationVector);
+		AddComputePass(RDG_EVENT_NAME("SMAA/TileClassify (CS)"), ComputeShader, PassParameters, ESMAAStaticPass::TileClassify);
 
-	auto RTMetrics = FVector4f(1.0 / BackingSize.X, 1.0 / BackingSize.Y, BackingSize.X, BackingSize.Y);
+		return TileMask;
+	}
 
-	const FTexture2DResource* AreaResource = ViewData->SMAAAreaTexture;
-	if (!AreaResource)
+	// Packs luma and the predication signal into a single RG16F texture for the luminance edge detector.
+	// Luma isn't bounded to [0, 1] (see Luma4), which is why this isn't RG8.
+	FRDGTextureRef AddEdgeInputPrepass()
 	{
-		// Bail
-		return Inputs.SceneColor;
+		FRDGTextureDesc PackedTextureDesc =
+			FRDGTextureDesc::Create2D(BackingSize, PF_G16R16F, FClearValueBinding::Black,
+				TexCreate_ShaderResource | TexCreate_UAV);
+
+		FRDGTextureRef PackedTexture = CreateTransientTexture(PackedTextureDesc, TEXT("SMAA.PackedEdgeInput"));
+
+		FSMAAEdgeInputPrepassCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAAEdgeInputPrepassCS::FSMAAPredicateConfigDim>(bPredicate);
+
+		FSMAAEdgeInputPrepassCS::FParameters* PassParameters =
+			GraphBuilder.AllocParameters<FSMAAEdgeInputPrepassCS::FParameters>();
+
+		PassParameters->InputSceneColor = ColourSRV;
+		PassParameters->Predicate = PredicateSRV;
+		PassParameters->SMAA = UniformBuffer;
+		PassParameters->View = View.ViewUniformBuffer;
+		PassParameters->PackedEdgeInput = GraphBuilder.CreateUAV(PackedTexture);
+
+		TShaderMapRef<FSMAAEdgeInputPrepassCS> ComputeShaderSMAAEI(View.ShaderMap, PermutationVector);
+		AddComputePass(RDG_EVENT_NAME("SMAA/EdgeInputPrepass (CS)"), ComputeShaderSMAAEI, PassParameters, ESMAAStaticPass::EdgeInputPrepass);
+
+		return PackedTexture;
 	}
 
-	const FTexture2DResource* SearchResource = ViewData->SMAASearchTexture;
-	if (!SearchResource)
+	FRDGBuilder& GraphBuilder;
+	const FViewInfo& View;
+	const FSMAAInputs& Inputs;
+	const FPostProcessMaterialInputs& PostProcessInputs;
+
+	FIntPoint BackingSize = FIntPoint::ZeroValue;
+	// Pixels the neighbourhood blending and temporal resolve passes write
+	FIntRect OutputRect;
+
+	// Written by the last pass when SMAA ends the post process chain, offset from the scene colour's view rect
+	FScreenPassRenderTarget OverrideOutput;
+	FIntPoint OverrideOutputOffset = FIntPoint::ZeroValue;
+
+	// Indirect arguments of every ESMAAStaticPass, when static frame detection ran
+	FRDGBufferRef StaticArgs = nullptr;
+
+	// Pixel shader passes, with edge detection writing EdgeStencil
+	bool bRaster = false;
+	FRDGTextureRef EdgeStencil = nullptr;
+	static constexpr uint32 EdgeStencilRef = 1;
+
+	// Set by compute edge detection when tiles were classified, see r.SMAA.EdgeTileCulling and r.SMAA.SkipStencil
+	FRDGTextureRef TileMask = nullptr;
+
+	// Masked tiles skip every pass and keep their scene colour, see FSMAAViewSettings::SkipRects
+	bool bSkipTiles = false;
+	TArray<FIntRect, TInlineAllocator<FSMAAViewSettings::MaxSkipRects>> SkipRects;
+
+	uint64 TransientBytes = 0;
+
+	TRDGUniformBufferRef<FSMAAUniformParameters> UniformBuffer = nullptr;
+	TRDGTextureAccess<ERHIAccess::SRVCompute> SceneDepth;
+	FRDGTextureSRVRef DepthSRV = nullptr;
+	FRDGTextureSRVRef ColourSRV = nullptr;
+	FRDGTextureSRVRef VelocitySRV = nullptr;
+	FRDGTextureSRVRef PredicateSRV = nullptr;
+	bool bPredicate = false;
+};
+
+// Tiles narrower than the search distance still work, but their edges no longer match an untiled render
+static void WarnIfTileOverlapTooSmall(const FSMAAInputs& Inputs)
+{
+	static bool bWarned = false;
+
+	const int32 Apron = GetSMAASearchApron(Inputs.Quality, Inputs.MaxSearchSteps, Inputs.MaxDiagonalSearchSteps);
+	if (!bWarned && (Inputs.TileOverlap.X < Apron || Inputs.TileOverlap.Y < Apron))
 	{
-		// Bail
-		return Inputs.SceneColor;
+		UE_LOG(LogSMAA, Warning, TEXT("SMAA tile overlap of %dx%d pixels is less than the %d the searches need, tiles may show seams."),
+			Inputs.TileOverlap.X, Inputs.TileOverlap.Y, Apron);
+		bWarned = true;
 	}
+}
+
+// The raster passes have no tile classification, so masked pixels are processed like any other
+static void WarnIfSkipMasksIgnored(const FSMAAInputs& Inputs)
+{
+	static bool bWarned = false;
 
-	FRHITexture* AreaTextureRHI = AreaResource->GetTexture2DRHI();
-	if (!AreaTextureRHI)
+	if (!bWarned && (Inputs.SkipStencil != 0 || Inputs.SkipRects.Num() > 0))
 	{
-		// Bail
-		return Inputs.SceneColor;
+		UE_LOG(LogSMAA, Warning, TEXT("SMAA skip masks (r.SMAA.SkipStencil, FSMAAViewSettings::SkipRects) only apply to the compute path, set r.SMAA.RasterPath 0 to use them."));
+		bWarned = true;
 	}
-	FRDGTextureRef AreaTexture = RegisterExternalTexture(GraphBuilder, AreaTextureRHI, TEXT("SMAA.AreaTexture"));
+}
+
+FScreenPassTexture AddSMAAPasses(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, const FPostProcessMaterialInputs& InOutInputs, TSharedRef<struct FSMAAViewData> ViewData)
+{
+	check(Inputs.SceneColor.IsValid());
+	check(Inputs.Quality != ESMAAPreset::MAX);
+	check(Inputs.EdgeMode != ESMAAEdgeDetectors::MAX);
+	RDG_EVENT_SCOPE(GraphBuilder, "SMAA %s", Inputs.bTemporal ? TEXT("T2x") : TEXT("1x"));
 
-	FRHITexture* SearchTextureRHI = SearchResource->GetTexture2DRHI();
-	if (!SearchTextureRHI)
+	FSMAAPassBuilder PassBuilder(GraphBuilder, View, Inputs, InOutInputs);
+	if (!PassBuilder.Init(*ViewData))
 	{
 		// Bail
 		return Inputs.SceneColor;
 	}
-	FRDGTextureRef SearchTexture = RegisterExternalTexture(GraphBuilder, SearchTextureRHI, TEXT("SMAA.SearchTexture"));
 
-	// Create Textures for SMAA
-	FRDGTextureDesc EdgesTextureDesc =
-		FRDGTextureDesc::Create2D(BackingSize, PF_FloatRGBA, FClearValueBinding::Black,
-			TexCreate_ShaderResource | TexCreate_UAV | TexCreate_RenderTargetable);
-
-	FRDGTextureRef EdgesTexture = GraphBuilder.CreateTexture(EdgesTextureDesc, TEXT("SMAA.EdgesTexture"));
-
-	// Blend Texture
-	FRDGTextureDesc BlendTextureDesc =
-		FRDGTextureDesc::Create2D(BackingSize, PF_FloatRGBA, FClearValueBinding::Black,
-			TexCreate_ShaderResource | TexCreate_UAV | TexCreate_RenderTargetable);
+	if (PassBuilder.IsRaster())
+	{
+		WarnIfSkipMasksIgnored(Inputs);
+	}
 
-	FRDGTextureRef BlendTexture = GraphBuilder.CreateTexture(BlendTextureDesc, TEXT("SMAA.BlendTexture"));
+	// SMAA 1x has no use for history, don't keep it alive, unless it's shown again on static frames
+	const bool bKeepHistory = Inputs.bTemporal || Inputs.StaticReuse != 0;
+	if (!bKeepHistory)
+	{
+		ViewData->SMAAHistory.SafeRelease();
+	}
 
 	// Modification!
 	// Fall back to SMAA 1x?
@@ -481,234 +1976,176 @@ FScreenPassTexture AddSMAAPasses(FRDGBuilder& GraphBuilder, const FViewInfo& Vie
 		bCameraCut = View.bCameraCut;
 	}
 
-	//InOutInputs.SceneTextures.SceneTextures->GetContents()->SceneColorTexture;
-	FRDGTextureRef SceneColor = Inputs.SceneColor.Texture;
-	//FRDGTextureRef SceneDepth = Inputs.SceneDepth.Texture;
-	FRDGTextureRef Velocity = Inputs.SceneVelocity.Texture;
-
-	// Create Depth SRV Desc
-	//FRDGTextureSRVDesc DepthSRVDesc = FRDGTextureSRVDesc::Create(SceneDepth);
-	FRDGTextureSRVDesc AreaTextureSRVDesc = FRDGTextureSRVDesc::Create(AreaTexture);
-	FRDGTextureSRVDesc SearchTextureSRVDesc = FRDGTextureSRVDesc::Create(SearchTexture);
-	FRDGTextureSRVDesc SceneColourSRVDesc = FRDGTextureSRVDesc::Create(SceneColor);
-	FRDGTextureSRVDesc PrevSceneColourSRVDesc = FRDGTextureSRVDesc::Create(LastRGBA);
-	FRDGTextureSRVDesc EdgesSRVDesc = FRDGTextureSRVDesc::Create(EdgesTexture);
-	FRDGTextureSRVDesc BlendSRVDesc = FRDGTextureSRVDesc::Create(BlendTexture);
-	FRDGTextureSRVDesc WriteOutTextureSRVDesc = FRDGTextureSRVDesc::Create(Output.Texture);
-	FRDGTextureSRVDesc VelocityDesc = FRDGTextureSRVDesc::Create(Velocity);
-
-	FRDGTextureSRVRef AreaTextureSRV = GraphBuilder.CreateSRV(AreaTextureSRVDesc);
-	FRDGTextureSRVRef SearchTextureSRV = GraphBuilder.CreateSRV(SearchTextureSRVDesc);
-	FRDGTextureSRVRef DepthSRV = GraphBuilder.CreateSRV(InOutInputs.SceneTextures.SceneTextures->GetContents()->SceneDepthTexture);
-	FRDGTextureSRVRef ColourSRV = GraphBuilder.CreateSRV(SceneColourSRVDesc);
-
-	TRDGTextureAccess<ERHIAccess::SRVCompute> SceneDepth = InOutInputs.SceneTextures.SceneTextures->GetContents()->SceneDepthTexture;
-
-	// Permutations
-	ESMAAPreset Preset = Inputs.Quality;
-	ESMAAEdgeDetectors EdgeDetectorMode = Inputs.EdgeMode;
-	auto Rounding = Inputs.CornerRounding * 0.01f;
-	auto MaxStepDiag = Inputs.MaxDiagonalSearchSteps;
-	auto MaxStepOrth = Inputs.MaxSearchSteps;
-	auto ProjectionWeight = Inputs.ReprojectionWeight;
-	ESMAAPredicationTexture PredicateSource = Inputs.PredicationSource;
-	auto AdaptationFactor = Inputs.AdaptationFactor;
-	auto PredicationThreshold = Inputs.PredicationThreshold;
-	auto PredicationScale = Inputs.PredicationScale;
-	auto PredicationStrength = Inputs.PredicationStrength;
-	auto TemporalHistoryBias = Inputs.TemporalHistoryBias;
-
-	// Wanted Predicate Texture
-	FRDGTextureSRVRef PredicateTexture = GraphBuilder.CreateSRV(GSystemTextures.GetWhiteDummy(GraphBuilder));
-	switch (PredicateSource)
-	{
-		case ESMAAPredicationTexture::Depth:
-			PredicateTexture = DepthSRV;
-			break;
-		case ESMAAPredicationTexture::WorldNormal:
-			PredicateTexture = GraphBuilder.CreateSRV(InOutInputs.SceneTextures.SceneTextures->GetContents()->GBufferATexture);
-			break;
-		case ESMAAPredicationTexture::MRS:
-			PredicateTexture = GraphBuilder.CreateSRV(InOutInputs.SceneTextures.SceneTextures->GetContents()->GBufferBTexture);
-			//PredicateTexture = GraphBuilder.CreateSRV(Inputs.PredicateTexture.Texture);
-			break;
-		case ESMAAPredicationTexture::None:;
-		case ESMAAPredicationTexture::MAX:;
-		default:;
+	const bool bResolve = Inputs.bTemporal && ViewData->SMAAHistory.IsValid() && !bCameraCut;
+
+	// Ending the post process chain, the last pass writes the chain's output itself instead of the engine copying ours
+	// into it. A kept history is still written to our own output, which a raster blend can't do alongside
+	const bool bLastPassRaster = PassBuilder.IsRaster() && !bResolve;
+	const bool bOverrideOutput = !(bLastPassRaster && bKeepHistory)
+		&& PassBuilder.CanWriteOverrideOutput(Inputs.OverrideOutput, bLastPassRaster);
+	if (bOverrideOutput)
+	{
+		PassBuilder.SetOverrideOutput(Inputs.OverrideOutput);
 	}
 
+	FScreenPassTexture Output;
+	if (bKeepHistory || !bOverrideOutput)
 	{
-		FSMAAEdgeDetectionCS::FPermutationDomain PermutationVector;
+		// T2x's output is next frame's history, so it's sized to survive resolution changes
+		const FIntPoint OutputExtent = Inputs.bTemporal
+			? GetSMAAHistoryExtent(PassBuilder.GetBackingSize(), ViewData->SMAAHistory, Inputs.HistoryHeadroom)
+			: PassBuilder.GetBackingSize();
 
-		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPresetConfigDim>(Preset);
-		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAEdgeModeConfigDim>(EdgeDetectorMode);
-		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPredicateConfigDim>(ESMAAPredicationTexture::None != PredicateSource);
+		Output = FScreenPassTexture(PassBuilder.CreateTexture(TEXT("SMAA.Output"), OutputExtent), View.ViewRect);
+	}
 
-		FSMAAEdgeDetectionCS::FParameters* PassParameters =
-			GraphBuilder.AllocParameters<FSMAAEdgeDetectionCS::FParameters>();
-		FRDGTextureUAVDesc OutputDesc(EdgesTexture);
+	// Create Textures for SMAA
+	FRDGTextureRef EdgesTexture = PassBuilder.CreateTexture(TEXT("SMAA.EdgesTexture"));
+	FRDGTextureRef BlendTexture = PassBuilder.CreateTexture(TEXT("SMAA.BlendTexture"));
+
+	// Edge coverage telemetry, written by the edge detection and blend weight passes
+	const bool bEdgeStats = (IsSMAAEdgeStatsEnabled() || Inputs.SharedRuns == 2) && !PassBuilder.IsRaster();
+	FRDGBufferRef EdgeStatsBuffer = nullptr;
+	FRDGBufferUAVRef EdgeStatsUAV = nullptr;
+	if (bEdgeStats)
+	{
+		if (!ViewData->EdgeStats.IsValid())
+		{
+			ViewData->EdgeStats = MakeShared<FSMAAEdgeStatsReadback>();
+		}
 
-		PassParameters->DepthTexture = SceneDepth;
-		PassParameters->PointTextureSampler = PointClampSampler;
-		PassParameters->BilinearTextureSampler = BilinearClampSampler;
+		EdgeStatsBuffer = FSMAAEdgeStatsReadback::CreateStatsBuffer(GraphBuilder);
+		PassBuilder.CountBuffer(EdgeStatsBuffer->Desc);
+		EdgeStatsUAV = GraphBuilder.CreateUAV(EdgeStatsBuffer, PF_R32_UINT, ERDGUnorderedAccessViewFlags::SkipBarrier);
+	}
 
-		// Pass colour for Depth, Luma, and Colour
-		if (EdgeDetectorMode < ESMAAEdgeDetectors::Normal)
+	// GPU timings for r.SMAA.BenchmarkGroupShapes, which only concerns the compute passes
+	FSMAAGroupShapeBenchmark* Benchmark = !PassBuilder.IsRaster() && FSMAAGroupShapeBenchmark::Get().IsRunning()
+		? &FSMAAGroupShapeBenchmark::Get()
+		: nullptr;
+
+	// Static frames show the last output again and skip the passes. Only worth detecting while the view holds still, and
+	// not while anything looks at what the passes produce
+	FRDGBufferRef StaticArgs = nullptr;
+	if (Inputs.StaticReuse != 0)
+	{
+		if (!ViewData->StaticFrame.IsValid())
 		{
-			PassParameters->InputSceneColor = ColourSRV;
+			ViewData->StaticFrame = MakeShared<FSMAAStaticFrame>();
 		}
-		else if (ESMAAEdgeDetectors::Normal == EdgeDetectorMode)
+
+		const bool bEligible = !PassBuilder.IsRaster() && !PassBuilder.IsTiled() && !Inputs.bPublishTextures && !bEdgeStats && !Benchmark;
+		if (ViewData->StaticFrame->IsCandidate(View, Inputs, ViewData->SMAAHistory, bEligible))
 		{
-			//PassParameters->InputSceneColor = GraphBuilder.CreateSRV(Inputs.WorldNormal.Texture);
-			PassParameters->InputSceneColor = GraphBuilder.CreateSRV(InOutInputs.SceneTextures.SceneTextures->GetContents()->GBufferATexture);
+			StaticArgs = ViewData->StaticFrame->AddDetection(GraphBuilder, View, Inputs, ViewData->JitterIndex, PassBuilder.GetDispatchGroupCounts());
+			PassBuilder.SetStaticArgs(StaticArgs);
+			PassBuilder.CountBuffer(StaticArgs->Desc);
+			PassBuilder.CountBuffer(FSMAAStaticFrame::GetStateDesc());
 		}
-
-		PassParameters->InputDepth = DepthSRV;
-		PassParameters->ViewportMetrics = RTMetrics;
-		PassParameters->View = View.ViewUniformBuffer;
-		PassParameters->NormalisedCornerRounding = Rounding;
-		PassParameters->MaxSearchSteps = MaxStepOrth;
-		PassParameters->MaxDiagonalSearchSteps = MaxStepDiag;
-		PassParameters->Predicate = PredicateTexture;
-		PassParameters->AdaptationFactor = AdaptationFactor;
-		PassParameters->PredicationThreshold = PredicationThreshold;
-		PassParameters->PredicationScale = PredicationScale;
-		PassParameters->PredicationStrength = PredicationStrength;
-		PassParameters->EdgesTexture = GraphBuilder.CreateUAV(OutputDesc);
-
-		TShaderMapRef<FSMAAEdgeDetectionCS> ComputeShaderSMAAED(View.ShaderMap, PermutationVector);
-		FComputeShaderUtils::AddPass(
-			GraphBuilder, RDG_EVENT_NAME("SMAA/EdgeDetection (CS)"), ComputeShaderSMAAED, PassParameters,
-			FComputeShaderUtils::GetGroupCount(FIntVector(EdgesTexture->Desc.Extent.X, EdgesTexture->Desc.Extent.Y, 1),
-				FIntVector(FSMAAEdgeDetectionCS::ThreadgroupSizeX,
-					FSMAAEdgeDetectionCS::ThreadgroupSizeY,
-					FSMAAEdgeDetectionCS::ThreadgroupSizeZ)));
+	}
+	else
+	{
+		ViewData->StaticFrame.Reset();
 	}
 
-	// Blend
+	if (Benchmark)
 	{
-		FSMAABlendingWeightsCS::FPermutationDomain PermutationVector;
+		Benchmark->AddTimestamp(GraphBuilder, ESMAAComputePass::EdgeDetection);
+	}
 
-		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAPresetConfigDim>(Preset);
+	PassBuilder.AddEdgeDetection(EdgesTexture, EdgeStatsUAV);
 
-		FSMAABlendingWeightsCS::FParameters* PassParameters =
-			GraphBuilder.AllocParameters<FSMAABlendingWeightsCS::FParameters>();
-		FRDGTextureUAVDesc OutputDesc(BlendTexture);
+	if (Benchmark)
+	{
+		Benchmark->AddTimestamp(GraphBuilder, ESMAAComputePass::BlendWeights);
+	}
 
-		PassParameters->DepthTexture = SceneDepth;
-		PassParameters->PointTextureSampler = TStaticSamplerState<SF_Point>::GetRHI();
-		PassParameters->BilinearTextureSampler = TStaticSamplerState<SF_Bilinear>::GetRHI();
-		PassParameters->AreaTexture = AreaTextureSRV;
-		PassParameters->InputEdges = GraphBuilder.CreateSRV(EdgesSRVDesc);
-		PassParameters->TemporalJitterPixels = FVector2f(View.TemporalJitterPixels);
-		PassParameters->SubpixelWeights = SubpixelJitterWeights[ViewData->JitterIndex & 1];
-		PassParameters->SearchTexture = SearchTextureSRV;
-		PassParameters->ViewportMetrics = RTMetrics;
-		PassParameters->View = View.ViewUniformBuffer;
-		PassParameters->NormalisedCornerRounding = Rounding;
-		PassParameters->MaxSearchSteps = MaxStepOrth;
-		PassParameters->MaxDiagonalSearchSteps = MaxStepDiag;
-		PassParameters->BlendTexture = GraphBuilder.CreateUAV(OutputDesc);
+	// Blend
+	// SMAA 1x has no subsample offsets
+	const FVector4f SubpixelWeights = Inputs.bTemporal ? SubpixelJitterWeights[ViewData->JitterIndex & 1] : FVector4f(0, 0, 0, 0);
+	PassBuilder.AddBlendingWeights(EdgesTexture, BlendTexture, SubpixelWeights, EdgeStatsUAV);
 
-		TShaderMapRef<FSMAABlendingWeightsCS> ComputeShaderSMAABW(View.ShaderMap, PermutationVector);
-		FComputeShaderUtils::AddPass(
-			GraphBuilder, RDG_EVENT_NAME("SMAA/BlendWeights (CS)"), ComputeShaderSMAABW, PassParameters,
-			FComputeShaderUtils::GetGroupCount(FIntVector(EdgesTexture->Desc.Extent.X, EdgesTexture->Desc.Extent.Y, 1),
-				FIntVector(FSMAABlendingWeightsCS::ThreadgroupSizeX,
-					FSMAABlendingWeightsCS::ThreadgroupSizeY,
-					FSMAABlendingWeightsCS::ThreadgroupSizeZ)));
+	if (bEdgeStats)
+	{
+		ViewData->EdgeStats->EnqueueReadback(GraphBuilder, EdgeStatsBuffer, PassBuilder.GetBackingSize());
 	}
 
-	// Neighbourhood Blending
+	// Tiled renders leave the overlap as it came in. It's cropped or blended with the neighbouring tile's interior
+	if (PassBuilder.IsTiled())
 	{
-		FSMAANeighbourhoodBlendingCS::FPermutationDomain PermutationVector;
-
-		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAPresetConfigDim>(Preset);
-		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAReprojectionDim>(true);
-
-		FSMAANeighbourhoodBlendingCS::FParameters* PassParameters =
-			GraphBuilder.AllocParameters<FSMAANeighbourhoodBlendingCS::FParameters>();
-		FRDGTextureUAVDesc OutputDesc(EdgesTexture);
-
-		PassParameters->DepthTexture = SceneDepth;
-		PassParameters->PointTextureSampler = PointClampSampler;
-		PassParameters->BilinearTextureSampler = BilinearClampSampler;
-		PassParameters->SceneColour = GraphBuilder.CreateSRV(SceneColourSRVDesc);
-		PassParameters->InputBlend = GraphBuilder.CreateSRV(BlendSRVDesc);
-		PassParameters->SceneDepth = DepthSRV;
-		//PassParameters->VelocityTexture = InOutInputs.GetInput(EPostProcessMaterialInput::Velocity).TextureSRV;
-		PassParameters->ViewportMetrics = RTMetrics;
-		PassParameters->View = View.ViewUniformBuffer;
-		PassParameters->NormalisedCornerRounding = Rounding;
-		PassParameters->MaxSearchSteps = MaxStepOrth;
-		PassParameters->MaxDiagonalSearchSteps = MaxStepDiag;
-
-		// Write out to Final if bCameraCut
-		if (bCameraCut)
+		WarnIfTileOverlapTooSmall(Inputs);
+		if (Output.IsValid())
 		{
-			PassParameters->FinalFrame = GraphBuilder.CreateUAV(Output.Texture);
+			AddDrawTexturePass(GraphBuilder, View, Inputs.SceneColor, FScreenPassRenderTarget(Output, ERenderTargetLoadAction::ENoAction));
 		}
-		else
+		if (bOverrideOutput)
 		{
-			PassParameters->FinalFrame = GraphBuilder.CreateUAV(OutputDesc);
+			AddDrawTexturePass(GraphBuilder, View, Inputs.SceneColor, FScreenPassRenderTarget(Inputs.OverrideOutput.Texture, Inputs.OverrideOutput.ViewRect, ERenderTargetLoadAction::ENoAction));
 		}
+	}
 
-		TShaderMapRef<FSMAANeighbourhoodBlendingCS> ComputeShaderSMAANB(View.ShaderMap, PermutationVector);
-		FComputeShaderUtils::AddPass(
-			GraphBuilder, RDG_EVENT_NAME("SMAA/NeighbourhoodBlending (CS)"), ComputeShaderSMAANB, PassParameters,
-			FComputeShaderUtils::GetGroupCount(FIntVector(EdgesTexture->Desc.Extent.X, EdgesTexture->Desc.Extent.Y, 1),
-				FIntVector(FSMAANeighbourhoodBlendingCS::ThreadgroupSizeX,
-					FSMAANeighbourhoodBlendingCS::ThreadgroupSizeY,
-					FSMAANeighbourhoodBlendingCS::ThreadgroupSizeZ)));
+	// Neighbourhood Blending
+	// Write out to Final if bCameraCut or SMAA 1x, otherwise reuse the edges texture as the resolve input, unless
+	// the edges are published
+	FRDGTextureRef ResolveInput = nullptr;
+	if (bResolve)
+	{
+		ResolveInput = Inputs.bPublishTextures ? PassBuilder.CreateTexture(TEXT("SMAA.ResolveInput")) : EdgesTexture;
+	}
+
+	if (Benchmark)
+	{
+		Benchmark->AddTimestamp(GraphBuilder, ESMAAComputePass::NeighbourhoodBlending);
 	}
 
+	PassBuilder.AddNeighbourhoodBlending(BlendTexture, bResolve ? ResolveInput : Output.Texture, !bResolve);
+
 	// Temporal Resolve
-	if (!bCameraCut)
+	if (bResolve)
 	{
-		FSMAATemporalResolveCS::FPermutationDomain PermutationVector;
+		if (Benchmark)
+		{
+			Benchmark->AddTimestamp(GraphBuilder, ESMAAComputePass::TemporalResolve);
+		}
 
-		PermutationVector.Set<FSMAATemporalResolveCS::FSMAAPresetConfigDim>(Preset);
-		PermutationVector.Set<FSMAATemporalResolveCS::FSMAAReprojectionDim>(true);
+		PassBuilder.AddTemporalResolve(ResolveInput, LastRGBA, ViewData->SMAAHistory, Output.Texture);
+	}
 
-		FSMAATemporalResolveCS::FParameters* PassParameters =
-			GraphBuilder.AllocParameters<FSMAATemporalResolveCS::FParameters>();
+	if (StaticArgs)
+	{
+		PassBuilder.AddStaticReuse(LastRGBA, ViewData->SMAAHistory, Output.Texture);
+	}
 
-		PassParameters->DepthTexture = SceneDepth;
-		PassParameters->PointTextureSampler = PointClampSampler;
-		PassParameters->BilinearTextureSampler = BilinearClampSampler;
-		PassParameters->CurrentSceneColour = GraphBuilder.CreateSRV(EdgesSRVDesc);
-		PassParameters->PastSceneColour = GraphBuilder.CreateSRV(PrevSceneColourSRVDesc);
-		PassParameters->VelocityTexture = GraphBuilder.CreateSRV(VelocityDesc);
-		PassParameters->SceneDepth = DepthSRV;
-		PassParameters->ViewportMetrics = RTMetrics;
-		PassParameters->View = View.ViewUniformBuffer;
-		PassParameters->NormalisedCornerRounding = Rounding;
-		PassParameters->MaxSearchSteps = MaxStepOrth;
-		PassParameters->MaxDiagonalSearchSteps = MaxStepDiag;
-		PassParameters->ReprojectionWeight = ProjectionWeight;
-		PassParameters->TemporalHistoryBias = TemporalHistoryBias;
-		PassParameters->Resolved = GraphBuilder.CreateUAV(Output.Texture);
+	if (Benchmark)
+	{
+		Benchmark->AddTimestamp(GraphBuilder, ESMAAComputePass::MAX);
+		Benchmark->EndView();
+	}
 
-		TShaderMapRef<FSMAATemporalResolveCS> ComputeShaderSMAATR(View.ShaderMap, PermutationVector);
-		FComputeShaderUtils::AddPass(
-			GraphBuilder, RDG_EVENT_NAME("SMAA/TemporalResolve (CS)"), ComputeShaderSMAATR, PassParameters,
-			FComputeShaderUtils::GetGroupCount(FIntVector(EdgesTexture->Desc.Extent.X, EdgesTexture->Desc.Extent.Y, 1),
-				FIntVector(FSMAATemporalResolveCS::ThreadgroupSizeX,
-					FSMAATemporalResolveCS::ThreadgroupSizeY,
-					FSMAATemporalResolveCS::ThreadgroupSizeZ)));
+	if (Inputs.bPublishTextures)
+	{
+		ViewData->PublishedTextures.Edges = EdgesTexture;
+		ViewData->PublishedTextures.BlendWeights = BlendTexture;
+		ViewData->PublishedTextures.ViewRect = View.ViewRect;
+		ViewData->PublishedGraphBuilder = &GraphBuilder;
+		ViewData->PublishedFrame = GFrameCounterRenderThread;
 	}
 
-	if (!View.bStatePrevViewInfoIsReadOnly)
+	if (bKeepHistory && !View.bStatePrevViewInfoIsReadOnly)
 	{
 		//FSMAAHistory& History = View.ViewState->PrevFrameViewInfo.SMAAHistory;
 		FSMAAHistory& History = ViewData->SMAAHistory;
 		History.SafeRelease();
 
 		GraphBuilder.QueueTextureExtraction(Output.Texture, &History.PastFrame);
-		History.ViewportRect = InputRect;
+		History.ReferenceBufferSize = Output.Texture->Desc.Extent;
+		History.ViewportRect = Output.ViewRect;
 	}
 
-	return Output;
+	ViewData->Memory.TransientBytes = PassBuilder.GetTransientBytes();
+	ViewData->Memory.TransientExtent = PassBuilder.GetBackingSize();
+
+	return bOverrideOutput ? FScreenPassTexture(Inputs.OverrideOutput) : Output;
 }
 
 FScreenPassTexture AddVisualizeSMAAPasses(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, const FPostProcessMaterialInputs& InOutInputs, TSharedRef<struct FSMAAViewData> ViewData)
@@ -718,200 +2155,281 @@ FScreenPassTexture AddVisualizeSMAAPasses(FRDGBuilder& GraphBuilder, const FView
 	check(Inputs.EdgeMode != ESMAAEdgeDetectors::MAX);
 	RDG_EVENT_SCOPE(GraphBuilder, "SMAA T2x Visualizer");
 
-	FIntPoint InputExtents = Inputs.SceneColor.Texture->Desc.Extent; // View.ViewRect.Size();
-	FIntRect InputRect = View.ViewRect;
-	InputRect.Min = FIntPoint(0, 0);
-	InputRect.Min = InputExtents;
-	FIntPoint BackingSize = InputExtents;
-	QuantizeSceneBufferSize(InputExtents, BackingSize);
-
-	FIntRect OutputRect = View.ViewRect;
-	FIntPoint OutputExtents = View.ViewRect.Size();
+	FSMAAPassBuilder PassBuilder(GraphBuilder, View, Inputs, InOutInputs);
+	if (!PassBuilder.Init(*ViewData))
+	{
+		// Bail
+		return Inputs.SceneColor;
+	}
 
 	FScreenPassTexture Output = Inputs.OverrideOutput;
 
 	if (!Output.IsValid())
 	{
-		FRDGTextureDesc WriteOutTextureDesc =
-			FRDGTextureDesc::Create2D(BackingSize, PF_FloatRGBA, FClearValueBinding::Black,
-				TexCreate_ShaderResource | TexCreate_UAV | TexCreate_RenderTargetable);
-
-		Output = FScreenPassTexture(
-			GraphBuilder.CreateTexture(WriteOutTextureDesc, TEXT("SMAA.Output")),
-			OutputRect);
+		Output = FScreenPassTexture(PassBuilder.CreateTexture(TEXT("SMAA.Output")), View.ViewRect);
 	}
 
-	FRHISamplerState* BilinearClampSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
-	FRHISamplerState* PointClampSampler = TStaticSamplerState<SF_Point, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+	// Create only Edges texture. We're writing straight out to output on blend
+	FRDGTextureRef EdgesTexture = PassBuilder.CreateTexture(TEXT("SMAA.EdgesTexture"));
+
+	PassBuilder.AddEdgeDetection(EdgesTexture);
+
+	// Blend
+	PassBuilder.AddBlendingWeights(EdgesTexture, Output.Texture, Inputs.bTemporal ? SubpixelJitterWeights[View.TemporalJitterIndex & 1] : FVector4f(0, 0, 0, 0));
+
+	ViewData->Memory.TransientBytes = PassBuilder.GetTransientBytes();
+	ViewData->Memory.TransientExtent = PassBuilder.GetBackingSize();
+
+	return Output;
+}
 
-	auto RTMetrics = FVector4f(1.0 / BackingSize.X, 1.0 / BackingSize.Y, BackingSize.X, BackingSize.Y);
+///// ///// ////////// ///// /////
+// Standalone GPU passes, see SMAAGPU.h
+//
 
-	const FTexture2DResource* AreaResource = ViewData->SMAAAreaTexture;
-	if (!AreaResource)
+namespace SMAAGPU
+{
+	bool IsAvailable()
 	{
-		// Bail
-		return Inputs.SceneColor;
+		return GDynamicRHI != nullptr && !GUsingNullRHI;
 	}
 
-	const FTexture2DResource* SearchResource = ViewData->SMAASearchTexture;
-	if (!SearchResource)
+	FRDGTextureRef Upload(FRDGBuilder& GraphBuilder, const FSMAACPUImage& Image, const TCHAR* Name)
 	{
-		// Bail
-		return Inputs.SceneColor;
+		const FRHITextureCreateDesc Desc = FRHITextureCreateDesc::Create2D(Name, Image.Width, Image.Height, PF_A32B32G32R32F)
+			.SetFlags(ETextureCreateFlags::ShaderResource);
+		FTextureRHIRef Texture = RHICreateTexture(Desc);
+
+		GraphBuilder.RHICmdList.UpdateTexture2D(Texture, 0, FUpdateTextureRegion2D(0, 0, 0, 0, Image.Width, Image.Height),
+			Image.Width * sizeof(FVector4f), reinterpret_cast<const uint8*>(Image.Pixels.GetData()));
+
+		return GraphBuilder.RegisterExternalTexture(CreateRenderTarget(Texture, Name));
 	}
 
-	FRHITexture* AreaTextureRHI = AreaResource->GetTexture2DRHI();
-	if (!AreaTextureRHI)
+	FRDGTextureRef CreateOutput(FRDGBuilder& GraphBuilder, FIntPoint Size, const TCHAR* Name)
 	{
-		// Bail
-		return Inputs.SceneColor;
+		return GraphBuilder.CreateTexture(
+			FRDGTextureDesc::Create2D(Size, PF_A32B32G32R32F, FClearValueBinding::Black, TexCreate_ShaderResource | TexCreate_UAV), Name);
 	}
-	FRDGTextureRef AreaTexture = RegisterExternalTexture(GraphBuilder, AreaTextureRHI, TEXT("SMAA.AreaTexture"));
 
-	FRHITexture* SearchTextureRHI = SearchResource->GetTexture2DRHI();
-	if (!SearchTextureRHI)
+	// Null textures are only allowed where the permutation never samples them
+	TRDGUniformBufferRef<FSMAAUniformParameters> CreateUniformBuffer(FRDGBuilder& GraphBuilder, const FSMAACPUSettings& Settings, FIntPoint Size,
+		FRDGTextureRef AreaTexture = nullptr, FRDGTextureRef SearchTexture = nullptr)
 	{
-		// Bail
-		return Inputs.SceneColor;
+		FSMAAUniformParameters* UniformParameters = GraphBuilder.AllocParameters<FSMAAUniformParameters>();
+		UniformParameters->ViewportMetrics = FVector4f(1.0 / Size.X, 1.0 / Size.Y, Size.X, Size.Y);
+		UniformParameters->NormalisedCornerRounding = Settings.CornerRounding * 0.01f;
+		UniformParameters->MaxSearchSteps = Settings.MaxSearchSteps;
+		UniformParameters->MaxDiagonalSearchSteps = Settings.MaxDiagonalSearchSteps;
+		UniformParameters->AreaTexture = AreaTexture ? AreaTexture : GSystemTextures.GetBlackDummy(GraphBuilder);
+		UniformParameters->SearchTexture = SearchTexture ? SearchTexture : GSystemTextures.GetBlackDummy(GraphBuilder);
+		UniformParameters->PointTextureSampler = TStaticSamplerState<SF_Point, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		UniformParameters->BilinearTextureSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+		return GraphBuilder.CreateUniformBuffer(UniformParameters);
 	}
-	FRDGTextureRef SearchTexture = RegisterExternalTexture(GraphBuilder, SearchTextureRHI, TEXT("SMAA.SearchTexture"));
 
-	// Create only Edges texture. We're writing straight out to output on blend
-	FRDGTextureDesc EdgesTextureDesc =
-		FRDGTextureDesc::Create2D(BackingSize, PF_FloatRGBA, FClearValueBinding::Black,
-			TexCreate_ShaderResource | TexCreate_UAV | TexCreate_RenderTargetable);
-
-	FRDGTextureRef EdgesTexture = GraphBuilder.CreateTexture(EdgesTextureDesc, TEXT("SMAA.EdgesTexture"));
-
-	FRDGTextureRef SceneColor = Inputs.SceneColor.Texture;
-	//FRDGTextureRef SceneDepth = Inputs.SceneDepth.Texture;
-	FRDGTextureRef Velocity = Inputs.SceneVelocity.Texture;
-
-	// Create Depth SRV Desc
-	//FRDGTextureSRVDesc DepthSRVDesc = FRDGTextureSRVDesc::Create(SceneDepth);
-	FRDGTextureSRVDesc AreaTextureSRVDesc = FRDGTextureSRVDesc::Create(AreaTexture);
-	FRDGTextureSRVDesc SearchTextureSRVDesc = FRDGTextureSRVDesc::Create(SearchTexture);
-	FRDGTextureSRVDesc SceneColourSRVDesc = FRDGTextureSRVDesc::Create(SceneColor);
-	FRDGTextureSRVDesc EdgesSRVDesc = FRDGTextureSRVDesc::Create(EdgesTexture);
-	FRDGTextureSRVDesc WriteOutTextureSRVDesc = FRDGTextureSRVDesc::Create(Output.Texture);
-	FRDGTextureSRVDesc VelocityDesc = FRDGTextureSRVDesc::Create(Velocity);
-
-	FRDGTextureSRVRef AreaTextureSRV = GraphBuilder.CreateSRV(AreaTextureSRVDesc);
-	FRDGTextureSRVRef SearchTextureSRV = GraphBuilder.CreateSRV(SearchTextureSRVDesc);
-	FRDGTextureSRVRef DepthSRV = GraphBuilder.CreateSRV(InOutInputs.SceneTextures.SceneTextures->GetContents()->SceneDepthTexture);
-	FRDGTextureSRVRef ColourSRV = GraphBuilder.CreateSRV(SceneColourSRVDesc);
-
-	TRDGTextureAccess<ERHIAccess::SRVCompute> SceneDepth = InOutInputs.SceneTextures.SceneTextures->GetContents()->SceneDepthTexture;
-
-	// Permutations
-	ESMAAPreset Preset = Inputs.Quality;
-	ESMAAEdgeDetectors EdgeDetectorMode = Inputs.EdgeMode;
-	auto Rounding = Inputs.CornerRounding * 0.01f;
-	auto MaxStepDiag = Inputs.MaxDiagonalSearchSteps;
-	auto MaxStepOrth = Inputs.MaxSearchSteps;
-	ESMAAPredicationTexture PredicateSource = Inputs.PredicationSource;
-	auto AdaptationFactor = Inputs.AdaptationFactor;
-	auto PredicationThreshold = Inputs.PredicationThreshold;
-	auto PredicationScale = Inputs.PredicationScale;
-	auto PredicationStrength = Inputs.PredicationStrength;
-
-	// Wanted Predicate Texture
-	FRDGTextureSRVRef PredicateTexture = GraphBuilder.CreateSRV(GSystemTextures.GetWhiteDummy(GraphBuilder));
-	switch (PredicateSource)
-	{
-		case ESMAAPredicationTexture::Depth:
-			PredicateTexture = DepthSRV;
-			break;
-		case ESMAAPredicationTexture::WorldNormal:
-			PredicateTexture = GraphBuilder.CreateSRV(InOutInputs.SceneTextures.SceneTextures->GetContents()->GBufferATexture);
-			break;
-		case ESMAAPredicationTexture::MRS:
-			PredicateTexture = GraphBuilder.CreateSRV(InOutInputs.SceneTextures.SceneTextures->GetContents()->GBufferBTexture);
-			break;
-		case ESMAAPredicationTexture::None:;
-		case ESMAAPredicationTexture::MAX:;
-		default:;
-	}
+	// Returns the texture AddPasses wrote, which is read back into OutImage. EdgeStats is only set with OutEdgeStats
+	using FAddPasses = TFunctionRef<FRDGTextureRef(FRDGBuilder& GraphBuilder, FRDGBufferUAVRef EdgeStats)>;
 
+	/**
+	 * Builds and runs a graph on the render thread, then waits for the GPU so the readbacks can be copied out. Blocks
+	 * the game thread until then.
+	 */
+	void Run(const TCHAR* Name, FAddPasses AddPasses, FSMAACPUImage& OutImage, uint32* OutEdgeStats = nullptr)
 	{
-		FSMAAEdgeDetectionCS::FPermutationDomain PermutationVector;
+		check(IsInGameThread());
 
-		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPresetConfigDim>(Preset);
-		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAEdgeModeConfigDim>(EdgeDetectorMode);
-		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPredicateConfigDim>(ESMAAPredicationTexture::None != PredicateSource);
+		ENQUEUE_RENDER_COMMAND(SMAAGPURun)([Name, AddPasses, &OutImage, OutEdgeStats](FRHICommandListImmediate& RHICmdList)
+		{
+			FRHIGPUTextureReadback Readback(TEXT("SMAA.GPURunReadback"));
+			FRHIGPUBufferReadback StatsReadback(TEXT("SMAA.GPURunStatsReadback"));
+			const uint32 StatsBytes = sizeof(uint32) * uint32(ESMAAEdgeStat::Num);
+
+			{
+				FRDGBuilder GraphBuilder(RHICmdList, FRDGEventName(Name));
+
+				FRDGBufferRef StatsBuffer = OutEdgeStats ? FSMAAEdgeStatsReadback::CreateStatsBuffer(GraphBuilder) : nullptr;
+				FRDGBufferUAVRef StatsUAV = StatsBuffer ? GraphBuilder.CreateUAV(StatsBuffer, PF_R32_UINT, ERDGUnorderedAccessViewFlags::SkipBarrier) : nullptr;
+
+				FRDGTextureRef Output = AddPasses(GraphBuilder, StatsUAV);
+				AddEnqueueCopyPass(GraphBuilder, &Readback, Output);
+				if (StatsBuffer)
+				{
+					AddEnqueueCopyPass(GraphBuilder, &StatsReadback, StatsBuffer, StatsBytes);
+				}
+
+				GraphBuilder.Execute();
+			}
+
+			RHICmdList.BlockUntilGPUIdle();
+
+			int32 RowPitchInPixels = 0;
+			const FLinearColor* Texels = static_cast<const FLinearColor*>(Readback.Lock(RowPitchInPixels));
+			for (int32 Y = 0; Y < OutImage.Height; ++Y)
+			{
+				FMemory::Memcpy(&OutImage.At(0, Y), &Texels[Y * RowPitchInPixels], OutImage.Width * sizeof(FVector4f));
+			}
+			Readback.Unlock();
+
+			if (OutEdgeStats)
+			{
+				FMemory::Memcpy(OutEdgeStats, StatsReadback.Lock(StatsBytes), StatsBytes);
+				StatsReadback.Unlock();
+			}
+		});
+
+		FlushRenderingCommands();
+	}
 
-		FSMAAEdgeDetectionCS::FParameters* PassParameters =
-			GraphBuilder.AllocParameters<FSMAAEdgeDetectionCS::FParameters>();
-		FRDGTextureUAVDesc OutputDesc(EdgesTexture);
+	FRHITexture* GetLookupTexture(UTexture2D* Texture)
+	{
+		FTextureResource* Resource = Texture ? Texture->GetResource() : nullptr;
+		return Resource ? Resource->GetTexture2DRHI() : nullptr;
+	}
+}
 
-		PassParameters->DepthTexture = SceneDepth;
-		PassParameters->PointTextureSampler = PointClampSampler;
-		PassParameters->BilinearTextureSampler = BilinearClampSampler;
+bool SMAAGPUEdgeDetection(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, FSMAACPUImage& OutEdges)
+{
+	check(SMAACPUSupportsEdgeMode(Frame, Settings.EdgeMode));
 
-		// Pass colour for Depth, Luma, and Colour
-		if (EdgeDetectorMode < ESMAAEdgeDetectors::Normal)
-		{
-			PassParameters->InputSceneColor = ColourSRV;
-		}
-		else if (ESMAAEdgeDetectors::Normal == EdgeDetectorMode)
-		{
-			PassParameters->InputSceneColor = GraphBuilder.CreateSRV(InOutInputs.SceneTextures.SceneTextures->GetContents()->GBufferATexture);
-		}
+	if (!SMAAGPU::IsAvailable())
+	{
+		return false;
+	}
 
-		PassParameters->InputDepth = DepthSRV;
-		PassParameters->ViewportMetrics = RTMetrics;
-		PassParameters->View = View.ViewUniformBuffer;
-		PassParameters->NormalisedCornerRounding = Rounding;
-		PassParameters->MaxSearchSteps = MaxStepOrth;
-		PassParameters->MaxDiagonalSearchSteps = MaxStepDiag;
-		PassParameters->Predicate = PredicateTexture;
-		PassParameters->AdaptationFactor = AdaptationFactor;
-		PassParameters->PredicationThreshold = PredicationThreshold;
-		PassParameters->PredicationScale = PredicationScale;
-		PassParameters->PredicationStrength = PredicationStrength;
-		PassParameters->EdgesTexture = GraphBuilder.CreateUAV(OutputDesc);
+	const FIntPoint Size(Frame.Colour.Width, Frame.Colour.Height);
+	OutEdges.Init(Size.X, Size.Y);
 
-		TShaderMapRef<FSMAAEdgeDetectionCS> ComputeShaderSMAAED(View.ShaderMap, PermutationVector);
-		FComputeShaderUtils::AddPass(
-			GraphBuilder, RDG_EVENT_NAME("SMAA/EdgeDetection (CS)"), ComputeShaderSMAAED, PassParameters,
-			FComputeShaderUtils::GetGroupCount(FIntVector(EdgesTexture->Desc.Extent.X, EdgesTexture->Desc.Extent.Y, 1),
-				FIntVector(FSMAAEdgeDetectionCS::ThreadgroupSizeX,
-					FSMAAEdgeDetectionCS::ThreadgroupSizeY,
-					FSMAAEdgeDetectionCS::ThreadgroupSizeZ)));
-	}
+	SMAAGPU::Run(TEXT("SMAAGPUEdgeDetection"), [&Settings, &Frame, Size](FRDGBuilder& GraphBuilder, FRDGBufferUAVRef)
+	{
+		FSMAAEdgeDetectionCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPresetConfigDim>(Settings.Quality);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAEdgeModeConfigDim>(Settings.EdgeMode);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPredicateConfigDim>(false);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAPackedInputDim>(false);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAEdgeStatsDim>(false);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAATileMaskDim>(false);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAGroupShapeDim>(ESMAAGroupShape::Group8x8);
+		PermutationVector.Set<FSMAAEdgeDetectionCS::FSMAAGroupSwizzleDim>(false);
+
+		FRDGTextureRef Edges = SMAAGPU::CreateOutput(GraphBuilder, Size, TEXT("SMAA.EdgesTexture"));
+
+		FSMAAEdgeDetectionCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSMAAEdgeDetectionCS::FParameters>();
+
+		// Normals go through the colour detector, as with the GBuffer
+		const FSMAACPUImage& Colour = Settings.EdgeMode == ESMAAEdgeDetectors::Normal ? Frame.Normal : Frame.Colour;
+		PassParameters->InputSceneColor = GraphBuilder.CreateSRV(SMAAGPU::Upload(GraphBuilder, Colour, TEXT("SMAA.GPUColour")));
+		PassParameters->InputDepth = GraphBuilder.CreateSRV(Frame.Depth.IsValid()
+			? SMAAGPU::Upload(GraphBuilder, Frame.Depth, TEXT("SMAA.GPUDepth"))
+			: GSystemTextures.GetBlackDummy(GraphBuilder));
+		PassParameters->Predicate = GraphBuilder.CreateSRV(GSystemTextures.GetWhiteDummy(GraphBuilder));
+		PassParameters->AdaptationFactor = Settings.AdaptationFactor;
+		PassParameters->SMAA = SMAAGPU::CreateUniformBuffer(GraphBuilder, Settings, Size);
+		PassParameters->EdgesTexture = GraphBuilder.CreateUAV(Edges);
+
+		TShaderMapRef<FSMAAEdgeDetectionCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SMAA/EdgeDetection (CS)"), ComputeShader, PassParameters,
+			GetSMAAGroupCount(Size, FSMAAGroupConfig(), PassParameters->GroupCount));
+
+		return Edges;
+	}, OutEdges);
+
+	return true;
+}
 
-	// Blend
+bool SMAAGPUBlendingWeights(const FSMAACPUSettings& Settings, const FSMAAGPUBlendingWeightsOptions& Options, UTexture2D* AreaTexture,
+	UTexture2D* SearchTexture, const FSMAACPUImage& Edges, FSMAACPUImage& OutBlend, uint32* OutSharedRunMismatches)
+{
+	FRHITexture* AreaTextureRHI = SMAAGPU::GetLookupTexture(AreaTexture);
+	FRHITexture* SearchTextureRHI = Options.bSearchALU ? nullptr : SMAAGPU::GetLookupTexture(SearchTexture);
+	if (!SMAAGPU::IsAvailable() || !AreaTextureRHI || (!Options.bSearchALU && !SearchTextureRHI))
 	{
-		FSMAABlendingWeightsCS::FPermutationDomain PermutationVector;
+		return false;
+	}
 
-		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAPresetConfigDim>(Preset);
+	const FIntPoint Size(Edges.Width, Edges.Height);
+	OutBlend.Init(Size.X, Size.Y);
 
-		FSMAABlendingWeightsCS::FParameters* PassParameters =
-			GraphBuilder.AllocParameters<FSMAABlendingWeightsCS::FParameters>();
+	// Validating shared runs counts into the edge stats, so they're only collected then
+	const bool bValidateSharedRuns = Options.SharedRuns == 2;
+	uint32 EdgeStats[uint32(ESMAAEdgeStat::Num)] = {};
 
-		PassParameters->DepthTexture = SceneDepth;
-		PassParameters->PointTextureSampler = TStaticSamplerState<SF_Point>::GetRHI();
-		PassParameters->BilinearTextureSampler = TStaticSamplerState<SF_Bilinear>::GetRHI();
-		PassParameters->AreaTexture = AreaTextureSRV;
-		PassParameters->InputEdges = GraphBuilder.CreateSRV(EdgesSRVDesc);
-		PassParameters->TemporalJitterPixels = FVector2f(View.TemporalJitterPixels);
-		PassParameters->SubpixelWeights = SubpixelJitterWeights[View.TemporalJitterIndex & 1];
-		PassParameters->SearchTexture = SearchTextureSRV;
-		PassParameters->ViewportMetrics = RTMetrics;
-		PassParameters->View = View.ViewUniformBuffer;
-		PassParameters->NormalisedCornerRounding = Rounding;
-		PassParameters->MaxSearchSteps = MaxStepOrth;
-		PassParameters->MaxDiagonalSearchSteps = MaxStepDiag;
-		PassParameters->BlendTexture = GraphBuilder.CreateUAV(Output.Texture);
+	SMAAGPU::Run(TEXT("SMAAGPUBlendingWeights"), [&Settings, &Options, &Edges, AreaTextureRHI, SearchTextureRHI, Size](FRDGBuilder& GraphBuilder, FRDGBufferUAVRef EdgeStats)
+	{
+		FSMAABlendingWeightsCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAPresetConfigDim>(Settings.Quality);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAEdgeStatsDim>(EdgeStats != nullptr);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAASearchALUDim>(Options.bSearchALU);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAATileMaskDim>(false);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAGroupShapeDim>(ESMAAGroupShape::Group8x8);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAAGroupSwizzleDim>(false);
+		PermutationVector.Set<FSMAABlendingWeightsCS::FSMAASharedRunsDim>(Options.SharedRuns);
+
+		FRDGTextureRef Blend = SMAAGPU::CreateOutput(GraphBuilder, Size, TEXT("SMAA.BlendTexture"));
+
+		FRDGTextureRef Area = GraphBuilder.RegisterExternalTexture(CreateRenderTarget(AreaTextureRHI, TEXT("SMAA.AreaTexture")));
+		FRDGTextureRef Search = SearchTextureRHI ? GraphBuilder.RegisterExternalTexture(CreateRenderTarget(SearchTextureRHI, TEXT("SMAA.SearchTexture"))) : nullptr;
+
+		FSMAABlendingWeightsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSMAABlendingWeightsCS::FParameters>();
+		PassParameters->InputEdges = GraphBuilder.CreateSRV(SMAAGPU::Upload(GraphBuilder, Edges, TEXT("SMAA.GPUEdges")));
+		PassParameters->SubpixelWeights = Settings.SubsampleIndices;
+		PassParameters->SMAA = SMAAGPU::CreateUniformBuffer(GraphBuilder, Settings, Size, Area, Search);
+		PassParameters->BlendTexture = GraphBuilder.CreateUAV(Blend);
+		PassParameters->EdgeStats = EdgeStats;
+
+		TShaderMapRef<FSMAABlendingWeightsCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SMAA/BlendWeights (CS)"), ComputeShader, PassParameters,
+			GetSMAAGroupCount(Size, FSMAAGroupConfig(), PassParameters->GroupCount));
+
+		return Blend;
+	}, OutBlend, bValidateSharedRuns ? EdgeStats : nullptr);
+
+	if (OutSharedRunMismatches)
+	{
+		*OutSharedRunMismatches = EdgeStats[uint32(ESMAAEdgeStat::SharedRunMismatches)];
+	}
 
-		TShaderMapRef<FSMAABlendingWeightsCS> ComputeShaderSMAABW(View.ShaderMap, PermutationVector);
-		FComputeShaderUtils::AddPass(
-			GraphBuilder, RDG_EVENT_NAME("SMAA/BlendWeights (CS)"), ComputeShaderSMAABW, PassParameters,
-			FComputeShaderUtils::GetGroupCount(FIntVector(EdgesTexture->Desc.Extent.X, EdgesTexture->Desc.Extent.Y, 1),
-				FIntVector(FSMAABlendingWeightsCS::ThreadgroupSizeX,
-					FSMAABlendingWeightsCS::ThreadgroupSizeY,
-					FSMAABlendingWeightsCS::ThreadgroupSizeZ)));
+	return true;
+}
+
+bool SMAAGPUNeighbourhoodBlending(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, const FSMAACPUImage& Blend, FSMAACPUImage& OutColour)
+{
+	if (!SMAAGPU::IsAvailable())
+	{
+		return false;
 	}
 
-	return Output;
+	const FIntPoint Size(Frame.Colour.Width, Frame.Colour.Height);
+	OutColour.Init(Size.X, Size.Y);
+
+	SMAAGPU::Run(TEXT("SMAAGPUNeighbourhoodBlending"), [&Settings, &Frame, &Blend, Size](FRDGBuilder& GraphBuilder, FRDGBufferUAVRef)
+	{
+		FSMAANeighbourhoodBlendingCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAPresetConfigDim>(Settings.Quality);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAReprojectionDim>(false);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAATileMaskDim>(false);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAGroupShapeDim>(ESMAAGroupShape::Group8x8);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAGroupSwizzleDim>(false);
+		PermutationVector.Set<FSMAANeighbourhoodBlendingCS::FSMAAOutputTargetDim>(ESMAAOutputTarget::Own);
+
+		FRDGTextureRef Output = SMAAGPU::CreateOutput(GraphBuilder, Size, TEXT("SMAA.Output"));
+		FRDGTextureSRVRef Black = GraphBuilder.CreateSRV(GSystemTextures.GetBlackDummy(GraphBuilder));
+
+		FSMAANeighbourhoodBlendingCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSMAANeighbourhoodBlendingCS::FParameters>();
+		PassParameters->SceneColour = GraphBuilder.CreateSRV(SMAAGPU::Upload(GraphBuilder, Frame.Colour, TEXT("SMAA.GPUColour")));
+		PassParameters->InputBlend = GraphBuilder.CreateSRV(SMAAGPU::Upload(GraphBuilder, Blend, TEXT("SMAA.GPUBlend")));
+		PassParameters->SceneDepth = Black;
+		PassParameters->VelocityTexture = Black;
+		PassParameters->SMAA = SMAAGPU::CreateUniformBuffer(GraphBuilder, Settings, Size);
+		PassParameters->FinalFrame = GraphBuilder.CreateUAV(Output);
+		PassParameters->OutputRect = FIntVector4(0, 0, Size.X, Size.Y);
+
+		TShaderMapRef<FSMAANeighbourhoodBlendingCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SMAA/NeighbourhoodBlending (CS)"), ComputeShader, PassParameters,
+			GetSMAAGroupCount(Size, FSMAAGroupConfig(), PassParameters->GroupCount));
+
+		return Output;
+	}, OutColour);
+
+	return true;
 }
@@ -2,41 +2,53 @@
 
 #pragma once
 
+#include "Containers/StaticArray.h"
 #include "ScreenPass.h"
+#include "SMAATypes.h"
 
-//DEFINE_LOG_CATEGORY_STATIC(LogSMAA, Warning, All);
+DECLARE_LOG_CATEGORY_EXTERN(LogSMAA, Log, All);
 
-enum class ESMAAEdgeDetectors : uint8
+DECLARE_STATS_GROUP(TEXT("SMAA"), STATGROUP_SMAA, STATCAT_Advanced);
+
+// Thread group shapes the compute passes can be compiled with, see r.SMAA.GroupShape.*
+enum class ESMAAGroupShape : uint8
 {
-	Depth,
-	Luminance,
-	Colour,
-	Normal,
+	Group8x8,
+	Group16x16,
+	Group32x2,
+	Group8x4,
 
-	MAX UMETA(HIDDEN)
+	MAX
 };
 
-enum class ESMAAPreset : uint8
+// The compute passes whose thread groups can be configured
+enum class ESMAAComputePass : uint8
 {
-	Low,
-	Medium,
-	High,
-	Ultra,
+	EdgeDetection,
+	BlendWeights,
+	NeighbourhoodBlending,
+	TemporalResolve,
 
-	MAX UMETA(HIDDEN)
+	MAX
 };
 
-enum class ESMAAPredicationTexture : uint8
+struct FSMAAGroupConfig
 {
-	None,
-	Depth,
-	WorldNormal,
-	MRS,
+	ESMAAGroupShape Shape = ESMAAGroupShape::Group8x8;
 
-	MAX UMETA(HIDDEN)
+	// Walk the thread groups in Morton order within blocks of 8x8 groups, rather than row by row
+	bool bSwizzle = false;
 };
 
+FIntPoint GetSMAAGroupSize(ESMAAGroupShape Shape);
+const TCHAR* GetSMAAGroupShapeName(ESMAAGroupShape Shape);
+const TCHAR* GetSMAAComputePassName(ESMAAComputePass Pass);
+
+// Whether shapes other than unswizzled 8x8 are compiled, see r.SMAA.CompileGroupShapes
+bool AreSMAAGroupShapesCompiled();
+
 ESMAAPreset GetSMAAPreset();
+bool GetSMAATemporal();
 ESMAAEdgeDetectors GetSMAAEdgeDetectors();
 ESMAAPredicationTexture GetPredicateSource();
 
@@ -50,11 +62,22 @@ float GetSMAAPredicationThreshold();
 float GetSMAAPredicationScale();
 float GetSMAAPredicationStrength();
 float GetSMAATemporalHistoryBias();
+bool GetSMAAPackedEdgeInput();
+FIntPoint GetSMAATileOverlap();
+uint8 GetSMAARasterPath();
+bool GetSMAASearchALU();
+uint8 GetSMAASharedRuns();
+bool GetSMAAEdgeTileCulling();
+float GetSMAAHistoryHeadroom();
+uint8 GetSMAASkipStencil();
+uint8 GetSMAAStaticReuse();
+FSMAAGroupConfig GetSMAAGroupConfig(ESMAAComputePass Pass);
 
 
 struct FSMAAInputs
 {
-	// [Optional] Render to the specified output. If invalid, a new texture is created and returned.
+	// [Optional] Render to the specified output. If invalid, or the last pass can't write it (a different size, or
+	// a format compute can't store to), a new texture is created and returned for the engine to copy in.
 	FScreenPassRenderTarget OverrideOutput;
 
 	// [Required] HDR scene color to filter.
@@ -103,8 +126,50 @@ struct FSMAAInputs
 
 	float TemporalHistoryBias = 0.5f;
 
+	// Pack luma and the predicate into a single texture before luminance edge detection
+	bool bPackedEdgeInput = false;
+
+	// SMAA T2x. When off, neighbourhood blending writes the output directly and no history is kept
+	bool bTemporal = true;
+
+	// Pixels on each side of the view rect that only provide context, see FSMAAViewSettings::TileOverlap
+	FIntPoint TileOverlap = FIntPoint::ZeroValue;
+
+	// r.SMAA.RasterPath: 0 compute, 1 pixel shaders with stencil, 2 pixel shaders on mobile platforms only
+	uint8 RasterPath = 0;
+
+	// Decode the last search step arithmetically, so the search texture isn't needed
+	bool bSearchALU = true;
+
+	// Find the ends of lines once per thread group row and column rather than per pixel, and with 2 check them against
+	// the per pixel searches, see r.SMAA.SharedRuns
+	uint8 SharedRuns = 0;
+
+	// Skip edge detection and blend weights on tiles whose depth range rules out edges. Depth and normal edges only
+	bool bEdgeTileCulling = false;
+
+	// Scale on the T2x history's extent when it has to grow, so small resolution changes don't reallocate it
+	float HistoryHeadroom = 1.f;
+
+	// Pixels SMAA leaves untouched, see FSMAAViewSettings::SkipStencil and SkipRects
+	uint8 SkipStencil = 0;
+	TArray<FIntRect> SkipRects;
+
+	// Keep the edges and blend weights intact and hand them to FSMAAViewData::PublishedTextures
+	bool bPublishTextures = false;
+
+	// r.SMAA.StaticReuse: 0 off, 1 reuse the last output while the view and its velocity are still, 2 also while the
+	// scene colour hashes the same. See FSMAAStaticFrame
+	uint8 StaticReuse = 0;
+
+	// Thread group shape and order of each compute pass
+	TStaticArray<FSMAAGroupConfig, uint32(ESMAAComputePass::MAX)> GroupConfigs;
+
 };
 
+// Snapshot of every SMAA cvar, taken once per view family. Scene textures are left unset.
+FSMAAInputs GetSMAAInputsFromCVars();
+
 FScreenPassTexture AddSMAAPasses(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, const struct FPostProcessMaterialInputs& InOutInputs, TSharedRef<struct FSMAAViewData> ViewData);
 
 FScreenPassTexture AddVisualizeSMAAPasses(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, const struct FPostProcessMaterialInputs& InOutInputs, TSharedRef<struct FSMAAViewData> ViewData);
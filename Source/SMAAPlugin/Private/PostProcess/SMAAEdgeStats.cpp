@@ -0,0 +1,133 @@
+#include "PostProcess/SMAAEdgeStats.h"
+
+#include "PostProcess/PostProcessSMAA.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIGPUReadback.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+TAutoConsoleVariable<int32> CVarSMAAEdgeStats(
+	TEXT("r.SMAA.EdgeStats"), 0,
+	TEXT("Counts edge pixels, diagonal hits and search lengths on the GPU and publishes them to 'stat SMAA' and CSV.\n")
+		TEXT("Always on with r.SMAA.SharedRuns 2.\n")
+		TEXT(" 0 - off (Default)\n")
+			TEXT(" 1 - on"),
+	ECVF_RenderThreadSafe);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pixels"), STAT_SMAAPixels, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Edge Pixels"), STAT_SMAAEdgePixels, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Diagonal Hits"), STAT_SMAADiagonalHits, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Limit Hits"), STAT_SMAASearchLimitHits, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Length 1-2"), STAT_SMAASearchLength0, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Length 3-4"), STAT_SMAASearchLength1, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Length 5-8"), STAT_SMAASearchLength2, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Length 9-16"), STAT_SMAASearchLength3, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Length 17-32"), STAT_SMAASearchLength4, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Length 33-64"), STAT_SMAASearchLength5, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Length 65-128"), STAT_SMAASearchLength6, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Search Length 129+"), STAT_SMAASearchLength7, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Shared Run Mismatches"), STAT_SMAASharedRunMismatches, STATGROUP_SMAA);
+
+CSV_DEFINE_CATEGORY(SMAA, true);
+
+bool IsSMAAEdgeStatsEnabled()
+{
+	return CVarSMAAEdgeStats.GetValueOnRenderThread() != 0;
+}
+
+FSMAAEdgeStatsReadback::~FSMAAEdgeStatsReadback()
+{
+	for (FPendingReadback& Entry : Pending)
+	{
+		delete Entry.Readback;
+	}
+}
+
+FRDGBufferRef FSMAAEdgeStatsReadback::CreateStatsBuffer(FRDGBuilder& GraphBuilder)
+{
+	FRDGBufferRef StatsBuffer = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), uint32(ESMAAEdgeStat::Num)),
+		TEXT("SMAA.EdgeStats"));
+
+	AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(StatsBuffer, PF_R32_UINT), 0u);
+
+	return StatsBuffer;
+}
+
+void FSMAAEdgeStatsReadback::EnqueueReadback(FRDGBuilder& GraphBuilder, FRDGBufferRef StatsBuffer, FIntPoint Extent)
+{
+	FPendingReadback& Entry = Pending[WriteIndex];
+
+	// All slots are still waiting on the GPU, drop this frame rather than stall
+	if (Entry.bInFlight)
+	{
+		return;
+	}
+
+	if (!Entry.Readback)
+	{
+		Entry.Readback = new FRHIGPUBufferReadback(TEXT("SMAA.EdgeStatsReadback"));
+	}
+
+	AddEnqueueCopyPass(GraphBuilder, Entry.Readback, StatsBuffer, uint32(ESMAAEdgeStat::Num) * sizeof(uint32));
+
+	Entry.Extent = Extent;
+	Entry.bInFlight = true;
+	WriteIndex = (WriteIndex + 1) % MaxPendingReadbacks;
+}
+
+void FSMAAEdgeStatsReadback::Poll()
+{
+	while (Pending[ReadIndex].bInFlight && Pending[ReadIndex].Readback->IsReady())
+	{
+		FPendingReadback& Entry = Pending[ReadIndex];
+
+		uint32 Stats[uint32(ESMAAEdgeStat::Num)];
+		const uint32* Data = static_cast<const uint32*>(Entry.Readback->Lock(sizeof(Stats)));
+		FMemory::Memcpy(Stats, Data, sizeof(Stats));
+		Entry.Readback->Unlock();
+
+		const uint32 NumPixels = uint32(Entry.Extent.X) * uint32(Entry.Extent.Y);
+		const uint32* Histogram = &Stats[uint32(ESMAAEdgeStat::SearchHistogram)];
+
+		INC_DWORD_STAT_BY(STAT_SMAAPixels, NumPixels);
+		INC_DWORD_STAT_BY(STAT_SMAAEdgePixels, Stats[uint32(ESMAAEdgeStat::EdgePixels)]);
+		INC_DWORD_STAT_BY(STAT_SMAADiagonalHits, Stats[uint32(ESMAAEdgeStat::DiagonalHits)]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLimitHits, Stats[uint32(ESMAAEdgeStat::SearchLimitHits)]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLength0, Histogram[0]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLength1, Histogram[1]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLength2, Histogram[2]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLength3, Histogram[3]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLength4, Histogram[4]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLength5, Histogram[5]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLength6, Histogram[6]);
+		INC_DWORD_STAT_BY(STAT_SMAASearchLength7, Histogram[7]);
+		INC_DWORD_STAT_BY(STAT_SMAASharedRunMismatches, Stats[uint32(ESMAAEdgeStat::SharedRunMismatches)]);
+
+		CSV_CUSTOM_STAT(SMAA, Pixels, int32(NumPixels), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, EdgePixels, int32(Stats[uint32(ESMAAEdgeStat::EdgePixels)]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, DiagonalHits, int32(Stats[uint32(ESMAAEdgeStat::DiagonalHits)]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLimitHits, int32(Stats[uint32(ESMAAEdgeStat::SearchLimitHits)]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLength1to2, int32(Histogram[0]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLength3to4, int32(Histogram[1]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLength5to8, int32(Histogram[2]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLength9to16, int32(Histogram[3]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLength17to32, int32(Histogram[4]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLength33to64, int32(Histogram[5]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLength65to128, int32(Histogram[6]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SearchLength129Plus, int32(Histogram[7]), ECsvCustomStatOp::Accumulate);
+		CSV_CUSTOM_STAT(SMAA, SharedRunMismatches, int32(Stats[uint32(ESMAAEdgeStat::SharedRunMismatches)]), ECsvCustomStatOp::Accumulate);
+
+		// Only ever non-zero with r.SMAA.SharedRuns 2, and any at all is a bug in the shared runs
+		static bool bWarnedMismatch = false;
+		if (!bWarnedMismatch && Stats[uint32(ESMAAEdgeStat::SharedRunMismatches)] > 0)
+		{
+			UE_LOG(LogSMAA, Warning, TEXT("SMAA shared runs disagreed with the per pixel searches on %u pixels of a %dx%d frame."),
+				Stats[uint32(ESMAAEdgeStat::SharedRunMismatches)], Entry.Extent.X, Entry.Extent.Y);
+			bWarnedMismatch = true;
+		}
+
+		Entry.bInFlight = false;
+		ReadIndex = (ReadIndex + 1) % MaxPendingReadbacks;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "RenderGraphResources.h"
+
+class FRHIGPUBufferReadback;
+
+// Layout of the edge statistics buffer. Must match SMAA_EDGE_STAT_* in SMAA_UE5.usf
+enum class ESMAAEdgeStat : uint32
+{
+	EdgePixels,
+	DiagonalHits,
+	SearchLimitHits,
+	SearchHistogram,
+
+	SearchHistogramBuckets = 8,
+
+	// Pixels whose shared runs end elsewhere than their own searches, with r.SMAA.SharedRuns 2
+	SharedRunMismatches = SearchHistogram + SearchHistogramBuckets,
+
+	Num
+};
+
+bool IsSMAAEdgeStatsEnabled();
+
+/**
+ * Collects per-view edge coverage counts written by the edge detection and blend weight passes,
+ * and reads them back a few frames later without stalling. Results are published through
+ * "stat SMAA" and the SMAA CSV category.
+ */
+class FSMAAEdgeStatsReadback
+{
+public:
+	~FSMAAEdgeStatsReadback();
+
+	// Creates and clears the stats buffer for this frame's passes
+	static FRDGBufferRef CreateStatsBuffer(FRDGBuilder& GraphBuilder);
+
+	// Queues a copy of the stats buffer once all passes writing to it are done
+	void EnqueueReadback(FRDGBuilder& GraphBuilder, FRDGBufferRef StatsBuffer, FIntPoint Extent);
+
+	// Publishes any readback which has completed since the last call
+	void Poll();
+
+private:
+	struct FPendingReadback
+	{
+		FRHIGPUBufferReadback* Readback = nullptr;
+		FIntPoint Extent = FIntPoint::ZeroValue;
+		bool bInFlight = false;
+	};
+
+	static constexpr int32 MaxPendingReadbacks = 4;
+	FPendingReadback Pending[MaxPendingReadbacks];
+	int32 WriteIndex = 0;
+	int32 ReadIndex = 0;
+};
@@ -0,0 +1,253 @@
+#include "PostProcess/SMAAGroupShapeBenchmark.h"
+
+#include "RenderGraphBuilder.h"
+#include "RenderingThread.h"
+#include "DynamicRHI.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static FAutoConsoleCommand CmdSMAABenchmarkGroupShapes(
+	TEXT("r.SMAA.BenchmarkGroupShapes"),
+	TEXT("Times the SMAA compute passes with every thread group shape, with and without swizzling, over live frames.\n")
+	TEXT("Logs the GPU time of each pass per configuration and the fastest per pass, and writes them to\n")
+	TEXT("Saved/Profiling/SMAA. Needs r.SMAA.CompileGroupShapes 1 and the compute path.\n")
+	TEXT("r.SMAA.BenchmarkGroupShapes [FramesPerConfig=120]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 FramesPerConfig = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 120;
+
+		ENQUEUE_RENDER_COMMAND(SMAABenchmarkGroupShapes)([FramesPerConfig](FRHICommandListImmediate&)
+		{
+			FSMAAGroupShapeBenchmark::Get().Start(FramesPerConfig);
+		});
+	}));
+
+FSMAAGroupShapeBenchmark& FSMAAGroupShapeBenchmark::Get()
+{
+	check(IsInRenderingThread());
+
+	static FSMAAGroupShapeBenchmark Benchmark;
+	return Benchmark;
+}
+
+FSMAAGroupConfig FSMAAGroupShapeBenchmark::GetConfig(int32 Index)
+{
+	FSMAAGroupConfig Config;
+	Config.Shape = ESMAAGroupShape(Index / 2);
+	Config.bSwizzle = (Index & 1) != 0;
+	return Config;
+}
+
+void FSMAAGroupShapeBenchmark::Start(int32 InFramesPerConfig)
+{
+	if (!AreSMAAGroupShapesCompiled())
+	{
+		UE_LOG(LogSMAA, Warning, TEXT("SMAA group shape benchmark needs r.SMAA.CompileGroupShapes 1, set in an ini before startup."));
+		return;
+	}
+
+	if (IsRunning())
+	{
+		UE_LOG(LogSMAA, Warning, TEXT("SMAA group shape benchmark is already running."));
+		return;
+	}
+
+	if (!QueryPool.IsValid())
+	{
+		QueryPool = RHICreateRenderQueryPool(RQT_AbsoluteTime);
+	}
+
+	FMemory::Memzero(TotalMicroseconds);
+	FMemory::Memzero(NumSamples);
+	FramesPerConfig = InFramesPerConfig;
+	FrameInConfig = 0;
+	ConfigIndex = 0;
+
+	UE_LOG(LogSMAA, Display, TEXT("SMAA group shape benchmark started, %d configurations of %d frames."), NumConfigs, FramesPerConfig);
+}
+
+void FSMAAGroupShapeBenchmark::BeginViewFamily(FSMAAInputs& InOutInputs)
+{
+	Poll();
+
+	if (!IsRunning())
+	{
+		return;
+	}
+
+	if (ConfigIndex < NumConfigs && ++FrameInConfig > WarmupFrames + FramesPerConfig)
+	{
+		++ConfigIndex;
+		FrameInConfig = 1;
+	}
+
+	// Done, wait for the last timings before reporting
+	if (ConfigIndex >= NumConfigs)
+	{
+		if (Pending.Num() == 0)
+		{
+			Report();
+			ConfigIndex = INDEX_NONE;
+		}
+		return;
+	}
+
+	for (FSMAAGroupConfig& GroupConfig : InOutInputs.GroupConfigs)
+	{
+		GroupConfig = GetConfig(ConfigIndex);
+	}
+}
+
+void FSMAAGroupShapeBenchmark::AddTimestamp(FRDGBuilder& GraphBuilder, ESMAAComputePass Pass)
+{
+	if (!IsRunning() || ConfigIndex >= NumConfigs || FrameInConfig <= WarmupFrames)
+	{
+		return;
+	}
+
+	if (!Current.IsValid())
+	{
+		Current = MakeUnique<FViewTimestamps>();
+		Current->ConfigIndex = ConfigIndex;
+	}
+
+	FRHIPooledRenderQuery& PooledQuery = Current->Queries[int32(Pass)];
+	PooledQuery = QueryPool->AllocateQuery();
+
+	FRHIRenderQuery* Query = PooledQuery.GetQuery();
+	GraphBuilder.AddPass(RDG_EVENT_NAME("SMAA/Timestamp"), ERDGPassFlags::NeverCull, [Query](FRHICommandListImmediate& RHICmdList)
+	{
+		RHICmdList.EndRenderQuery(Query);
+	});
+}
+
+void FSMAAGroupShapeBenchmark::EndView()
+{
+	if (Current.IsValid())
+	{
+		Pending.Add(MoveTemp(Current));
+	}
+}
+
+void FSMAAGroupShapeBenchmark::Poll()
+{
+	while (Pending.Num() > 0)
+	{
+		FViewTimestamps& Timestamps = *Pending[0];
+
+		uint64 Microseconds[NumTimestamps] = {};
+		for (int32 Index = 0; Index < NumTimestamps; ++Index)
+		{
+			FRHIRenderQuery* Query = Timestamps.Queries[Index].GetQuery();
+			if (Query && !RHIGetRenderQueryResult(Query, Microseconds[Index], false))
+			{
+				// Still in flight, and so is everything queued after it
+				return;
+			}
+		}
+
+		// A pass ends where the next timestamped one starts. T2x's resolve doesn't run on camera cuts or in 1x
+		for (int32 Pass = 0; Pass < int32(ESMAAComputePass::MAX); ++Pass)
+		{
+			if (!Timestamps.Queries[Pass].GetQuery())
+			{
+				continue;
+			}
+
+			for (int32 Next = Pass + 1; Next < NumTimestamps; ++Next)
+			{
+				if (Timestamps.Queries[Next].GetQuery())
+				{
+					TotalMicroseconds[Timestamps.ConfigIndex][Pass] += double(Microseconds[Next] - Microseconds[Pass]);
+					NumSamples[Timestamps.ConfigIndex][Pass]++;
+					break;
+				}
+			}
+		}
+
+		Pending.RemoveAt(0);
+	}
+}
+
+void FSMAAGroupShapeBenchmark::Report() const
+{
+	FString Csv = TEXT("Shape,Swizzle");
+	for (int32 Pass = 0; Pass < int32(ESMAAComputePass::MAX); ++Pass)
+	{
+		Csv += FString::Printf(TEXT(",%sMs"), GetSMAAComputePassName(ESMAAComputePass(Pass)));
+	}
+	Csv += LINE_TERMINATOR;
+
+	UE_LOG(LogSMAA, Display, TEXT("SMAA group shape benchmark on %s (%s), average ms per view:"), GRHIAdapterName.IsEmpty() ? TEXT("unknown adapter") : *GRHIAdapterName, GDynamicRHI ? GDynamicRHI->GetName() : TEXT("no RHI"));
+	UE_LOG(LogSMAA, Display, TEXT("  %-14s %13s %13s %13s %13s"), TEXT("Shape"), TEXT("EdgeDetect"), TEXT("BlendWeights"), TEXT("Blending"), TEXT("Resolve"));
+
+	int32 Fastest[int32(ESMAAComputePass::MAX)];
+	double FastestMs[int32(ESMAAComputePass::MAX)];
+	for (int32 Pass = 0; Pass < int32(ESMAAComputePass::MAX); ++Pass)
+	{
+		Fastest[Pass] = INDEX_NONE;
+		FastestMs[Pass] = DBL_MAX;
+	}
+
+	for (int32 Config = 0; Config < NumConfigs; ++Config)
+	{
+		const FSMAAGroupConfig GroupConfig = GetConfig(Config);
+		const FString ConfigName = FString::Printf(TEXT("%s%s"), GetSMAAGroupShapeName(GroupConfig.Shape), GroupConfig.bSwizzle ? TEXT(" swizzled") : TEXT(""));
+
+		FString Row;
+		Csv += FString::Printf(TEXT("%s,%d"), GetSMAAGroupShapeName(GroupConfig.Shape), GroupConfig.bSwizzle ? 1 : 0);
+		for (int32 Pass = 0; Pass < int32(ESMAAComputePass::MAX); ++Pass)
+		{
+			if (NumSamples[Config][Pass] == 0)
+			{
+				Row += FString::Printf(TEXT(" %13s"), TEXT("-"));
+				Csv += TEXT(",");
+				continue;
+			}
+
+			const double Ms = TotalMicroseconds[Config][Pass] / NumSamples[Config][Pass] / 1000.0;
+			Row += FString::Printf(TEXT(" %13.4f"), Ms);
+			Csv += FString::Printf(TEXT(",%.4f"), Ms);
+
+			if (Ms < FastestMs[Pass])
+			{
+				FastestMs[Pass] = Ms;
+				Fastest[Pass] = Config;
+			}
+		}
+		Csv += LINE_TERMINATOR;
+
+		UE_LOG(LogSMAA, Display, TEXT("  %-14s%s"), *ConfigName, *Row);
+	}
+
+	// As cvars for the platform's device profile
+	static const TCHAR* ShapeCVarNames[] = {
+		TEXT("r.SMAA.GroupShape.EdgeDetection"),
+		TEXT("r.SMAA.GroupShape.BlendWeights"),
+		TEXT("r.SMAA.GroupShape.Blending"),
+		TEXT("r.SMAA.GroupShape.Resolve")
+	};
+	static_assert(UE_ARRAY_COUNT(ShapeCVarNames) == int32(ESMAAComputePass::MAX), "Missing group shape cvar");
+
+	int32 SwizzleMask = 0;
+	UE_LOG(LogSMAA, Display, TEXT("  Fastest:"));
+	for (int32 Pass = 0; Pass < int32(ESMAAComputePass::MAX); ++Pass)
+	{
+		if (Fastest[Pass] == INDEX_NONE)
+		{
+			continue;
+		}
+
+		const FSMAAGroupConfig GroupConfig = GetConfig(Fastest[Pass]);
+		SwizzleMask |= GroupConfig.bSwizzle ? (1 << Pass) : 0;
+		UE_LOG(LogSMAA, Display, TEXT("    %s=%d ; %s, %.4f ms"), ShapeCVarNames[Pass], int32(GroupConfig.Shape), GetSMAAGroupShapeName(GroupConfig.Shape), FastestMs[Pass]);
+	}
+	UE_LOG(LogSMAA, Display, TEXT("    r.SMAA.GroupSwizzle=%d"), SwizzleMask);
+
+	const FString Path = FPaths::ProfilingDir() / TEXT("SMAA") / FString::Printf(TEXT("GroupShapes-%s.csv"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveStringToFile(Csv, *Path))
+	{
+		UE_LOG(LogSMAA, Display, TEXT("  Written to %s"), *Path);
+	}
+}
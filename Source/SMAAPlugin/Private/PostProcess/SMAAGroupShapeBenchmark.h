@@ -0,0 +1,62 @@
+#pragma once
+
+#include "RenderGraphResources.h"
+#include "RHIResources.h"
+#include "PostProcess/PostProcessSMAA.h"
+
+/**
+ * Times the compute passes on the GPU under every thread group shape, with and without swizzling, and reports the
+ * fastest per pass for the running platform. Runs over live frames, one configuration at a time, applying the same
+ * configuration to all four passes. See r.SMAA.BenchmarkGroupShapes. Render thread only.
+ */
+class FSMAAGroupShapeBenchmark
+{
+public:
+	static FSMAAGroupShapeBenchmark& Get();
+
+	void Start(int32 InFramesPerConfig);
+
+	bool IsRunning() const
+	{
+		return ConfigIndex != INDEX_NONE;
+	}
+
+	// Collects finished timings, moves on to the next configuration when due and applies it. Once per view family
+	void BeginViewFamily(FSMAAInputs& InOutInputs);
+
+	// Timestamps the start of Pass for the view being rendered. ESMAAComputePass::MAX marks the end of its last pass
+	void AddTimestamp(FRDGBuilder& GraphBuilder, ESMAAComputePass Pass);
+
+	// Closes the view's timestamps, after its last pass
+	void EndView();
+
+private:
+	static constexpr int32 NumConfigs = int32(ESMAAGroupShape::MAX) * 2;
+	static constexpr int32 NumTimestamps = int32(ESMAAComputePass::MAX) + 1;
+
+	// Frames dropped after switching configuration, while new permutations load
+	static constexpr int32 WarmupFrames = 8;
+
+	static FSMAAGroupConfig GetConfig(int32 Index);
+
+	struct FViewTimestamps
+	{
+		int32 ConfigIndex = INDEX_NONE;
+		FRHIPooledRenderQuery Queries[NumTimestamps];
+	};
+
+	void Poll();
+	void Report() const;
+
+	FRenderQueryPoolRHIRef QueryPool;
+	TArray<TUniquePtr<FViewTimestamps>> Pending;
+	TUniquePtr<FViewTimestamps> Current;
+
+	int32 ConfigIndex = INDEX_NONE;
+	int32 FramesPerConfig = 0;
+	int32 FrameInConfig = 0;
+
+	// Microseconds per configuration and pass, and how many views were timed
+	double TotalMicroseconds[NumConfigs][int32(ESMAAComputePass::MAX)] = {};
+	int32 NumSamples[NumConfigs][int32(ESMAAComputePass::MAX)] = {};
+};
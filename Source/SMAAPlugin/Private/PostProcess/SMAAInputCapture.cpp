@@ -0,0 +1,331 @@
+#include "PostProcess/SMAAInputCapture.h"
+
+#include "Async/Async.h"
+#include "Dom/JsonObject.h"
+#include "DynamicRHI.h"
+#include "GlobalShader.h"
+#include "ImagePixelData.h"
+#include "ImageWriteQueue.h"
+#include "ImageWriteTask.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+#include "PostProcess/PostProcessMaterialInputs.h"
+#include "PostProcess/SMAAMemoryStats.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIGPUReadback.h"
+#include "ScenePrivate.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "ShaderParameterStruct.h"
+#include "SystemTextures.h"
+
+static FAutoConsoleCommand CmdSMAACaptureInputs(
+	TEXT("r.SMAA.CaptureInputs"),
+	TEXT("Captures the scene colour, depth, velocity, GBufferA and B, settings and jitter SMAA is given, for every view of\n")
+	TEXT("the next frames, to Saved/SMAA/Captures as EXRs and JSON. Replay the bundle with the SMAABenchmark or\n")
+	TEXT("SMAAQuality commandlets (-Input=<Bundle> -CaptureSettings).\n")
+	TEXT("r.SMAA.CaptureInputs [Frames=1]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const int32 NumFrames = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1;
+
+		// Only loadable from the game thread
+		IImageWriteQueue* WriteQueue = &FModuleManager::LoadModuleChecked<IImageWriteQueueModule>("ImageWriteQueue").GetWriteQueue();
+
+		ENQUEUE_RENDER_COMMAND(SMAACaptureInputs)([NumFrames, WriteQueue](FRHICommandListImmediate&)
+		{
+			FSMAAInputCapture::Get().Start(NumFrames, WriteQueue);
+		});
+	}));
+
+/**
+ * Copies the view rect of every input into float targets laid out as the CPU port expects them
+ */
+class FSMAAInputCaptureCS : public FGlobalShader
+{
+public:
+	static const int ThreadgroupSizeX = 8;
+	static const int ThreadgroupSizeY = 8;
+	static const int ThreadgroupSizeZ = 1;
+
+	DECLARE_GLOBAL_SHADER(FSMAAInputCaptureCS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAAInputCaptureCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneColor)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneDepth)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneVelocity)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, GBufferA)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, GBufferB)
+	SHADER_PARAMETER(FIntPoint, ViewMin)
+	SHADER_PARAMETER(FUintVector2, ViewSize)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, CapturedColour)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, CapturedDepth)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, CapturedVelocity)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, CapturedNormal)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, CapturedGBufferA)
+	SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D, CapturedGBufferB)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), ThreadgroupSizeX);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), ThreadgroupSizeY);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), ThreadgroupSizeZ);
+		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAAInputCaptureCS, "/SMAAPlugin/Private/SMAA_InputCapture.usf",
+	"InputCaptureCS", SF_Compute);
+
+namespace SMAAInputCapture
+{
+	// Companion suffixes the SMAA commandlets look for, by ECapturedTexture
+	const TCHAR* Suffixes[] = { TEXT(""), TEXT("_depth"), TEXT("_velocity"), TEXT("_normal"), TEXT("_gbuffera"), TEXT("_gbufferb") };
+
+	// As the commandlets name them
+	const TCHAR* PresetNames[] = { TEXT("Low"), TEXT("Medium"), TEXT("High"), TEXT("Ultra"), TEXT("Custom") };
+	const TCHAR* EdgeDetectorNames[] = { TEXT("Depth"), TEXT("Luminance"), TEXT("Colour"), TEXT("Normal") };
+	const TCHAR* PredicationNames[] = { TEXT("None"), TEXT("Depth"), TEXT("WorldNormal"), TEXT("MRS") };
+
+	template <typename PixelType>
+	TUniquePtr<FImagePixelData> ReadPixels(FRHIGPUTextureReadback& Readback, FIntPoint Size)
+	{
+		TArray64<PixelType> Pixels;
+		Pixels.SetNumUninitialized(int64(Size.X) * Size.Y);
+
+		int32 RowPitchInPixels = 0;
+		const PixelType* Data = static_cast<const PixelType*>(Readback.Lock(RowPitchInPixels));
+		for (int32 Y = 0; Y < Size.Y; ++Y)
+		{
+			FMemory::Memcpy(&Pixels[int64(Y) * Size.X], Data + int64(Y) * RowPitchInPixels, Size.X * sizeof(PixelType));
+		}
+		Readback.Unlock();
+
+		return MakeUnique<TImagePixelData<PixelType>>(Size, MoveTemp(Pixels));
+	}
+
+	TSharedRef<FJsonObject> DescribeInputs(const FSMAAInputs& Inputs)
+	{
+		TSharedRef<FJsonObject> Settings = MakeShared<FJsonObject>();
+		Settings->SetStringField(TEXT("Preset"), PresetNames[FMath::Min(uint8(Inputs.Quality), uint8(UE_ARRAY_COUNT(PresetNames) - 1))]);
+		Settings->SetStringField(TEXT("EdgeDetector"), EdgeDetectorNames[FMath::Min(uint8(Inputs.EdgeMode), uint8(UE_ARRAY_COUNT(EdgeDetectorNames) - 1))]);
+		Settings->SetStringField(TEXT("Predication"), PredicationNames[FMath::Min(uint8(Inputs.PredicationSource), uint8(UE_ARRAY_COUNT(PredicationNames) - 1))]);
+		Settings->SetBoolField(TEXT("Temporal"), Inputs.bTemporal);
+		Settings->SetNumberField(TEXT("MaxSearchSteps"), Inputs.MaxSearchSteps);
+		Settings->SetNumberField(TEXT("MaxDiagonalSearchSteps"), Inputs.MaxDiagonalSearchSteps);
+		Settings->SetNumberField(TEXT("CornerRounding"), Inputs.CornerRounding);
+		Settings->SetNumberField(TEXT("AdaptationFactor"), Inputs.AdaptationFactor);
+		Settings->SetNumberField(TEXT("ReprojectionWeight"), Inputs.ReprojectionWeight);
+		Settings->SetNumberField(TEXT("PredicationThreshold"), Inputs.PredicationThreshold);
+		Settings->SetNumberField(TEXT("PredicationScale"), Inputs.PredicationScale);
+		Settings->SetNumberField(TEXT("PredicationStrength"), Inputs.PredicationStrength);
+		Settings->SetNumberField(TEXT("TemporalHistoryBias"), Inputs.TemporalHistoryBias);
+		Settings->SetBoolField(TEXT("PackedEdgeInput"), Inputs.bPackedEdgeInput);
+		Settings->SetBoolField(TEXT("SearchALU"), Inputs.bSearchALU);
+		Settings->SetBoolField(TEXT("EdgeTileCulling"), Inputs.bEdgeTileCulling);
+		Settings->SetNumberField(TEXT("RasterPath"), Inputs.RasterPath);
+		Settings->SetNumberField(TEXT("SkipStencil"), Inputs.SkipStencil);
+		Settings->SetNumberField(TEXT("NumSkipRects"), Inputs.SkipRects.Num());
+		Settings->SetNumberField(TEXT("TileOverlapX"), Inputs.TileOverlap.X);
+		Settings->SetNumberField(TEXT("TileOverlapY"), Inputs.TileOverlap.Y);
+		return Settings;
+	}
+}
+
+FSMAAInputCapture& FSMAAInputCapture::Get()
+{
+	check(IsInRenderingThread());
+
+	static FSMAAInputCapture Capture;
+	return Capture;
+}
+
+void FSMAAInputCapture::Start(int32 InNumFrames, IImageWriteQueue* InWriteQueue)
+{
+	if (FrameIndex != INDEX_NONE)
+	{
+		UE_LOG(LogSMAA, Warning, TEXT("SMAA input capture is already running."));
+		return;
+	}
+
+	WriteQueue = InWriteQueue;
+	Directory = FPaths::ProjectSavedDir() / TEXT("SMAA") / TEXT("Captures") / FDateTime::Now().ToString();
+	NumFrames = InNumFrames;
+	FrameIndex = 0;
+	ViewIndex = 0;
+	ViewMetadata.Reset();
+
+	UE_LOG(LogSMAA, Display, TEXT("Capturing SMAA inputs for %d frames to %s"), NumFrames, *Directory);
+}
+
+void FSMAAInputCapture::BeginViewFamily()
+{
+	Poll();
+
+	if (FrameIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	// Families without an SMAA view don't count as a frame
+	if (ViewIndex > 0)
+	{
+		++FrameIndex;
+		ViewIndex = 0;
+	}
+
+	if (FrameIndex >= NumFrames && Pending.IsEmpty())
+	{
+		WriteMetadata();
+		FrameIndex = INDEX_NONE;
+	}
+}
+
+uint64 FSMAAInputCapture::CaptureView(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, const FPostProcessMaterialInputs& PostProcessInputs, int32 JitterIndex, bool bHistoryValid)
+{
+	using namespace SMAAInputCapture;
+
+	if (!IsCapturing())
+	{
+		return 0;
+	}
+
+	RDG_EVENT_SCOPE(GraphBuilder, "SMAA Input Capture");
+
+	TUniquePtr<FPendingView> Capture = MakeUnique<FPendingView>();
+	Capture->Name = FString::Printf(TEXT("View%d_Frame%04d"), ViewIndex++, FrameIndex);
+	Capture->Size = Inputs.SceneColor.ViewRect.Size();
+
+	const FSceneTextureUniformParameters* SceneTextures = PostProcessInputs.SceneTextures.SceneTextures->GetContents();
+	FRDGTextureRef BlackDummy = GSystemTextures.GetBlackDummy(GraphBuilder);
+
+	uint64 CaptureBytes = 0;
+	FRDGTextureRef Captured[int32(ECapturedTexture::MAX)];
+	for (int32 Index = 0; Index < int32(ECapturedTexture::MAX); ++Index)
+	{
+		// Half precision is plenty for the colours, not for depth
+		const EPixelFormat Format = Index == int32(ECapturedTexture::Depth) ? PF_A32B32G32R32F : PF_FloatRGBA;
+		const FRDGTextureDesc Desc = FRDGTextureDesc::Create2D(Capture->Size, Format, FClearValueBinding::Black, TexCreate_ShaderResource | TexCreate_UAV);
+		Captured[Index] = GraphBuilder.CreateTexture(Desc, TEXT("SMAA.CapturedInput"));
+
+		// The readback's staging copy is as large again
+		CaptureBytes += 2 * GetSMAATextureSizeBytes(Desc);
+	}
+
+	FSMAAInputCaptureCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSMAAInputCaptureCS::FParameters>();
+	PassParameters->View = View.ViewUniformBuffer;
+	PassParameters->SceneColor = Inputs.SceneColor.Texture;
+	PassParameters->SceneDepth = SceneTextures->SceneDepthTexture;
+	PassParameters->SceneVelocity = Inputs.SceneVelocity.IsValid() ? Inputs.SceneVelocity.Texture : BlackDummy;
+	PassParameters->GBufferA = SceneTextures->GBufferATexture ? SceneTextures->GBufferATexture : BlackDummy;
+	PassParameters->GBufferB = SceneTextures->GBufferBTexture ? SceneTextures->GBufferBTexture : BlackDummy;
+	PassParameters->ViewMin = Inputs.SceneColor.ViewRect.Min;
+	PassParameters->ViewSize = FUintVector2(Capture->Size.X, Capture->Size.Y);
+	PassParameters->CapturedColour = GraphBuilder.CreateUAV(Captured[int32(ECapturedTexture::Colour)]);
+	PassParameters->CapturedDepth = GraphBuilder.CreateUAV(Captured[int32(ECapturedTexture::Depth)]);
+	PassParameters->CapturedVelocity = GraphBuilder.CreateUAV(Captured[int32(ECapturedTexture::Velocity)]);
+	PassParameters->CapturedNormal = GraphBuilder.CreateUAV(Captured[int32(ECapturedTexture::Normal)]);
+	PassParameters->CapturedGBufferA = GraphBuilder.CreateUAV(Captured[int32(ECapturedTexture::GBufferA)]);
+	PassParameters->CapturedGBufferB = GraphBuilder.CreateUAV(Captured[int32(ECapturedTexture::GBufferB)]);
+
+	TShaderMapRef<FSMAAInputCaptureCS> ComputeShader(View.ShaderMap);
+	FComputeShaderUtils::AddPass(
+		GraphBuilder, RDG_EVENT_NAME("SMAA/InputCapture (CS)"), ComputeShader, PassParameters,
+		FComputeShaderUtils::GetGroupCount(FIntVector(Capture->Size.X, Capture->Size.Y, 1),
+			FIntVector(FSMAAInputCaptureCS::ThreadgroupSizeX,
+				FSMAAInputCaptureCS::ThreadgroupSizeY,
+				FSMAAInputCaptureCS::ThreadgroupSizeZ)));
+
+	for (int32 Index = 0; Index < int32(ECapturedTexture::MAX); ++Index)
+	{
+		Capture->Readbacks[Index] = MakeUnique<FRHIGPUTextureReadback>(TEXT("SMAA.CaptureReadback"));
+		AddEnqueueCopyPass(GraphBuilder, Capture->Readbacks[Index].Get(), Captured[Index]);
+	}
+
+	TSharedRef<FJsonObject> Metadata = MakeShared<FJsonObject>();
+	Metadata->SetStringField(TEXT("Name"), Capture->Name);
+	Metadata->SetNumberField(TEXT("Frame"), FrameIndex);
+	Metadata->SetNumberField(TEXT("View"), ViewIndex - 1);
+	Metadata->SetNumberField(TEXT("Width"), Capture->Size.X);
+	Metadata->SetNumberField(TEXT("Height"), Capture->Size.Y);
+	Metadata->SetNumberField(TEXT("ViewRectX"), Inputs.SceneColor.ViewRect.Min.X);
+	Metadata->SetNumberField(TEXT("ViewRectY"), Inputs.SceneColor.ViewRect.Min.Y);
+	Metadata->SetNumberField(TEXT("JitterIndex"), JitterIndex);
+	Metadata->SetNumberField(TEXT("JitterX"), View.TemporalJitterPixels.X);
+	Metadata->SetNumberField(TEXT("JitterY"), View.TemporalJitterPixels.Y);
+	Metadata->SetBoolField(TEXT("CameraCut"), View.bCameraCut);
+	Metadata->SetBoolField(TEXT("HistoryValid"), bHistoryValid);
+	Metadata->SetBoolField(TEXT("Velocity"), Inputs.SceneVelocity.IsValid());
+	Metadata->SetBoolField(TEXT("GBuffer"), SceneTextures->GBufferATexture != nullptr);
+	Metadata->SetObjectField(TEXT("Settings"), DescribeInputs(Inputs));
+	ViewMetadata.Add(MakeShared<FJsonValueObject>(Metadata));
+
+	Pending.Add(MoveTemp(Capture));
+	return CaptureBytes;
+}
+
+void FSMAAInputCapture::Poll()
+{
+	using namespace SMAAInputCapture;
+
+	while (Pending.Num() > 0)
+	{
+		FPendingView& Capture = *Pending[0];
+		for (const TUniquePtr<FRHIGPUTextureReadback>& Readback : Capture.Readbacks)
+		{
+			if (!Readback->IsReady())
+			{
+				// Still in flight, and so is everything queued after it
+				return;
+			}
+		}
+
+		// Copying out of the staging memory is all that happens here, encoding and writing is on the queue's threads
+		for (int32 Index = 0; Index < int32(ECapturedTexture::MAX); ++Index)
+		{
+			TUniquePtr<FImageWriteTask> Task = MakeUnique<FImageWriteTask>();
+			Task->Filename = Directory / Capture.Name + Suffixes[Index] + TEXT(".exr");
+			Task->Format = EImageFormat::EXR;
+			Task->bOverwriteFile = true;
+			Task->PixelData = Index == int32(ECapturedTexture::Depth)
+				? ReadPixels<FLinearColor>(*Capture.Readbacks[Index], Capture.Size)
+				: ReadPixels<FFloat16Color>(*Capture.Readbacks[Index], Capture.Size);
+
+			WriteQueue->Enqueue(MoveTemp(Task));
+		}
+
+		Pending.RemoveAt(0);
+	}
+}
+
+void FSMAAInputCapture::WriteMetadata()
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("Frames"), NumFrames);
+	Root->SetStringField(TEXT("RHI"), GDynamicRHI ? GDynamicRHI->GetName() : TEXT(""));
+	Root->SetStringField(TEXT("Adapter"), GRHIAdapterName);
+	Root->SetArrayField(TEXT("Views"), ViewMetadata);
+
+	FString JSON;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JSON);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	const FString Path = Directory / TEXT("SMAACapture.json");
+	Async(EAsyncExecution::ThreadPool, [JSON = MoveTemp(JSON), Path]()
+	{
+		FFileHelper::SaveStringToFile(JSON, *Path);
+	});
+
+	UE_LOG(LogSMAA, Display, TEXT("SMAA input capture of %d views written to %s"), ViewMetadata.Num(), *Directory);
+	ViewMetadata.Reset();
+}
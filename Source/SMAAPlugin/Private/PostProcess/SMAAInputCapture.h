@@ -0,0 +1,69 @@
+#pragma once
+
+#include "RenderGraphResources.h"
+#include "PostProcess/PostProcessSMAA.h"
+
+class FJsonValue;
+class FRHIGPUTextureReadback;
+class IImageWriteQueue;
+struct FPostProcessMaterialInputs;
+
+/**
+ * Captures what AddSMAAPasses is given for a number of frames: scene colour, depth, velocity, GBufferA and B, the
+ * FSMAAInputs and the jitter index. The textures are read back without waiting on the GPU and written as EXRs by the
+ * image write queue, next to an SMAACapture.json with the settings of every view. The bundle is laid out as a corpus
+ * for the SMAABenchmark and SMAAQuality commandlets, so it replays on the CPU port as it is. See r.SMAA.CaptureInputs.
+ * Render thread only.
+ */
+class FSMAAInputCapture
+{
+public:
+	static FSMAAInputCapture& Get();
+
+	void Start(int32 InNumFrames, IImageWriteQueue* InWriteQueue);
+
+	bool IsCapturing() const
+	{
+		return FrameIndex != INDEX_NONE && FrameIndex < NumFrames;
+	}
+
+	// Writes out the captures the GPU has finished with and moves on a frame. Once per view family
+	void BeginViewFamily();
+
+	// Queues a copy of the view's inputs, once AddSMAAPasses' inputs are final. Returns the platform size of the targets
+	// and readbacks created for it, zero when not capturing
+	uint64 CaptureView(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, const FPostProcessMaterialInputs& PostProcessInputs, int32 JitterIndex, bool bHistoryValid);
+
+private:
+	enum class ECapturedTexture : uint8
+	{
+		Colour,
+		Depth,
+		Velocity,
+		Normal,
+		GBufferA,
+		GBufferB,
+
+		MAX
+	};
+
+	struct FPendingView
+	{
+		FString Name;
+		FIntPoint Size = FIntPoint::ZeroValue;
+		TUniquePtr<FRHIGPUTextureReadback> Readbacks[int32(ECapturedTexture::MAX)];
+	};
+
+	void Poll();
+	void WriteMetadata();
+
+	IImageWriteQueue* WriteQueue = nullptr;
+	FString Directory;
+
+	int32 NumFrames = 0;
+	int32 FrameIndex = INDEX_NONE;
+	int32 ViewIndex = 0;
+
+	TArray<TUniquePtr<FPendingView>> Pending;
+	TArray<TSharedPtr<FJsonValue>> ViewMetadata;
+};
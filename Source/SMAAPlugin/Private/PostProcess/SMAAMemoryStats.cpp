@@ -0,0 +1,66 @@
+#include "PostProcess/SMAAMemoryStats.h"
+
+#include "PostProcess/PostProcessSMAA.h"
+#include "SMAASceneExtension.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+LLM_DEFINE_TAG(SMAA);
+
+DECLARE_MEMORY_STAT_POOL(TEXT("History Memory"), STAT_SMAAHistoryMemory, STATGROUP_SMAA, FPlatformMemory::MCR_GPU);
+DECLARE_MEMORY_STAT_POOL(TEXT("Transient Memory"), STAT_SMAATransientMemory, STATGROUP_SMAA, FPlatformMemory::MCR_GPU);
+DECLARE_MEMORY_STAT_POOL(TEXT("Lookup Texture Memory"), STAT_SMAALookupTextureMemory, STATGROUP_SMAA, FPlatformMemory::MCR_GPU);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Views"), STAT_SMAAViews, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Histories"), STAT_SMAAHistories, STATGROUP_SMAA);
+
+CSV_DECLARE_CATEGORY_EXTERN(SMAA);
+
+uint64 GetSMAATextureSizeBytes(const FRDGTextureDesc& Desc)
+{
+	return RHICalcTexturePlatformSize(Desc).Size;
+}
+
+uint64 GetSMAABufferSizeBytes(const FRDGBufferDesc& Desc)
+{
+	return Desc.GetSize();
+}
+
+FSMAAMemoryTotals GatherSMAAMemory(const TMap<uint32, TSharedPtr<FSMAAViewData>>& ViewDataMap, const IPooledRenderTarget* AreaTexture, const IPooledRenderTarget* SearchTexture)
+{
+	FSMAAMemoryTotals Totals;
+
+	for (const TPair<uint32, TSharedPtr<FSMAAViewData>>& Pair : ViewDataMap)
+	{
+		if (!Pair.Value.IsValid())
+		{
+			continue;
+		}
+
+		++Totals.NumViews;
+		Totals.TransientBytes += Pair.Value->Memory.TransientBytes + Pair.Value->Memory.CaptureBytes;
+
+		if (Pair.Value->SMAAHistory.IsValid())
+		{
+			++Totals.NumHistories;
+			Totals.HistoryBytes += Pair.Value->SMAAHistory.GetGPUSizeBytes(false);
+		}
+	}
+
+	// The lookup textures are owned by their UTexture2D, the pooled targets only wrap them
+	Totals.LookupTextureBytes += AreaTexture ? AreaTexture->ComputeMemorySize() : 0;
+	Totals.LookupTextureBytes += SearchTexture ? SearchTexture->ComputeMemorySize() : 0;
+
+	return Totals;
+}
+
+void PublishSMAAMemoryStats(const FSMAAMemoryTotals& Totals)
+{
+	SET_MEMORY_STAT(STAT_SMAAHistoryMemory, Totals.HistoryBytes);
+	SET_MEMORY_STAT(STAT_SMAATransientMemory, Totals.TransientBytes);
+	SET_MEMORY_STAT(STAT_SMAALookupTextureMemory, Totals.LookupTextureBytes);
+	SET_DWORD_STAT(STAT_SMAAViews, Totals.NumViews);
+	SET_DWORD_STAT(STAT_SMAAHistories, Totals.NumHistories);
+
+	CSV_CUSTOM_STAT(SMAA, HistoryMB, float(double(Totals.HistoryBytes) / (1024.0 * 1024.0)), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(SMAA, TransientMB, float(double(Totals.TransientBytes) / (1024.0 * 1024.0)), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(SMAA, TotalMB, float(double(Totals.GetTotal()) / (1024.0 * 1024.0)), ECsvCustomStatOp::Set);
+}
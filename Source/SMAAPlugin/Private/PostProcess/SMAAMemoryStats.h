@@ -0,0 +1,37 @@
+#pragma once
+
+#include "RenderGraphResources.h"
+#include "HAL/LowLevelMemTracker.h"
+
+struct FSMAAViewData;
+
+LLM_DECLARE_TAG(SMAA);
+
+// Platform size of a texture created with the given description
+uint64 GetSMAATextureSizeBytes(const FRDGTextureDesc& Desc);
+
+// Size of a buffer created with the given description
+uint64 GetSMAABufferSizeBytes(const FRDGBufferDesc& Desc);
+
+// GPU memory SMAA holds across all of its views
+struct FSMAAMemoryTotals
+{
+	// T2x histories, kept between frames
+	uint64 HistoryBytes = 0;
+
+	// Intermediates and input captures of each view's last frame, see FSMAAViewMemory
+	uint64 TransientBytes = 0;
+
+	// Area and search textures, shared by all views
+	uint64 LookupTextureBytes = 0;
+
+	int32 NumViews = 0;
+	int32 NumHistories = 0;
+
+	uint64 GetTotal() const { return HistoryBytes + TransientBytes + LookupTextureBytes; }
+};
+
+FSMAAMemoryTotals GatherSMAAMemory(const TMap<uint32, TSharedPtr<FSMAAViewData>>& ViewDataMap, const IPooledRenderTarget* AreaTexture, const IPooledRenderTarget* SearchTexture);
+
+// Publishes the totals through "stat SMAA" and the SMAA CSV category
+void PublishSMAAMemoryStats(const FSMAAMemoryTotals& Totals);
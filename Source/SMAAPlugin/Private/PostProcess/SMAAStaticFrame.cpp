@@ -0,0 +1,275 @@
+#include "PostProcess/SMAAStaticFrame.h"
+
+#include "GlobalShader.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "RHIGPUReadback.h"
+#include "ScenePrivate.h"
+#include "ShaderParameterStruct.h"
+#include "SMAASceneExtension.h"
+#include "SystemTextures.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+DECLARE_GPU_STAT_NAMED(SMAAStaticDetect, TEXT("SMAA Static Detect"));
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Static Candidates"), STAT_SMAAStaticCandidates, STATGROUP_SMAA);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Static Frames Reused"), STAT_SMAAStaticFrames, STATGROUP_SMAA);
+
+CSV_DECLARE_CATEGORY_EXTERN(SMAA);
+
+/**
+ * Looks for foreground velocity over the view and sums a hash of every scene colour pixel
+ */
+class FSMAAStaticDetectCS : public FGlobalShader
+{
+public:
+	static const int ThreadgroupSizeX = 8;
+	static const int ThreadgroupSizeY = 8;
+	static const int ThreadgroupSizeZ = 1;
+
+	DECLARE_GLOBAL_SHADER(FSMAAStaticDetectCS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAAStaticDetectCS, FGlobalShader);
+
+	class FSMAAStaticHashDim : SHADER_PERMUTATION_BOOL("SMAA_STATIC_HASH");
+
+	using FPermutationDomain = TShaderPermutationDomain<FSMAAStaticHashDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneColour)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, VelocityTexture)
+	SHADER_PARAMETER(FIntPoint, ViewMin)
+	SHADER_PARAMETER(FUintVector2, ViewSize)
+	SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, State)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), ThreadgroupSizeX);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), ThreadgroupSizeY);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), ThreadgroupSizeZ);
+		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAAStaticDetectCS, "/SMAAPlugin/Private/SMAA_StaticFrame.usf",
+	"StaticDetectCS", SF_Compute);
+
+/**
+ * Decides whether the frame is static and writes every pass's indirect arguments. A single thread
+ */
+class FSMAAStaticArgsCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSMAAStaticArgsCS);
+	SHADER_USE_PARAMETER_STRUCT(FSMAAStaticArgsCS, FGlobalShader);
+
+	class FSMAAStaticHashDim : SHADER_PERMUTATION_BOOL("SMAA_STATIC_HASH");
+
+	using FPermutationDomain = TShaderPermutationDomain<FSMAAStaticHashDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+	SHADER_PARAMETER_ARRAY(FUintVector4, GroupCounts, [uint32(ESMAAStaticPass::MAX)])
+	SHADER_PARAMETER(uint32, Phase)
+	SHADER_PARAMETER(uint32, bComparePhase)
+	SHADER_PARAMETER(uint32, bCompareStill)
+	SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, State)
+	SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, IndirectArgs)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+	}
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters,
+		FShaderCompilerEnvironment& OutEnvironment)
+	{
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEX"), 1);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEY"), 1);
+		OutEnvironment.SetDefine(TEXT("THREADGROUP_SIZEZ"), 1);
+		OutEnvironment.SetDefine(TEXT("COMPUTE_SHADER"), 1);
+		OutEnvironment.SetDefine(TEXT("SMAA_STATIC_PASS_REUSE"), uint32(ESMAAStaticPass::Reuse));
+		OutEnvironment.SetDefine(TEXT("SMAA_STATIC_PASS_COUNT"), uint32(ESMAAStaticPass::MAX));
+	}
+};
+IMPLEMENT_GLOBAL_SHADER(FSMAAStaticArgsCS, "/SMAAPlugin/Private/SMAA_StaticFrame.usf",
+	"StaticArgsCS", SF_Compute);
+
+FSMAAStaticFrame::~FSMAAStaticFrame()
+{
+	for (FRHIGPUBufferReadback* Readback : Readbacks)
+	{
+		delete Readback;
+	}
+}
+
+uint32 FSMAAStaticFrame::GetSettingsHash(const FSMAAInputs& Inputs)
+{
+	// Anything that changes the output of a still frame
+	uint32 Hash = GetTypeHash(uint32(Inputs.Quality));
+	Hash = HashCombine(Hash, GetTypeHash(uint32(Inputs.EdgeMode)));
+	Hash = HashCombine(Hash, GetTypeHash(uint32(Inputs.PredicationSource)));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.MaxSearchSteps | Inputs.MaxDiagonalSearchSteps << 8 | Inputs.CornerRounding << 16));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.AdaptationFactor));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.ReprojectionWeight));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.PredicationThreshold));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.PredicationScale));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.PredicationStrength));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.TemporalHistoryBias));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.bTemporal));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.StaticReuse));
+	Hash = HashCombine(Hash, GetTypeHash(Inputs.SkipStencil));
+	for (const FIntRect& Rect : Inputs.SkipRects)
+	{
+		Hash = HashCombine(Hash, HashCombine(GetTypeHash(Rect.Min), GetTypeHash(Rect.Max)));
+	}
+	return Hash;
+}
+
+bool FSMAAStaticFrame::IsCandidate(const FViewInfo& View, const FSMAAInputs& Inputs, const FSMAAHistory& History, bool bEligible)
+{
+	const uint32 SettingsHash = GetSettingsHash(Inputs);
+
+	// Jitter is left out of the projection, it changes every T2x frame and the GPU compares each phase separately
+	const bool bUnchanged = bEligible
+		&& History.IsValid()
+		&& History.ViewportRect.Size() == View.ViewRect.Size()
+		&& !View.bCameraCut
+		&& View.ViewRect == LastViewRect
+		&& View.ViewMatrices.GetViewMatrix() == LastViewMatrix
+		&& View.ViewMatrices.GetProjectionNoAAMatrix() == LastProjectionMatrix
+		&& SettingsHash == LastSettingsHash;
+
+	LastViewMatrix = View.ViewMatrices.GetViewMatrix();
+	LastProjectionMatrix = View.ViewMatrices.GetProjectionNoAAMatrix();
+	LastViewRect = View.ViewRect;
+	LastSettingsHash = SettingsHash;
+
+	if (!bUnchanged)
+	{
+		NumCandidateFrames = 0;
+	}
+
+	return bUnchanged;
+}
+
+FRDGBufferRef FSMAAStaticFrame::AddDetection(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, int32 JitterIndex,
+	const TStaticArray<FIntVector, uint32(ESMAAStaticPass::MAX)>& GroupCounts)
+{
+	RDG_EVENT_SCOPE(GraphBuilder, "SMAA/StaticDetect");
+	RDG_GPU_STAT_SCOPE(GraphBuilder, SMAAStaticDetect);
+
+	FRDGBufferRef StateBuffer = nullptr;
+	if (State.IsValid())
+	{
+		StateBuffer = GraphBuilder.RegisterExternalBuffer(State);
+	}
+	else
+	{
+		StateBuffer = GraphBuilder.CreateBuffer(GetStateDesc(), TEXT("SMAA.StaticState"));
+		AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(StateBuffer, PF_R32_UINT), 0u);
+		GraphBuilder.QueueBufferExtraction(StateBuffer, &State);
+	}
+
+	FRDGBufferUAVRef StateUAV = GraphBuilder.CreateUAV(StateBuffer, PF_R32_UINT);
+	const bool bHash = Inputs.StaticReuse >= 2;
+
+	{
+		FSMAAStaticDetectCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAAStaticDetectCS::FSMAAStaticHashDim>(bHash);
+
+		FSMAAStaticDetectCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSMAAStaticDetectCS::FParameters>();
+		PassParameters->SceneColour = Inputs.SceneColor.Texture;
+		PassParameters->VelocityTexture = Inputs.SceneVelocity.IsValid() ? Inputs.SceneVelocity.Texture : GSystemTextures.GetBlackDummy(GraphBuilder);
+		PassParameters->ViewMin = View.ViewRect.Min;
+		PassParameters->ViewSize = FUintVector2(View.ViewRect.Width(), View.ViewRect.Height());
+		PassParameters->State = StateUAV;
+
+		TShaderMapRef<FSMAAStaticDetectCS> ComputeShader(View.ShaderMap, PermutationVector);
+		FComputeShaderUtils::AddPass(
+			GraphBuilder, RDG_EVENT_NAME("SMAA/StaticDetect (CS)"), ComputeShader, PassParameters,
+			FComputeShaderUtils::GetGroupCount(View.ViewRect.Size(),
+				FIntPoint(FSMAAStaticDetectCS::ThreadgroupSizeX, FSMAAStaticDetectCS::ThreadgroupSizeY)));
+	}
+
+	FRDGBufferRef IndirectArgs = GraphBuilder.CreateBuffer(
+		FRDGBufferDesc::CreateIndirectDesc<FRHIDispatchIndirectParameters>(uint32(ESMAAStaticPass::MAX)), TEXT("SMAA.StaticIndirectArgs"));
+
+	{
+		FSMAAStaticArgsCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSMAAStaticArgsCS::FSMAAStaticHashDim>(bHash);
+
+		FSMAAStaticArgsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSMAAStaticArgsCS::FParameters>();
+		for (uint32 Pass = 0; Pass < uint32(ESMAAStaticPass::MAX); ++Pass)
+		{
+			PassParameters->GroupCounts[Pass] = FUintVector4(GroupCounts[Pass].X, GroupCounts[Pass].Y, GroupCounts[Pass].Z, 0);
+		}
+
+		// T2x alternates between two jitters, so each frame is compared against the one before last. The state being
+		// compared against must have been written during this run of candidate frames
+		PassParameters->Phase = Inputs.bTemporal ? (JitterIndex & 1) : 0;
+		PassParameters->bComparePhase = NumCandidateFrames >= (Inputs.bTemporal ? 2 : 1);
+		PassParameters->bCompareStill = NumCandidateFrames >= 1;
+		PassParameters->State = StateUAV;
+		PassParameters->IndirectArgs = GraphBuilder.CreateUAV(IndirectArgs, PF_R32_UINT);
+
+		TShaderMapRef<FSMAAStaticArgsCS> ComputeShader(View.ShaderMap, PermutationVector);
+		FComputeShaderUtils::AddPass(
+			GraphBuilder, RDG_EVENT_NAME("SMAA/StaticArgs (CS)"), ComputeShader, PassParameters, FIntVector(1, 1, 1));
+	}
+
+	EnqueueReadback(GraphBuilder, StateBuffer);
+	++NumCandidateFrames;
+
+	return IndirectArgs;
+}
+
+FRDGBufferDesc FSMAAStaticFrame::GetStateDesc()
+{
+	return FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), uint32(ESMAAStaticState::Num));
+}
+
+void FSMAAStaticFrame::EnqueueReadback(FRDGBuilder& GraphBuilder, FRDGBufferRef StateBuffer)
+{
+	// All slots are still waiting on the GPU, drop this frame rather than stall
+	if (bInFlight[WriteIndex])
+	{
+		return;
+	}
+
+	if (!Readbacks[WriteIndex])
+	{
+		Readbacks[WriteIndex] = new FRHIGPUBufferReadback(TEXT("SMAA.StaticStateReadback"));
+	}
+
+	AddEnqueueCopyPass(GraphBuilder, Readbacks[WriteIndex], StateBuffer, uint32(ESMAAStaticState::Num) * sizeof(uint32));
+
+	bInFlight[WriteIndex] = true;
+	WriteIndex = (WriteIndex + 1) % MaxPendingReadbacks;
+}
+
+void FSMAAStaticFrame::Poll()
+{
+	while (bInFlight[ReadIndex] && Readbacks[ReadIndex]->IsReady())
+	{
+		FRHIGPUBufferReadback* Readback = Readbacks[ReadIndex];
+
+		const uint32* Data = static_cast<const uint32*>(Readback->Lock(uint32(ESMAAStaticState::Num) * sizeof(uint32)));
+		const bool bStatic = Data[uint32(ESMAAStaticState::Static)] != 0;
+		Readback->Unlock();
+
+		INC_DWORD_STAT(STAT_SMAAStaticCandidates);
+		CSV_CUSTOM_STAT(SMAA, StaticCandidates, 1, ECsvCustomStatOp::Accumulate);
+		if (bStatic)
+		{
+			INC_DWORD_STAT(STAT_SMAAStaticFrames);
+			CSV_CUSTOM_STAT(SMAA, StaticFramesReused, 1, ECsvCustomStatOp::Accumulate);
+		}
+
+		bInFlight[ReadIndex] = false;
+		ReadIndex = (ReadIndex + 1) % MaxPendingReadbacks;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "RenderGraphResources.h"
+#include "PostProcess/PostProcessSMAA.h"
+
+class FRHIGPUBufferReadback;
+class FViewInfo;
+struct FSMAAHistory;
+
+// Compute dispatches static frames change, one indirect argument slot each. All but Reuse, the copy of the last
+// output, are skipped on static frames; Reuse only runs on them
+enum class ESMAAStaticPass : uint8
+{
+	EdgeInputPrepass,
+	TileClassify,
+	EdgeDetection,
+	BlendWeights,
+	NeighbourhoodBlending,
+	TemporalResolve,
+	Reuse,
+
+	MAX
+};
+
+// Layout of the detection state buffer. Must match SMAA_STATIC_* in SMAA_StaticFrame.usf
+enum class ESMAAStaticState : uint32
+{
+	// Set when any pixel has foreground velocity this frame
+	Moving,
+	// Sum of the scene colour's per pixel hashes this frame, 64 bits
+	Hash,
+	// Whether the last frame was still, so two in a row can be required
+	Still = Hash + 2,
+	// Last hash of each jitter phase, 64 bits each
+	PhaseHashes,
+	// This frame's decision, for the readback
+	Static = PhaseHashes + 4,
+
+	Num
+};
+
+/**
+ * Finds frames of a view that are the same as its last ones, so SMAA can show its last output again instead of running.
+ * The CPU checks that the view matrices, view rect and settings haven't changed. If so, a GPU pass looks for
+ * foreground velocity and, with r.SMAA.StaticReuse 2, compares a hash of the scene colour against the last frame with
+ * the same jitter. A second pass writes the indirect arguments of every ESMAAStaticPass, zero groups for all but Reuse
+ * on frames that are the second still one in a row, so the decision costs no readback. How many frames were reused
+ * comes back a few frames later through "stat SMAA"; the detection is timed under the "SMAA Static Detect" GPU stat.
+ */
+class FSMAAStaticFrame
+{
+public:
+	~FSMAAStaticFrame();
+
+	// Whether this frame may be static, from what the CPU knows. bEligible is false when the passes have to run
+	bool IsCandidate(const FViewInfo& View, const FSMAAInputs& Inputs, const FSMAAHistory& History, bool bEligible);
+
+	// Adds detection on a candidate frame. Returns the indirect arguments, GroupCounts being each pass's usual count
+	FRDGBufferRef AddDetection(FRDGBuilder& GraphBuilder, const FViewInfo& View, const FSMAAInputs& Inputs, int32 JitterIndex,
+		const TStaticArray<FIntVector, uint32(ESMAAStaticPass::MAX)>& GroupCounts);
+
+	// Publishes any readback which has completed since the last call
+	void Poll();
+
+	// The detection state buffer, kept between candidate frames
+	static FRDGBufferDesc GetStateDesc();
+
+private:
+	static uint32 GetSettingsHash(const FSMAAInputs& Inputs);
+
+	void EnqueueReadback(FRDGBuilder& GraphBuilder, FRDGBufferRef StateBuffer);
+
+	FMatrix LastViewMatrix = FMatrix::Identity;
+	FMatrix LastProjectionMatrix = FMatrix::Identity;
+	FIntRect LastViewRect;
+	uint32 LastSettingsHash = 0;
+
+	// Candidate frames in a row before this one, so the GPU only compares against state this run has written
+	int32 NumCandidateFrames = 0;
+
+	TRefCountPtr<FRDGPooledBuffer> State;
+
+	static constexpr int32 MaxPendingReadbacks = 4;
+	FRHIGPUBufferReadback* Readbacks[MaxPendingReadbacks] = {};
+	bool bInFlight[MaxPendingReadbacks] = {};
+	int32 WriteIndex = 0;
+	int32 ReadIndex = 0;
+};
@@ -42,7 +42,8 @@ void FSMAAPluginModule::UpdateExtensions()
 			const auto TextureResource = AreaTexture->CreateResource();
 		}
 
-		if (ensure(SearchTexture))
+		// Only sampled with r.SMAA.SearchALU 0
+		if (SearchTexture)
 		{
 			//SearchTexture->UpdateResource();
 			const auto TextureResource = SearchTexture->CreateResource();
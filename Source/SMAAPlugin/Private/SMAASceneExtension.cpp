@@ -13,8 +13,15 @@
 #include "DynamicResolutionState.h"
 #include "FXRenderingUtils.h"
 #include "Rendering/Texture2DResource.h"
+#include "RenderTargetPool.h"
 
 #include "PostProcess/PostProcessSMAA.h"
+#include "PostProcess/SMAAEdgeStats.h"
+#include "PostProcess/SMAAGroupShapeBenchmark.h"
+#include "PostProcess/SMAAInputCapture.h"
+#include "PostProcess/SMAAMemoryStats.h"
+#include "PostProcess/SMAAStaticFrame.h"
+#include "SMAAPlugin.h"
 
 TAutoConsoleVariable<int32> CVarSMAAEnabled(
 	TEXT("r.SMAA"), 0,
@@ -28,10 +35,55 @@ TAutoConsoleVariable<int32> CVarSMAAVisualizeEnabled(
 	TEXT(" 1 - on"),
 	ECVF_RenderThreadSafe);
 
+TAutoConsoleVariable<int32> CVarSMAASceneCaptures(
+	TEXT("r.SMAA.SceneCaptures"), 1,
+	TEXT("SMAA on scene captures and planar reflections. Reflection captures never use SMAA.\n")
+	TEXT(" 0 - off\n")
+	TEXT(" 1 - SMAA 1x, no jitter or history (Default)\n")
+	TEXT(" 2 - same as the main view"),
+	ECVF_Scalability | ECVF_RenderThreadSafe);
+
+static FAutoConsoleCommand CmdSMAAMemReport(
+	TEXT("r.SMAA.MemReport"),
+	TEXT("Logs the GPU memory SMAA holds for each view: T2x history, last frame's intermediates and the lookup textures."),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FSMAAPluginModule* Module = FModuleManager::GetModulePtr<FSMAAPluginModule>("SMAAPlugin");
+		TSharedPtr<FSMAASceneExtension> Extension = Module ? Module->GetSceneExtension() : nullptr;
+		if (!Extension.IsValid())
+		{
+			UE_LOG(LogSMAA, Display, TEXT("SMAA is not initialised"));
+			return;
+		}
+
+		ENQUEUE_RENDER_COMMAND(SMAAMemReport)([Extension](FRHICommandListImmediate&)
+		{
+			Extension->LogMemoryReport();
+		});
+	}));
+
+uint64 FSMAAHistory::GetGPUSizeBytes(bool bLogSizes) const
+{
+	if (!PastFrame.IsValid())
+	{
+		return 0;
+	}
+
+	const uint64 Size = PastFrame->ComputeMemorySize();
+	if (bLogSizes)
+	{
+		const FPooledRenderTargetDesc& Desc = PastFrame->GetDesc();
+		UE_LOG(LogSMAA, Log, TEXT("    PastFrame %dx%d %s: %.2f MB"),
+			Desc.Extent.X, Desc.Extent.Y, GetPixelFormatString(Desc.Format), double(Size) / (1024.0 * 1024.0));
+	}
+	return Size;
+}
+
 FSMAASceneExtension::FSMAASceneExtension(const FAutoRegister& AutoReg, FTexture2DResource* InSMAAAreaTexture, FTexture2DResource* InSMAASearchTexture)
 	: FSceneViewExtensionBase(AutoReg)
 	, SMAAAreaTexture(InSMAAAreaTexture)
 	, SMAASearchTexture(InSMAASearchTexture)
+	, CVarSnapshot(MakePimpl<FSMAAInputs>())
 {
 	//check(SMAAAreaTexture)
 }
@@ -48,6 +100,8 @@ void FSMAASceneExtension::SetupView(FSceneViewFamily& InViewFamily, FSceneView&
 
 TSharedPtr<FSMAAViewData> FSMAASceneExtension::GetOrCreateViewData(const FSceneView& InView)
 {
+	LLM_SCOPE_BYTAG(SMAA);
+
 	if (InView.State == nullptr)
 	{
 		return nullptr;
@@ -70,6 +124,46 @@ bool FSMAASceneExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionCo
 	return CVarSMAAEnabled.GetValueOnAnyThread() == 1;
 }
 
+void FSMAASceneExtension::PreRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily)
+{
+	*CVarSnapshot = GetSMAAInputsFromCVars();
+	FSMAAGroupShapeBenchmark::Get().BeginViewFamily(*CVarSnapshot);
+	FSMAAInputCapture::Get().BeginViewFamily();
+	bVisualize = CVarSMAAVisualizeEnabled.GetValueOnRenderThread() == 1;
+
+	// Last family's figures, the intermediates of this one haven't been created yet
+	PublishSMAAMemoryStats(GatherSMAAMemory(ViewDataMap, SMAAAreaTextureRT, SMAASearchTextureRT));
+}
+
+void FSMAASceneExtension::LogMemoryReport() const
+{
+	check(IsInRenderingThread());
+
+	UE_LOG(LogSMAA, Log, TEXT("SMAA GPU memory:"));
+	for (const TPair<uint32, TSharedPtr<FSMAAViewData>>& Pair : ViewDataMap)
+	{
+		if (!Pair.Value.IsValid())
+		{
+			continue;
+		}
+
+		const FSMAAViewMemory& Memory = Pair.Value->Memory;
+		UE_LOG(LogSMAA, Log, TEXT("  View %u: %s, transients %.2f MB at %dx%d, input capture %.2f MB"),
+			Pair.Key,
+			Pair.Value->Settings.bEnabled ? (Pair.Value->Settings.bTemporal ? TEXT("T2x") : TEXT("1x")) : TEXT("off"),
+			double(Memory.TransientBytes) / (1024.0 * 1024.0), Memory.TransientExtent.X, Memory.TransientExtent.Y,
+			double(Memory.CaptureBytes) / (1024.0 * 1024.0));
+		Pair.Value->SMAAHistory.GetGPUSizeBytes(true);
+	}
+
+	const FSMAAMemoryTotals Totals = GatherSMAAMemory(ViewDataMap, SMAAAreaTextureRT, SMAASearchTextureRT);
+	UE_LOG(LogSMAA, Log, TEXT("  %d views, %d histories"), Totals.NumViews, Totals.NumHistories);
+	UE_LOG(LogSMAA, Log, TEXT("  History:         %.2f MB"), double(Totals.HistoryBytes) / (1024.0 * 1024.0));
+	UE_LOG(LogSMAA, Log, TEXT("  Transient:       %.2f MB"), double(Totals.TransientBytes) / (1024.0 * 1024.0));
+	UE_LOG(LogSMAA, Log, TEXT("  Lookup textures: %.2f MB"), double(Totals.LookupTextureBytes) / (1024.0 * 1024.0));
+	UE_LOG(LogSMAA, Log, TEXT("  Total:           %.2f MB"), double(Totals.GetTotal()) / (1024.0 * 1024.0));
+}
+
 void FSMAASceneExtension::PreRenderView_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView)
 {
 	check(InView.bIsViewInfo);
@@ -81,7 +175,49 @@ void FSMAASceneExtension::PreRenderView_RenderThread(FRDGBuilder& GraphBuilder,
 	}
 	FSceneViewState* ViewState = InView.State->GetConcreteViewState();
 
-	ApplyJitter(View, ViewState, InView.UnconstrainedViewRect, GetOrCreateViewData(InView).ToSharedRef());
+	TSharedRef<FSMAAViewData> ViewData = GetOrCreateViewData(InView).ToSharedRef();
+	ViewData->Settings = ResolveViewSettings(InView);
+	ViewData->PublishedTextures = FSMAAViewTextures();
+	ViewData->PublishedGraphBuilder = nullptr;
+
+	// Filled in again if SMAA runs for the view this frame, so a view it stops running for no longer counts
+	ViewData->Memory = FSMAAViewMemory();
+
+	// Only T2x jitters the projection
+	if (ViewData->Settings.bEnabled && ViewData->Settings.bTemporal)
+	{
+		ApplyJitter(View, ViewState, InView.UnconstrainedViewRect, ViewData);
+	}
+	else
+	{
+		ViewData->JitterIndex = 0;
+	}
+}
+
+FSMAAViewSettings FSMAASceneExtension::ResolveViewSettings(const FSceneView& InView) const
+{
+	FSMAAViewSettings Settings;
+	Settings.Quality = CVarSnapshot->Quality;
+	Settings.EdgeMode = CVarSnapshot->EdgeMode;
+	Settings.bTemporal = CVarSnapshot->bTemporal;
+	Settings.TileOverlap = CVarSnapshot->TileOverlap;
+	Settings.SkipStencil = CVarSnapshot->SkipStencil;
+
+	// Anti-aliasing turned off for the family, e.g. through a scene capture component's show flags
+	if (!InView.Family->EngineShowFlags.AntiAliasing || InView.bIsReflectionCapture)
+	{
+		Settings.bEnabled = false;
+	}
+	else if (InView.bIsSceneCapture || InView.bIsPlanarReflection)
+	{
+		const int32 SceneCaptureMode = CVarSMAASceneCaptures.GetValueOnRenderThread();
+		Settings.bEnabled = SceneCaptureMode > 0;
+		Settings.bTemporal = SceneCaptureMode > 1 && CVarSnapshot->bTemporal;
+	}
+
+	OnResolveViewSettings.Broadcast(InView, Settings);
+
+	return Settings;
 }
 
 void FSMAASceneExtension::SubscribeToPostProcessingPass(EPostProcessingPass Pass, FAfterPassCallbackDelegateArray& InOutPassCallbacks, bool bIsPassEnabled)
@@ -96,31 +232,12 @@ FScreenPassTexture FSMAASceneExtension::PostProcessPass_RenderThread(FRDGBuilder
 {
 	InOutInputs.Validate();
 
+	LLM_SCOPE_BYTAG(SMAA);
+
 	//SMAAAreaTexture->InitRHI(GetImmediateCommandList_ForRenderCommand());
 	//SMAASearchTexture->InitRHI(GetImmediateCommandList_ForRenderCommand());
 
-	auto& SceneTextureParameters = InOutInputs.SceneTextures.SceneTextures;
-
 	{
-		auto PredicateSource = GetPredicateSource();
-
-		FSMAAInputs PassInputs;
-		//PassSequence.AcceptOverrideIfLastPass(EPass::SMAA, PassInputs.OverrideOutput);
-		PassInputs.SceneColor = FScreenPassTexture(InOutInputs.GetInput(EPostProcessMaterialInput::SceneColor));
-		PassInputs.SceneVelocity = FScreenPassTexture(InOutInputs.GetInput(EPostProcessMaterialInput::Velocity));
-		PassInputs.Quality = GetSMAAPreset();
-		PassInputs.EdgeMode = GetSMAAEdgeDetectors();
-		PassInputs.PredicationSource = PredicateSource;
-		PassInputs.MaxSearchSteps = GetSMAAMaxSearchSteps();
-		PassInputs.MaxDiagonalSearchSteps = GetSMAAMaxDiagonalSearchSteps();
-		PassInputs.CornerRounding = GetSMAACornerRounding();
-		PassInputs.AdaptationFactor = GetSMAAAdaptationFactor();
-		PassInputs.ReprojectionWeight = GetSMAAReprojectionWeight();
-		PassInputs.PredicationThreshold = GetSMAAPredicationThreshold();
-		PassInputs.PredicationScale = GetSMAAPredicationScale();
-		PassInputs.PredicationStrength = GetSMAAPredicationStrength();
-		PassInputs.TemporalHistoryBias = GetSMAATemporalHistoryBias();
-
 		check(View.bIsViewInfo);
 
 		auto ViewData = GetOrCreateViewData(View);
@@ -129,14 +246,63 @@ FScreenPassTexture FSMAASceneExtension::PostProcessPass_RenderThread(FRDGBuilder
 			return FScreenPassTexture(InOutInputs.GetInput(EPostProcessMaterialInput::SceneColor));
 		}
 
-		if (CVarSMAAVisualizeEnabled.GetValueOnAnyThread() == 1)
+		const FSMAAViewSettings& Settings = ViewData->Settings;
+		if (!Settings.bEnabled)
+		{
+			// Don't resume from stale history if SMAA is turned back on for this view
+			ViewData->SMAAHistory.SafeRelease();
+			return FScreenPassTexture(InOutInputs.GetInput(EPostProcessMaterialInput::SceneColor));
+		}
+
+		FSMAAInputs PassInputs = *CVarSnapshot;
+		PassInputs.SceneColor = FScreenPassTexture(InOutInputs.GetInput(EPostProcessMaterialInput::SceneColor));
+		PassInputs.SceneVelocity = FScreenPassTexture(InOutInputs.GetInput(EPostProcessMaterialInput::Velocity));
+		PassInputs.Quality = Settings.Quality;
+		GetSMAAPresetSearchSettings(PassInputs.Quality, PassInputs.MaxSearchSteps, PassInputs.MaxDiagonalSearchSteps, PassInputs.CornerRounding);
+		PassInputs.EdgeMode = Settings.EdgeMode;
+		PassInputs.bTemporal = Settings.bTemporal;
+		PassInputs.TileOverlap = Settings.TileOverlap;
+		if (PassInputs.TileOverlap.X < 0 || PassInputs.TileOverlap.Y < 0)
+		{
+			const int32 Apron = GetSMAASearchApron(PassInputs.Quality, PassInputs.MaxSearchSteps, PassInputs.MaxDiagonalSearchSteps);
+			PassInputs.TileOverlap.X = PassInputs.TileOverlap.X < 0 ? Apron : PassInputs.TileOverlap.X;
+			PassInputs.TileOverlap.Y = PassInputs.TileOverlap.Y < 0 ? Apron : PassInputs.TileOverlap.Y;
+		}
+		PassInputs.SkipStencil = Settings.SkipStencil;
+		PassInputs.SkipRects = Settings.SkipRects;
+		PassInputs.bPublishTextures = Settings.bPublishTextures || OnViewTexturesPublished.IsBound();
+
+		UpdateLookupTextures(*ViewData);
+
+		// Publish any edge statistics and static frame decisions that have made it back from the GPU
+		if (ViewData->EdgeStats.IsValid())
+		{
+			ViewData->EdgeStats->Poll();
+		}
+		if (ViewData->StaticFrame.IsValid())
+		{
+			ViewData->StaticFrame->Poll();
+		}
+
+		if (bVisualize)
 		{
 			auto SceneColorSlice = FScreenPassTextureSlice::CreateFromScreenPassTexture(GraphBuilder, AddVisualizeSMAAPasses(GraphBuilder, (const FViewInfo&)View, PassInputs, InOutInputs, ViewData.ToSharedRef()));
 			return FScreenPassTexture(SceneColorSlice);
 		}
 		else
 		{
+			// Set when SMAA ends the post process chain, so the last pass can write the chain's output directly
+			PassInputs.OverrideOutput = InOutInputs.OverrideOutput;
+
+			ViewData->Memory.CaptureBytes = FSMAAInputCapture::Get().CaptureView(GraphBuilder, (const FViewInfo&)View, PassInputs, InOutInputs, ViewData->JitterIndex, ViewData->SMAAHistory.IsValid());
+
 			auto SceneColorSlice = FScreenPassTextureSlice::CreateFromScreenPassTexture(GraphBuilder, AddSMAAPasses(GraphBuilder, (const FViewInfo&)View, PassInputs, InOutInputs, ViewData.ToSharedRef()));
+
+			if (ViewData->PublishedTextures.IsValid())
+			{
+				OnViewTexturesPublished.Broadcast(GraphBuilder, View, ViewData->PublishedTextures);
+			}
+
 			return FScreenPassTexture(SceneColorSlice);
 		}
 	}
@@ -144,6 +310,73 @@ FScreenPassTexture FSMAASceneExtension::PostProcessPass_RenderThread(FRDGBuilder
 	return FScreenPassTexture(InOutInputs.GetInput(EPostProcessMaterialInput::SceneColor));
 }
 
+FSMAAViewTextures FSMAASceneExtension::GetViewTextures(const FRDGBuilder& GraphBuilder, const FSceneView& InView) const
+{
+	check(IsInRenderingThread());
+
+	if (InView.State == nullptr)
+	{
+		return FSMAAViewTextures();
+	}
+
+	const TSharedPtr<FSMAAViewData>* ViewData = ViewDataMap.Find(InView.State->GetViewKey());
+	if (!ViewData || !ViewData->IsValid())
+	{
+		return FSMAAViewTextures();
+	}
+
+	// PreRenderView_RenderThread doesn't run on frames SMAA is inactive, so the textures can outlive their graph.
+	// Builders are often on the stack at the same address every frame, hence the frame check as well
+	const FSMAAViewData& Data = **ViewData;
+	if (Data.PublishedGraphBuilder != &GraphBuilder || Data.PublishedFrame != GFrameCounterRenderThread)
+	{
+		return FSMAAViewTextures();
+	}
+	return Data.PublishedTextures;
+}
+
+FScreenPassTexture FSMAASceneExtension::AddPostProcessMaterialPass(FRDGBuilder& GraphBuilder, const FSceneView& View,
+	const FPostProcessMaterialInputs& Inputs, const FSMAAViewTextures& Textures, const UMaterialInterface* Material)
+{
+	check(View.bIsViewInfo);
+
+	FPostProcessMaterialInputs MaterialInputs = Inputs;
+	if (Textures.IsValid())
+	{
+		MaterialInputs.SetInput(EPostProcessMaterialInput::SeparateTranslucency,
+			FScreenPassTextureSlice::CreateFromScreenPassTexture(GraphBuilder, FScreenPassTexture(Textures.Edges, Textures.ViewRect)));
+		MaterialInputs.SetInput(EPostProcessMaterialInput::CombinedBloom,
+			FScreenPassTextureSlice::CreateFromScreenPassTexture(GraphBuilder, FScreenPassTexture(Textures.BlendWeights, Textures.ViewRect)));
+	}
+
+	return ::AddPostProcessMaterialPass(GraphBuilder, (const FViewInfo&)View, MaterialInputs, Material);
+}
+
+// Wraps a lookup texture as a pooled render target, rewrapping it if the texture's RHI resource has been recreated
+static void CacheLookupTexture(const FTexture2DResource* Resource, TRefCountPtr<IPooledRenderTarget>& Cached, const TCHAR* Name)
+{
+	FRHITexture* TextureRHI = Resource ? Resource->GetTexture2DRHI() : nullptr;
+	if (!TextureRHI)
+	{
+		Cached.SafeRelease();
+		return;
+	}
+
+	if (!Cached.IsValid() || Cached->GetRHI() != TextureRHI)
+	{
+		Cached = CreateRenderTarget(TextureRHI, Name);
+	}
+}
+
+void FSMAASceneExtension::UpdateLookupTextures(FSMAAViewData& ViewData)
+{
+	CacheLookupTexture(SMAAAreaTexture, SMAAAreaTextureRT, TEXT("SMAA.AreaTexture"));
+	CacheLookupTexture(SMAASearchTexture, SMAASearchTextureRT, TEXT("SMAA.SearchTexture"));
+
+	ViewData.SMAAAreaTextureRT = SMAAAreaTextureRT;
+	ViewData.SMAASearchTextureRT = SMAASearchTextureRT;
+}
+
 void FSMAASceneExtension::ApplyJitter(FViewInfo& View, FSceneViewState* ViewState, FIntRect ViewRect, TSharedRef<FSMAAViewData> ViewData)
 {
 	float EffectivePrimaryResolutionFraction = 1.f;// float(ViewRect.Width()) / float(View.GetSecondaryViewRectSize().X);
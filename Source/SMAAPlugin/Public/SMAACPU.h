@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SMAATypes.h"
+
+class UTexture2D;
+
+/**
+ * CPU port of the SMAA compute passes in SMAA_UE5.usf, used where no GPU is available (benchmarks, offline
+ * processing). Every stage mirrors its shader, including the texture sampling, so results match the GPU
+ * passes up to float precision.
+ */
+
+// Four channel float image. Texel (X, Y) covers [X, X + 1) x [Y, Y + 1), like a texture with clamped addressing
+struct SMAAPLUGIN_API FSMAACPUImage
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	TArray<FVector4f> Pixels;
+
+	void Init(int32 InWidth, int32 InHeight);
+
+	bool IsValid() const { return Width > 0 && Height > 0 && Pixels.Num() == Width * Height; }
+
+	FVector4f& At(int32 X, int32 Y) { return Pixels[Y * Width + X]; }
+	const FVector4f& At(int32 X, int32 Y) const { return Pixels[Y * Width + X]; }
+
+	// Point sampling, pixel space
+	const FVector4f& SamplePoint(float X, float Y) const;
+
+	// Bilinear sampling, pixel space. Texel centres are at +0.5
+	FVector4f SampleBilinear(float X, float Y) const;
+
+	SIZE_T GetAllocatedSize() const { return Pixels.GetAllocatedSize(); }
+};
+
+// Inputs for one frame. Only Colour is required
+struct FSMAACPUFrame
+{
+	// Scene colour, linear
+	FSMAACPUImage Colour;
+
+	// Device Z in R, inverted (1 = near). Required by depth edge detection and reprojection
+	FSMAACPUImage Depth;
+
+	// World normal in RGB. Required by normal edge detection
+	FSMAACPUImage Normal;
+
+	// Decoded screen space velocity in RG, camera motion included. Enables reprojection when set with Depth
+	FSMAACPUImage Velocity;
+};
+
+// Area lookup table. The search table is computed arithmetically, so only the area texture is needed
+class SMAAPLUGIN_API FSMAALookupTables
+{
+public:
+	static constexpr int32 AreaTextureWidth = 160;
+	static constexpr int32 AreaTextureHeight = 560;
+
+	// Takes the RG channels of the area texture, normalised to [0, 1]
+	bool InitFromAreaTexels(int32 Width, int32 Height, TArray<FVector2f> Texels);
+
+#if WITH_EDITORONLY_DATA
+	// Reads the area texture's source data, so it works without a GPU
+	bool InitFromTexture(UTexture2D* AreaTexture);
+#endif
+
+	bool IsValid() const { return Area.Num() == AreaTextureWidth * AreaTextureHeight; }
+
+	// Bilinear sample, in texels
+	FVector2f SampleArea(float X, float Y) const;
+
+private:
+	TArray<FVector2f> Area;
+};
+
+struct FSMAACPUSettings
+{
+	// SMAA quality. Selects the threshold and whether diagonal and corner detection run
+	ESMAAPreset Quality = ESMAAPreset::Ultra;
+
+	// What data are we using to detect edges
+	ESMAAEdgeDetectors EdgeMode = ESMAAEdgeDetectors::Luminance;
+
+	uint8 MaxSearchSteps = 8;
+	uint8 MaxDiagonalSearchSteps = 16;
+	uint8 CornerRounding = 25;
+
+	float AdaptationFactor = 2.f;
+
+	float ReprojectionWeight = 25.f;
+	float TemporalHistoryBias = 0.4f;
+
+	// Subpixel indices for the blend weights, see SubpixelJitterWeights. Zero for SMAA 1x
+	FVector4f SubsampleIndices = FVector4f(0, 0, 0, 0);
+
+	// Number of row blocks processed in parallel. 0 uses every worker thread
+	int32 NumThreads = 0;
+};
+
+// Wall time of each stage, in seconds
+struct FSMAACPUStageTimings
+{
+	double EdgeDetection = 0.0;
+	double BlendingWeights = 0.0;
+	double NeighbourhoodBlending = 0.0;
+	double TemporalResolve = 0.0;
+
+	double GetTotal() const { return EdgeDetection + BlendingWeights + NeighbourhoodBlending + TemporalResolve; }
+};
+
+SMAAPLUGIN_API float GetSMAAPresetThreshold(ESMAAPreset Preset);
+
+SMAAPLUGIN_API bool SMAACPUSupportsEdgeMode(const FSMAACPUFrame& Frame, ESMAAEdgeDetectors EdgeMode);
+
+SMAAPLUGIN_API void SMAACPUEdgeDetection(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, FSMAACPUImage& OutEdges);
+
+SMAAPLUGIN_API void SMAACPUBlendingWeights(const FSMAACPUSettings& Settings, const FSMAALookupTables& Tables, const FSMAACPUImage& Edges, FSMAACPUImage& OutBlend);
+
+SMAAPLUGIN_API void SMAACPUNeighbourhoodBlending(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, const FSMAACPUImage& Blend, FSMAACPUImage& OutColour);
+
+SMAAPLUGIN_API void SMAACPUTemporalResolve(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, const FSMAACPUImage& Current, const FSMAACPUImage& Past, FSMAACPUImage& OutResolved);
+
+/**
+ * Runs every stage on a frame, the same way AddSMAAPasses does. The resolve only runs when a history is given,
+ * otherwise OutColour holds the neighbourhood blending result.
+ */
+SMAAPLUGIN_API FSMAACPUStageTimings RunSMAACPU(const FSMAACPUSettings& Settings, const FSMAALookupTables& Tables, const FSMAACPUFrame& Frame, const FSMAACPUImage* History, FSMAACPUImage& OutColour);
+
+// Row access for RunSMAACPUBanded. Both callbacks are called from worker threads
+struct FSMAACPUBandedIO
+{
+	int32 Width = 0;
+	int32 Height = 0;
+
+	// Fills OutFrame with rows [FirstRow, FirstRow + NumRows) of every input the edge detector needs
+	TFunction<void(int32 /*FirstRow*/, int32 /*NumRows*/, FSMAACPUFrame& /*OutFrame*/)> ReadRows;
+
+	// Receives finished rows, in order, starting at FirstRow
+	TFunction<void(int32 /*FirstRow*/, const FSMAACPUImage& /*Rows*/)> WriteRows;
+};
+
+// Rows of context a band needs above and below it so the pattern searches give the same result as a whole frame
+SMAAPLUGIN_API int32 GetSMAACPUBandApron(const FSMAACPUSettings& Settings);
+
+/**
+ * SMAA 1x over horizontal bands of BandHeight rows, for images too large to hold several full size intermediates.
+ * Reading the next band and writing the previous one overlap with processing the current one, so peak memory
+ * depends on the band size and apron rather than the image size. The output matches RunSMAACPU.
+ */
+SMAAPLUGIN_API FSMAACPUStageTimings RunSMAACPUBanded(const FSMAACPUSettings& Settings, const FSMAALookupTables& Tables, const FSMAACPUBandedIO& IO, int32 BandHeight);
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SMAACPU.h"
+
+class UTexture2D;
+
+/**
+ * Runs single SMAA compute passes on the GPU over FSMAACPUImage inputs and reads the result back, for tests and
+ * offline tools comparing the shaders against the CPU port or reference images. Each call runs its own graph and
+ * waits for the GPU, so it's slow and must not be used while rendering. Game thread only.
+ *
+ * Inputs and outputs are 32 bit float textures, 8x8 groups in row order, without tile masks or a view. Every call
+ * returns false without a GPU, e.g. with -nullrhi.
+ */
+
+// Blend weight pass options the CPU port has no equivalent of
+struct FSMAAGPUBlendingWeightsOptions
+{
+	// See r.SMAA.SearchALU. Otherwise the search texture is sampled
+	bool bSearchALU = true;
+
+	// See r.SMAA.SharedRuns. 2 also counts the pixels whose shared runs differ from their own searches
+	uint8 SharedRuns = 0;
+};
+
+SMAAPLUGIN_API bool SMAAGPUEdgeDetection(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, FSMAACPUImage& OutEdges);
+
+// OutSharedRunMismatches receives the count with SharedRuns 2, and 0 otherwise
+SMAAPLUGIN_API bool SMAAGPUBlendingWeights(const FSMAACPUSettings& Settings, const FSMAAGPUBlendingWeightsOptions& Options, UTexture2D* AreaTexture,
+	UTexture2D* SearchTexture, const FSMAACPUImage& Edges, FSMAACPUImage& OutBlend, uint32* OutSharedRunMismatches = nullptr);
+
+// Without reprojection, which needs velocity encoded the way the renderer writes it rather than FSMAACPUFrame's
+SMAAPLUGIN_API bool SMAAGPUNeighbourhoodBlending(const FSMAACPUSettings& Settings, const FSMAACPUFrame& Frame, const FSMAACPUImage& Blend, FSMAACPUImage& OutColour);
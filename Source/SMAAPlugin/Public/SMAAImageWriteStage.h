@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "SMAACPU.h"
+
+class FImageWriteTask;
+class UTexture2D;
+struct FImagePixelData;
+
+/**
+ * SMAA 1x as a pixel pre-processor for the image write queue, so screenshots and other captures that go through
+ * FImagePixelData can be anti-aliased on the queue's worker threads without re-rendering, even when the view
+ * rendered with r.AntiAliasingMethod 0.
+ *
+ * Captured pixels have no depth or normals, so the depth and world normal edge detectors fall back to luminance.
+ */
+class SMAAPLUGIN_API FSMAAImageWriteStage : public TSharedFromThis<FSMAAImageWriteStage, ESPMode::ThreadSafe>
+{
+public:
+	/**
+	 * Call on the game thread. Takes the lookup tables from the area texture's source data where it's available,
+	 * otherwise reads the texture back from the GPU without waiting for it. Either is only done once per process,
+	 * later stages for the same texture share the tables.
+	 */
+	static TSharedRef<FSMAAImageWriteStage, ESPMode::ThreadSafe> Create(const FSMAACPUSettings& InSettings, UTexture2D* AreaTexture = nullptr);
+
+	// The r.SMAA quality and search cvars. Call on the game thread
+	static FSMAACPUSettings GetSettingsFromCVars();
+
+	/**
+	 * Anti-aliases 8 bit, half and full float RGBA pixel data in place. Safe on any thread, but only worker threads,
+	 * such as the image write queue's, wait for lookup tables that are still being read back: the readback needs the
+	 * game and render threads to tick, so on those the pixels are left unprocessed until the tables are ready.
+	 */
+	void Process(FImagePixelData* PixelData) const;
+
+	// Appends the stage to the task's pre-processors, ahead of any added later such as the screenshot alpha mask
+	void AddToTask(FImageWriteTask& Task);
+
+	const FSMAACPUSettings& GetSettings() const { return Settings; }
+
+	// Rows processed at a time, which bounds the intermediate memory for very large captures
+	int32 BandHeight = 256;
+
+private:
+	FSMAACPUSettings Settings;
+	TSharedFuture<TSharedPtr<const FSMAALookupTables, ESPMode::ThreadSafe>> Tables;
+};
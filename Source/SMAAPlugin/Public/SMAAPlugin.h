@@ -17,6 +17,9 @@ public:
 
 	void UpdateExtensions();
 
+	// The scene view extension, e.g. to bind FSMAASceneExtension::OnResolveViewSettings. Invalid before engine init
+	TSharedPtr<FSMAASceneExtension> GetSceneExtension() const { return SMAASceneExtension; }
+
 protected:
 	TSharedPtr<FSMAASceneExtension> SMAASceneExtension;
 };
@@ -5,6 +5,38 @@
 #include "CoreMinimal.h"
 
 #include "SceneViewExtension.h"
+#include "Templates/PimplPtr.h"
+#include "SMAATypes.h"
+
+struct FPostProcessMaterialInputs;
+class UMaterialInterface;
+
+/**
+ * The edges and blend weights SMAA computed for a view this frame, for passes that would otherwise detect edges
+ * again, such as outlines or edge aware sharpening. Both cover the scene colour texture, with the view at ViewRect.
+ * Only valid within the graph that produced them.
+ */
+struct FSMAAViewTextures
+{
+	// Edge detection output. Red marks an edge to the left of the pixel, green an edge above it
+	FRDGTextureRef Edges = nullptr;
+
+	// Blend weight output. Red and green weight the edge above the pixel, blue and alpha the edge to its left
+	FRDGTextureRef BlendWeights = nullptr;
+
+	FIntRect ViewRect;
+
+	bool IsValid() const
+	{
+		return Edges != nullptr && BlendWeights != nullptr;
+	}
+};
+
+/**
+ * Called on the render thread right after SMAA's passes for a view were added, with the graph they were added to.
+ * Binding it publishes the textures for every view.
+ */
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FSMAAViewTexturesPublished, FRDGBuilder& /*GraphBuilder*/, const FSceneView& /*View*/, const FSMAAViewTextures& /*Textures*/);
 
 // Structure in charge of storing all information about SMAA's history.
 struct SMAAPLUGIN_API FSMAAHistory
@@ -27,10 +59,22 @@ struct SMAAPLUGIN_API FSMAAHistory
 		return PastFrame.IsValid();
 	}
 
-	//uint64 GetGPUSizeBytes(bool bLogSizes) const
-	//{
-	//	return GetRenderTargetGPUSizeBytes(PastFrame, bLogSizes);
-	//}
+	// GPU memory held by the history. Optionally logs it, like the engine's TAA and TSR histories
+	uint64 GetGPUSizeBytes(bool bLogSizes) const;
+};
+
+// GPU memory SMAA used for a view, besides its history
+struct FSMAAViewMemory
+{
+	// Platform size of the textures and buffers created for the view's last SMAA frame, output included. Only alive for
+	// that frame, bar r.SMAA.StaticReuse's small state buffer
+	uint64 TransientBytes = 0;
+
+	// Platform size of the r.SMAA.CaptureInputs targets and readbacks of the view's last frame, zero when not capturing
+	uint64 CaptureBytes = 0;
+
+	// Extent those textures were created at
+	FIntPoint TransientExtent = FIntPoint::ZeroValue;
 };
 
 struct SMAAPLUGIN_API FSMAAViewData : public TSharedFromThis<FSMAAViewData, ESPMode::ThreadSafe>
@@ -39,9 +83,32 @@ struct SMAAPLUGIN_API FSMAAViewData : public TSharedFromThis<FSMAAViewData, ESPM
 	const FTexture2DResource* SMAAAreaTexture;
 	const FTexture2DResource* SMAASearchTexture;
 
+	// The lookup textures wrapped as pooled render targets, shared between all views
+	TRefCountPtr<IPooledRenderTarget> SMAAAreaTextureRT;
+	TRefCountPtr<IPooledRenderTarget> SMAASearchTextureRT;
+
 	int32 JitterIndex;
 	FSMAAHistory SMAAHistory;
 
+	// Settings for the frame being rendered, resolved in PreRenderView_RenderThread
+	FSMAAViewSettings Settings;
+
+	// Pending GPU readbacks for r.SMAA.EdgeStats, created on first use
+	TSharedPtr<class FSMAAEdgeStatsReadback> EdgeStats;
+
+	// Static frame detection state for r.SMAA.StaticReuse, created on first use
+	TSharedPtr<class FSMAAStaticFrame> StaticFrame;
+
+	// Memory accounting for stat SMAA and r.SMAA.MemReport
+	FSMAAViewMemory Memory;
+
+	// This frame's edges and blend weights, if published. Reset in PreRenderView_RenderThread
+	FSMAAViewTextures PublishedTextures;
+
+	// The graph and render thread frame PublishedTextures were created in, so no other graph is handed its textures
+	const FRDGBuilder* PublishedGraphBuilder = nullptr;
+	uint64 PublishedFrame = 0;
+
 	virtual ~FSMAAViewData() {};
 };
 
@@ -68,6 +135,11 @@ public:
      */
 	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) {};
 
+	/**
+	 * Called on render thread before any view of the family is rendered. Takes the cvar snapshot used by every view.
+	 */
+	virtual void PreRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily) override;
+
 	virtual void PreRenderView_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView) override;
 
 	/**
@@ -79,6 +151,33 @@ public:
 
 	virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
 
+	// Logs the GPU memory SMAA holds, per view and in total. Render thread only, see r.SMAA.MemReport
+	void LogMemoryReport() const;
+
+	/**
+	 * Per-view override of the SMAA settings, e.g. to disable SMAA or T2x for a minimap capture.
+	 * Broadcast on the render thread, see FSMAAResolveViewSettings.
+	 */
+	FSMAAResolveViewSettings OnResolveViewSettings;
+
+	// Broadcast with every view's edges and blend weights, see FSMAAViewTexturesPublished
+	FSMAAViewTexturesPublished OnViewTexturesPublished;
+
+	/**
+	 * The view's edges and blend weights, once SMAA has run for it this frame with textures published, see
+	 * FSMAAViewSettings::bPublishTextures. Render thread only. Empty unless GraphBuilder is the graph that SMAA ran
+	 * in, as the textures belong to that graph and are gone once it has executed.
+	 */
+	FSMAAViewTextures GetViewTextures(const FRDGBuilder& GraphBuilder, const FSceneView& InView) const;
+
+	/**
+	 * Runs a post process material with SMAA's textures bound as its scene texture inputs: PostProcessInput1 is the
+	 * edges and PostProcessInput2 the blend weights. PostProcessInput0 stays the scene colour from Inputs.
+	 * For use from post processing pass callbacks after SMAA's.
+	 */
+	static FScreenPassTexture AddPostProcessMaterialPass(FRDGBuilder& GraphBuilder, const FSceneView& View,
+		const FPostProcessMaterialInputs& Inputs, const FSMAAViewTextures& Textures, const UMaterialInterface* Material);
+
 protected:
 	virtual FScreenPassTexture PostProcessPass_RenderThread(
 		FRDGBuilder& GraphBuilder,
@@ -91,7 +190,20 @@ protected:
 	FTexture2DResource* SMAAAreaTexture;
 	FTexture2DResource* SMAASearchTexture;
 
+	// Render thread only. Built on first use so RDG can register them by lookup rather than
+	// creating a new external texture for every view, every frame
+	TRefCountPtr<IPooledRenderTarget> SMAAAreaTextureRT;
+	TRefCountPtr<IPooledRenderTarget> SMAASearchTextureRT;
+
 	TMap<uint32, TSharedPtr<FSMAAViewData>> ViewDataMap;
 
+	// Render thread only. Cvars as read at the start of the current view family
+	TPimplPtr<struct FSMAAInputs> CVarSnapshot;
+	bool bVisualize = false;
+
+	FSMAAViewSettings ResolveViewSettings(const FSceneView& InView) const;
+
+	void UpdateLookupTextures(FSMAAViewData& ViewData);
+
 	void ApplyJitter(FViewInfo& View, FSceneViewState* ViewState, FIntRect ViewRect, TSharedRef<FSMAAViewData> ViewData);
 };
@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FGlobalShaderType;
+
+// The compute shaders of the edge detection, blend weight, neighbourhood blending and temporal resolve passes, for
+// offline tools such as the SMAAShaderCost commandlet
+SMAAPLUGIN_API TArray<const FGlobalShaderType*> GetSMAAPassShaderTypes();
+
+// A permutation of one of those shaders by the value of each dimension's define, e.g. "SMAA_PRESET=3 SMAA_TILE_MASK=0".
+// Unlike the permutation id, it doesn't shift for every other permutation when a dimension is added
+SMAAPLUGIN_API FString DescribeSMAAShaderPermutation(const FGlobalShaderType* ShaderType, int32 PermutationId);
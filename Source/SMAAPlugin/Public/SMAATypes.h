@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Delegates/Delegate.h"
+
+class FSceneView;
+
+enum class ESMAAEdgeDetectors : uint8
+{
+	Depth,
+	Luminance,
+	Colour,
+	Normal,
+
+	MAX UMETA(HIDDEN)
+};
+
+enum class ESMAAPreset : uint8
+{
+	Low,
+	Medium,
+	High,
+	Ultra,
+
+	// Ultra's threshold, diagonal and corner detection, with the search parameters from their cvars
+	Custom,
+
+	MAX UMETA(HIDDEN)
+};
+
+enum class ESMAAPredicationTexture : uint8
+{
+	None,
+	Depth,
+	WorldNormal,
+	MRS,
+
+	MAX UMETA(HIDDEN)
+};
+
+// Settings SMAA runs with for a single view, resolved each frame on the render thread
+struct FSMAAViewSettings
+{
+	// Whether SMAA runs for this view at all
+	bool bEnabled = true;
+
+	// SMAA quality.
+	ESMAAPreset Quality = ESMAAPreset::Ultra;
+
+	// What data are we using to detect edges
+	ESMAAEdgeDetectors EdgeMode = ESMAAEdgeDetectors::Normal;
+
+	// SMAA T2x: projection jitter, temporal resolve and history. SMAA 1x when off. Defaults to r.SMAA.Mode
+	bool bTemporal = true;
+
+	/**
+	 * Pixels on each side of the view rect that belong to neighbouring tiles, for tiled renders such as
+	 * Movie Render Queue's high resolution tiles. Edges and blend weights are computed over the whole
+	 * padded tile, but only the interior is anti-aliased. Needs to be at least GetSMAASearchApron
+	 * for the interior to match an untiled render; a negative value uses exactly that.
+	 */
+	FIntPoint TileOverlap = FIntPoint::ZeroValue;
+
+	/**
+	 * Custom stencil value marking pixels SMAA leaves alone, such as world space UI or objects that are already
+	 * smooth. 0 for none. Needs custom depth with stencil. Defaults to r.SMAA.SkipStencil.
+	 */
+	uint8 SkipStencil = 0;
+
+	/**
+	 * Rects in view space SMAA leaves alone, such as HUD elements drawn into the scene or letterbox bars.
+	 * Up to MaxSkipRects are used. Pixels outside the view rect are always skipped.
+	 *
+	 * Both masks apply at 8x8 tile granularity: a tile is only skipped when every pixel in it is masked, in which
+	 * case edge detection, blend weights and blending all skip it and its scene colour passes through unchanged.
+	 * Compute path only.
+	 */
+	TArray<FIntRect> SkipRects;
+
+	/**
+	 * Keep the edges and blend weights for other passes this frame, see FSMAASceneExtension::GetViewTextures.
+	 * Always on while FSMAASceneExtension::OnViewTexturesPublished is bound. T2x needs one more intermediate for it.
+	 */
+	bool bPublishTextures = false;
+
+	static constexpr int32 MaxSkipRects = 8;
+};
+
+/**
+ * Pixels of context the pattern searches need around a pixel for its blend weights, and so its
+ * anti-aliased colour, to be the same as with the whole image available.
+ */
+SMAAPLUGIN_API int32 GetSMAASearchApron(ESMAAPreset Quality, int32 MaxSearchSteps, int32 MaxDiagonalSearchSteps);
+
+/**
+ * Search parameters a preset bakes into its shader permutations, as in the reference implementation's presets.
+ * Leaves them untouched and returns false for Custom, which takes them at runtime.
+ */
+SMAAPLUGIN_API bool GetSMAAPresetSearchSettings(ESMAAPreset Quality, uint8& OutMaxSearchSteps, uint8& OutMaxDiagonalSearchSteps, uint8& OutCornerRounding);
+
+/**
+ * Called on the render thread for every view SMAA may run on, after the cvar and scene capture defaults
+ * have been applied. Bind it before rendering starts, and only read view state from the callback.
+ */
+DECLARE_MULTICAST_DELEGATE_TwoParams(FSMAAResolveViewSettings, const FSceneView& /*View*/, FSMAAViewSettings& /*InOutSettings*/);
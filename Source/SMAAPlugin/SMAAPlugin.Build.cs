@@ -27,7 +27,10 @@ public class SMAAPlugin : ModuleRules
 				"Engine",
 				"Slate",
 				"SlateCore",
-                "Projects"
+                "Projects",
+                "ImageCore",
+                "ImageWriteQueue",
+                "Json"
             }
 		);
 
@@ -0,0 +1,341 @@
+#include "SMAABenchmarkCommandlet.h"
+
+#include "SMAACPU.h"
+#include "SMAACommandletUtils.h"
+#include "SMAADeveloperSettings.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Dom/JsonObject.h"
+#include "HAL/PlatformMemory.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSMAABenchmark, Log, All);
+
+namespace SMAABenchmark
+{
+	struct FResult
+	{
+		FString Frame;
+		int32 Width = 0;
+		int32 Height = 0;
+		ESMAAPreset Preset = ESMAAPreset::Ultra;
+		ESMAAEdgeDetectors EdgeMode = ESMAAEdgeDetectors::Luminance;
+		int32 MaxSearchSteps = 0;
+		int32 MaxDiagonalSearchSteps = 0;
+		int32 CornerRounding = 0;
+		int32 NumThreads = 0;
+
+		// Fastest iteration
+		FSMAACPUStageTimings Timings;
+
+		double MegapixelsPerSecond = 0.0;
+
+		// Against the single threaded run of the same configuration, when there is one
+		double ThreadSpeedup = 0.0;
+
+		uint64 PeakUsedPhysical = 0;
+	};
+
+	void CopyRows(const FSMAACPUImage& Source, int32 FirstRow, int32 NumRows, FSMAACPUImage& OutRows)
+	{
+		if (!Source.IsValid())
+		{
+			return;
+		}
+
+		OutRows.Init(Source.Width, NumRows);
+		FMemory::Memcpy(OutRows.Pixels.GetData(), &Source.At(0, FirstRow), OutRows.Pixels.Num() * sizeof(FVector4f));
+	}
+
+	// Streams a frame already in memory through RunSMAACPUBanded, so only the banded processing is measured
+	FSMAACPUStageTimings RunBanded(const FSMAACPUSettings& Settings, const FSMAALookupTables& Tables, const FSMAACPUFrame& Frame, int32 BandHeight, FSMAACPUImage& OutColour)
+	{
+		OutColour.Init(Frame.Colour.Width, Frame.Colour.Height);
+
+		FSMAACPUBandedIO IO;
+		IO.Width = Frame.Colour.Width;
+		IO.Height = Frame.Colour.Height;
+		IO.ReadRows = [&Frame](int32 FirstRow, int32 NumRows, FSMAACPUFrame& OutFrame)
+		{
+			CopyRows(Frame.Colour, FirstRow, NumRows, OutFrame.Colour);
+			CopyRows(Frame.Depth, FirstRow, NumRows, OutFrame.Depth);
+			CopyRows(Frame.Normal, FirstRow, NumRows, OutFrame.Normal);
+		};
+		IO.WriteRows = [&OutColour](int32 FirstRow, const FSMAACPUImage& Rows)
+		{
+			FMemory::Memcpy(&OutColour.At(0, FirstRow), Rows.Pixels.GetData(), Rows.Pixels.Num() * sizeof(FVector4f));
+		};
+
+		return RunSMAACPUBanded(Settings, Tables, IO, BandHeight);
+	}
+
+	FString ToCSV(const TArray<FResult>& Results)
+	{
+		FString CSV = TEXT("Frame,Width,Height,Preset,EdgeDetector,MaxSearchSteps,MaxDiagonalSearchSteps,CornerRounding,Threads,EdgeDetectionMs,BlendingWeightsMs,NeighbourhoodBlendingMs,TemporalResolveMs,TotalMs,MegapixelsPerSecond,ThreadSpeedup,PeakUsedPhysicalMB\n");
+		for (const FResult& Result : Results)
+		{
+			CSV += FString::Printf(TEXT("%s,%d,%d,%s,%s,%d,%d,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%.1f\n"),
+				*Result.Frame, Result.Width, Result.Height,
+				SMAAPresetNames[uint8(Result.Preset)], SMAAEdgeDetectorNames[uint8(Result.EdgeMode)],
+				Result.MaxSearchSteps, Result.MaxDiagonalSearchSteps, Result.CornerRounding, Result.NumThreads,
+				Result.Timings.EdgeDetection * 1000.0, Result.Timings.BlendingWeights * 1000.0,
+				Result.Timings.NeighbourhoodBlending * 1000.0, Result.Timings.TemporalResolve * 1000.0,
+				Result.Timings.GetTotal() * 1000.0, Result.MegapixelsPerSecond, Result.ThreadSpeedup,
+				double(Result.PeakUsedPhysical) / (1024.0 * 1024.0));
+		}
+		return CSV;
+	}
+
+	FString ToJSON(const TArray<FResult>& Results, int32 Iterations, bool bTemporal, int32 BandHeight)
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+
+		TSharedRef<FJsonObject> Machine = MakeShared<FJsonObject>();
+		Machine->SetStringField(TEXT("CPU"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+		Machine->SetNumberField(TEXT("Cores"), FPlatformMisc::NumberOfCores());
+		Machine->SetNumberField(TEXT("LogicalCores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+		Machine->SetNumberField(TEXT("WorkerThreads"), FTaskGraphInterface::Get().GetNumWorkerThreads());
+		Root->SetObjectField(TEXT("Machine"), Machine);
+
+		Root->SetNumberField(TEXT("Iterations"), Iterations);
+		Root->SetBoolField(TEXT("Temporal"), bTemporal);
+		Root->SetNumberField(TEXT("BandHeight"), BandHeight);
+		Root->SetNumberField(TEXT("PeakUsedPhysicalMB"), double(FPlatformMemory::GetStats().PeakUsedPhysical) / (1024.0 * 1024.0));
+
+		TArray<TSharedPtr<FJsonValue>> Entries;
+		for (const FResult& Result : Results)
+		{
+			TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+			Entry->SetStringField(TEXT("Frame"), Result.Frame);
+			Entry->SetNumberField(TEXT("Width"), Result.Width);
+			Entry->SetNumberField(TEXT("Height"), Result.Height);
+			Entry->SetStringField(TEXT("Preset"), SMAAPresetNames[uint8(Result.Preset)]);
+			Entry->SetStringField(TEXT("EdgeDetector"), SMAAEdgeDetectorNames[uint8(Result.EdgeMode)]);
+			Entry->SetNumberField(TEXT("MaxSearchSteps"), Result.MaxSearchSteps);
+			Entry->SetNumberField(TEXT("MaxDiagonalSearchSteps"), Result.MaxDiagonalSearchSteps);
+			Entry->SetNumberField(TEXT("CornerRounding"), Result.CornerRounding);
+			Entry->SetNumberField(TEXT("Threads"), Result.NumThreads);
+
+			TSharedRef<FJsonObject> Stages = MakeShared<FJsonObject>();
+			Stages->SetNumberField(TEXT("EdgeDetection"), Result.Timings.EdgeDetection * 1000.0);
+			Stages->SetNumberField(TEXT("BlendingWeights"), Result.Timings.BlendingWeights * 1000.0);
+			Stages->SetNumberField(TEXT("NeighbourhoodBlending"), Result.Timings.NeighbourhoodBlending * 1000.0);
+			Stages->SetNumberField(TEXT("TemporalResolve"), Result.Timings.TemporalResolve * 1000.0);
+			Entry->SetObjectField(TEXT("StageMs"), Stages);
+
+			Entry->SetNumberField(TEXT("TotalMs"), Result.Timings.GetTotal() * 1000.0);
+			Entry->SetNumberField(TEXT("MegapixelsPerSecond"), Result.MegapixelsPerSecond);
+			Entry->SetNumberField(TEXT("ThreadSpeedup"), Result.ThreadSpeedup);
+			Entry->SetNumberField(TEXT("PeakUsedPhysicalMB"), double(Result.PeakUsedPhysical) / (1024.0 * 1024.0));
+			Entries.Add(MakeShared<FJsonValueObject>(Entry));
+		}
+		Root->SetArrayField(TEXT("Results"), Entries);
+
+		FString JSON;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JSON);
+		FJsonSerializer::Serialize(Root, Writer);
+		return JSON;
+	}
+}
+
+USMAABenchmarkCommandlet::USMAABenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 USMAABenchmarkCommandlet::Main(const FString& Params)
+{
+	using namespace SMAABenchmark;
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	const FString InputPath = ParamValues.FindRef(TEXT("Input"));
+	if (InputPath.IsEmpty())
+	{
+		UE_LOG(LogSMAABenchmark, Error, TEXT("Missing -Input=<Directory or file>"));
+		return 1;
+	}
+
+	const FString OutputDir = ParamValues.Contains(TEXT("Output")) ? ParamValues[TEXT("Output")] : FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SMAA"), TEXT("Benchmark"));
+	TArray<uint8> Presets = ParseSMAANameList(ParamValues.Contains(TEXT("Presets")) ? ParamValues[TEXT("Presets")] : TEXT("Low,Medium,High,Ultra"), SMAAPresetNames);
+	TArray<uint8> EdgeModes = ParseSMAANameList(ParamValues.Contains(TEXT("EdgeDetectors")) ? ParamValues[TEXT("EdgeDetectors")] : TEXT("Luminance,Colour,Depth,Normal"), SMAAEdgeDetectorNames);
+	TArray<int32> SearchSteps = ParseSMAAIntList(ParamValues.Contains(TEXT("SearchSteps")) ? ParamValues[TEXT("SearchSteps")] : TEXT("4,8,16,32"));
+	const int32 MaxThreads = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const TArray<int32> ThreadCounts = ParseSMAAIntList(ParamValues.Contains(TEXT("Threads")) ? ParamValues[TEXT("Threads")] : FString::Printf(TEXT("1,%d"), MaxThreads));
+	const int32 Iterations = FMath::Max(1, ParamValues.Contains(TEXT("Iterations")) ? FCString::Atoi(*ParamValues[TEXT("Iterations")]) : 3);
+	bool bTemporal = Switches.Contains(TEXT("Temporal"));
+	const int32 BandHeight = ParamValues.Contains(TEXT("BandHeight")) ? FCString::Atoi(*ParamValues[TEXT("BandHeight")]) : 0;
+
+	// Replays a bundle from r.SMAA.CaptureInputs with the settings it was captured with, rather than sweeping them
+	FSMAACPUSettings BaseSettings;
+	if (Switches.Contains(TEXT("CaptureSettings")))
+	{
+		if (!LoadSMAACaptureSettings(InputPath, BaseSettings, bTemporal))
+		{
+			UE_LOG(LogSMAABenchmark, Error, TEXT("-CaptureSettings needs an SMAACapture.json next to the input"));
+			return 1;
+		}
+
+		Presets = { uint8(BaseSettings.Quality) };
+		EdgeModes = { uint8(BaseSettings.EdgeMode) };
+		SearchSteps = { BaseSettings.MaxSearchSteps };
+	}
+
+	if (bTemporal && BandHeight > 0)
+	{
+		UE_LOG(LogSMAABenchmark, Error, TEXT("-BandHeight only supports SMAA 1x, drop -Temporal"));
+		return 1;
+	}
+
+	// The area texture is read from its source data, which is why this is an editor commandlet
+	USMAADeveloperSettings::Get()->LoadTextures();
+
+	FSMAALookupTables Tables;
+	if (!Tables.InitFromTexture(USMAADeveloperSettings::Get()->SMAAAreaTexture))
+	{
+		UE_LOG(LogSMAABenchmark, Error, TEXT("Could not read the SMAA area texture"));
+		return 1;
+	}
+
+	const TArray<FSMAACorpusFrame> Frames = LoadSMAACorpus(InputPath);
+	if (Frames.IsEmpty())
+	{
+		UE_LOG(LogSMAABenchmark, Error, TEXT("No frames found in %s"), *InputPath);
+		return 1;
+	}
+
+	TArray<FResult> Results;
+
+	for (const FSMAACorpusFrame& Frame : Frames)
+	{
+		const double Megapixels = double(Frame.Inputs.Colour.Width) * Frame.Inputs.Colour.Height / 1e6;
+
+		for (uint8 EdgeModeIndex : EdgeModes)
+		{
+			const ESMAAEdgeDetectors EdgeMode = ESMAAEdgeDetectors(EdgeModeIndex);
+
+			if (!SMAACPUSupportsEdgeMode(Frame.Inputs, EdgeMode))
+			{
+				UE_LOG(LogSMAABenchmark, Display, TEXT("%s: no input for %s edge detection, skipping"), *Frame.Name, SMAAEdgeDetectorNames[uint8(EdgeMode)]);
+				continue;
+			}
+
+			for (uint8 PresetIndex : Presets)
+			{
+				const ESMAAPreset Preset = ESMAAPreset(PresetIndex);
+
+				// Presets run with the search parameters their permutations bake in, so only Custom sweeps the steps
+				FSMAACPUSettings PresetSettings = BaseSettings;
+				TArray<int32> PresetSearchSteps = SearchSteps;
+				if (GetSMAAPresetSearchSettings(Preset, PresetSettings.MaxSearchSteps, PresetSettings.MaxDiagonalSearchSteps, PresetSettings.CornerRounding))
+				{
+					PresetSearchSteps = { PresetSettings.MaxSearchSteps };
+				}
+
+				for (int32 Steps : PresetSearchSteps)
+				{
+					const int32 FirstResult = Results.Num();
+
+					for (int32 NumThreads : ThreadCounts)
+					{
+						FSMAACPUSettings Settings = PresetSettings;
+						Settings.Quality = Preset;
+						Settings.EdgeMode = EdgeMode;
+						Settings.MaxSearchSteps = uint8(FMath::Clamp(Steps, 0, 112));
+						Settings.NumThreads = FMath::Max(NumThreads, 0);
+
+						FResult& Result = Results.AddDefaulted_GetRef();
+						Result.Frame = Frame.Name;
+						Result.Width = Frame.Inputs.Colour.Width;
+						Result.Height = Frame.Inputs.Colour.Height;
+						Result.Preset = Preset;
+						Result.EdgeMode = EdgeMode;
+						Result.MaxSearchSteps = Settings.MaxSearchSteps;
+						Result.MaxDiagonalSearchSteps = Settings.MaxDiagonalSearchSteps;
+						Result.CornerRounding = Settings.CornerRounding;
+						Result.NumThreads = Settings.NumThreads;
+
+						// For T2x, each iteration resolves against the previous one's output. A captured frame keeps the
+						// subpixel indices it was captured with, and only resolves if the GPU did
+						FSMAACPUImage History;
+						FSMAACPUImage Output;
+						double BestTotal = TNumericLimits<double>::Max();
+						const bool bResolve = bTemporal && (!Frame.bCaptured || Frame.CanResolve());
+
+						for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+						{
+							if (bTemporal)
+							{
+								Settings.SubsampleIndices = Frame.bCaptured ? Frame.GetSubsampleIndices() : (Iteration & 1 ? FVector4f(2, 2, 2, 0) : FVector4f(1, 1, 1, 0));
+							}
+							else
+							{
+								Settings.SubsampleIndices = FVector4f(0, 0, 0, 0);
+							}
+
+							const FSMAACPUStageTimings Timings = BandHeight > 0
+								? RunBanded(Settings, Tables, Frame.Inputs, BandHeight, Output)
+								: RunSMAACPU(Settings, Tables, Frame.Inputs, bResolve && History.IsValid() ? &History : nullptr, Output);
+							if (Timings.GetTotal() < BestTotal)
+							{
+								BestTotal = Timings.GetTotal();
+								Result.Timings = Timings;
+							}
+
+							if (bResolve)
+							{
+								Swap(History, Output);
+							}
+						}
+
+						Result.MegapixelsPerSecond = BestTotal > 0.0 ? Megapixels / BestTotal : 0.0;
+						Result.PeakUsedPhysical = FPlatformMemory::GetStats().PeakUsedPhysical;
+
+						UE_LOG(LogSMAABenchmark, Display, TEXT("%s %s %s steps %d threads %d: %.2f ms, %.1f MP/s"),
+							*Frame.Name, SMAAPresetNames[uint8(Preset)], SMAAEdgeDetectorNames[uint8(EdgeMode)], Result.MaxSearchSteps,
+							Result.NumThreads, BestTotal * 1000.0, Result.MegapixelsPerSecond);
+					}
+
+					// Thread scaling against the single threaded run of this configuration
+					const FResult* SingleThreaded = nullptr;
+					for (int32 Index = FirstResult; Index < Results.Num(); ++Index)
+					{
+						if (Results[Index].NumThreads == 1)
+						{
+							SingleThreaded = &Results[Index];
+						}
+					}
+
+					if (SingleThreaded && SingleThreaded->Timings.GetTotal() > 0.0)
+					{
+						const double SingleThreadedTotal = SingleThreaded->Timings.GetTotal();
+						for (int32 Index = FirstResult; Index < Results.Num(); ++Index)
+						{
+							Results[Index].ThreadSpeedup = SingleThreadedTotal / FMath::Max(Results[Index].Timings.GetTotal(), UE_SMALL_NUMBER);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	const FString CSVPath = FPaths::Combine(OutputDir, TEXT("SMAABenchmark.csv"));
+	const FString JSONPath = FPaths::Combine(OutputDir, TEXT("SMAABenchmark.json"));
+
+	if (!FFileHelper::SaveStringToFile(ToCSV(Results), *CSVPath) || !FFileHelper::SaveStringToFile(ToJSON(Results, Iterations, bTemporal, BandHeight), *JSONPath))
+	{
+		UE_LOG(LogSMAABenchmark, Error, TEXT("Could not write the results to %s"), *OutputDir);
+		return 1;
+	}
+
+	UE_LOG(LogSMAABenchmark, Display, TEXT("Wrote %d results to %s and %s"), Results.Num(), *CSVPath, *JSONPath);
+	return 0;
+}
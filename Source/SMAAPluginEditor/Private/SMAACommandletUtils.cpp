@@ -0,0 +1,275 @@
+#include "SMAACommandletUtils.h"
+
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "ImageCore.h"
+#include "ImageUtils.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSMAACommandlet, Log, All);
+
+const TCHAR* SMAAPresetNames[5] = { TEXT("Low"), TEXT("Medium"), TEXT("High"), TEXT("Ultra"), TEXT("Custom") };
+const TCHAR* SMAAEdgeDetectorNames[4] = { TEXT("Depth"), TEXT("Luminance"), TEXT("Colour"), TEXT("Normal") };
+
+TArray<uint8> ParseSMAANameList(const FString& List, TConstArrayView<const TCHAR*> Names)
+{
+	TArray<FString> Entries;
+	List.ParseIntoArray(Entries, TEXT(","));
+
+	TArray<uint8> Values;
+	for (const FString& Entry : Entries)
+	{
+		uint8 Index = 0;
+		while (Index < Names.Num() && !Entry.Equals(Names[Index], ESearchCase::IgnoreCase))
+		{
+			Index++;
+		}
+
+		if (Index < Names.Num())
+		{
+			Values.AddUnique(Index);
+		}
+		else
+		{
+			UE_LOG(LogSMAACommandlet, Warning, TEXT("Ignoring unknown value '%s'"), *Entry);
+		}
+	}
+	return Values;
+}
+
+TArray<int32> ParseSMAAIntList(const FString& List)
+{
+	TArray<FString> Entries;
+	List.ParseIntoArray(Entries, TEXT(","));
+
+	TArray<int32> Values;
+	for (const FString& Entry : Entries)
+	{
+		Values.AddUnique(FCString::Atoi(*Entry));
+	}
+	return Values;
+}
+
+bool LoadSMAACPUImage(const FString& Filename, FSMAACPUImage& OutImage)
+{
+	FImage Image;
+	if (!FImageUtils::LoadImage(*Filename, Image))
+	{
+		return false;
+	}
+
+	FImage LinearImage;
+	Image.CopyTo(LinearImage, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+
+	const TArrayView64<FLinearColor> Colours = LinearImage.AsRGBA32F();
+
+	OutImage.Init(LinearImage.SizeX, LinearImage.SizeY);
+	for (int32 Index = 0; Index < OutImage.Pixels.Num(); ++Index)
+	{
+		OutImage.Pixels[Index] = FVector4f(Colours[Index].R, Colours[Index].G, Colours[Index].B, Colours[Index].A);
+	}
+	return true;
+}
+
+bool SaveSMAACPUImage(const FString& Filename, const FSMAACPUImage& Image)
+{
+	FImage Output(Image.Width, Image.Height, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+
+	const TArrayView64<FLinearColor> Colours = Output.AsRGBA32F();
+	for (int32 Index = 0; Index < Image.Pixels.Num(); ++Index)
+	{
+		const FVector4f& Pixel = Image.Pixels[Index];
+		Colours[Index] = FLinearColor(Pixel.X, Pixel.Y, Pixel.Z, Pixel.W);
+	}
+
+	return FImageUtils::SaveImageByExtension(*Filename, Output);
+}
+
+bool FindSMAACompanion(const FString& BasePath, const TCHAR* Suffix, FString& OutFilename)
+{
+	for (const TCHAR* Extension : { TEXT(".exr"), TEXT(".png") })
+	{
+		OutFilename = BasePath + Suffix + Extension;
+		if (IFileManager::Get().FileExists(*OutFilename))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+namespace SMAACommandletUtils
+{
+	void LoadCompanion(const FString& BasePath, const TCHAR* Suffix, const FSMAACPUImage& Colour, FSMAACPUImage& OutImage)
+	{
+		FString Filename;
+		if (!FindSMAACompanion(BasePath, Suffix, Filename))
+		{
+			return;
+		}
+
+		if (LoadSMAACPUImage(Filename, OutImage) && (OutImage.Width != Colour.Width || OutImage.Height != Colour.Height))
+		{
+			UE_LOG(LogSMAACommandlet, Warning, TEXT("%s does not match the frame size, ignoring it"), *Filename);
+			OutImage = FSMAACPUImage();
+		}
+	}
+
+	TSharedPtr<FJsonObject> LoadCaptureMetadata(const FString& Filename)
+	{
+		FString JSON;
+		TSharedPtr<FJsonObject> Root;
+		if (!FFileHelper::LoadFileToString(JSON, *Filename) || !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JSON), Root))
+		{
+			return nullptr;
+		}
+		return Root;
+	}
+
+	// Fills in the view and T2x state of each frame, from the bundle's metadata when there is any
+	void LoadFrameStates(const FString& Directory, TArray<FSMAACorpusFrame>& Frames)
+	{
+		TMap<FString, TSharedPtr<FJsonObject>> ViewsByName;
+		const TSharedPtr<FJsonObject> Root = LoadCaptureMetadata(FPaths::Combine(Directory, TEXT("SMAACapture.json")));
+		const TArray<TSharedPtr<FJsonValue>>* Views = nullptr;
+		if (Root.IsValid() && Root->TryGetArrayField(TEXT("Views"), Views))
+		{
+			for (const TSharedPtr<FJsonValue>& Value : *Views)
+			{
+				const TSharedPtr<FJsonObject>& View = Value->AsObject();
+				if (View.IsValid())
+				{
+					ViewsByName.Add(View->GetStringField(TEXT("Name")), View);
+				}
+			}
+		}
+
+		TMap<int32, int32> FramesPerView;
+		for (FSMAACorpusFrame& Frame : Frames)
+		{
+			if (const TSharedPtr<FJsonObject>* View = ViewsByName.Find(FPaths::GetCleanFilename(Frame.BasePath)))
+			{
+				Frame.bCaptured = true;
+				Frame.View = (*View)->GetIntegerField(TEXT("View"));
+				Frame.JitterIndex = (*View)->GetIntegerField(TEXT("JitterIndex"));
+				Frame.bHistoryValid = (*View)->GetBoolField(TEXT("HistoryValid"));
+				Frame.bCameraCut = (*View)->GetBoolField(TEXT("CameraCut"));
+			}
+			else
+			{
+				int32& Count = FramesPerView.FindOrAdd(Frame.View);
+				Frame.JitterIndex = Count;
+				Frame.bHistoryValid = Count > 0;
+				Count++;
+			}
+		}
+
+		// Name order puts View1_Frame0000 after View0_Frame0000, interleaving the views. Keep each view's frames together
+		Frames.StableSort([](const FSMAACorpusFrame& A, const FSMAACorpusFrame& B) { return A.View < B.View; });
+	}
+
+	bool IsCompanion(const FString& BaseName)
+	{
+		return BaseName.EndsWith(TEXT("_depth")) || BaseName.EndsWith(TEXT("_normal")) || BaseName.EndsWith(TEXT("_velocity")) || BaseName.EndsWith(TEXT("_reference"))
+			|| BaseName.EndsWith(TEXT("_gbuffera")) || BaseName.EndsWith(TEXT("_gbufferb"));
+	}
+}
+
+TArray<FSMAACorpusFrame> LoadSMAACorpus(const FString& InputPath)
+{
+	using namespace SMAACommandletUtils;
+
+	TArray<FString> Files;
+	if (IFileManager::Get().DirectoryExists(*InputPath))
+	{
+		for (const TCHAR* Pattern : { TEXT("*.exr"), TEXT("*.png") })
+		{
+			TArray<FString> Found;
+			IFileManager::Get().FindFiles(Found, *FPaths::Combine(InputPath, Pattern), true, false);
+			for (const FString& File : Found)
+			{
+				Files.Add(FPaths::Combine(InputPath, File));
+			}
+		}
+		Files.Sort();
+	}
+	else
+	{
+		Files.Add(InputPath);
+	}
+
+	TArray<FSMAACorpusFrame> Frames;
+	for (const FString& File : Files)
+	{
+		const FString BasePath = FPaths::Combine(FPaths::GetPath(File), FPaths::GetBaseFilename(File));
+		if (IsCompanion(BasePath))
+		{
+			continue;
+		}
+
+		FSMAACorpusFrame& Frame = Frames.AddDefaulted_GetRef();
+		Frame.Name = FPaths::GetCleanFilename(File);
+		Frame.BasePath = BasePath;
+
+		if (!LoadSMAACPUImage(File, Frame.Inputs.Colour))
+		{
+			UE_LOG(LogSMAACommandlet, Warning, TEXT("Could not load %s"), *File);
+			Frames.Pop();
+			continue;
+		}
+
+		LoadCompanion(BasePath, TEXT("_depth"), Frame.Inputs.Colour, Frame.Inputs.Depth);
+		LoadCompanion(BasePath, TEXT("_normal"), Frame.Inputs.Colour, Frame.Inputs.Normal);
+		LoadCompanion(BasePath, TEXT("_velocity"), Frame.Inputs.Colour, Frame.Inputs.Velocity);
+	}
+
+	LoadFrameStates(IFileManager::Get().DirectoryExists(*InputPath) ? InputPath : FPaths::GetPath(InputPath), Frames);
+	return Frames;
+}
+
+bool LoadSMAACaptureSettings(const FString& BundlePath, FSMAACPUSettings& OutSettings, bool& bOutTemporal)
+{
+	const FString Filename = FPaths::Combine(IFileManager::Get().DirectoryExists(*BundlePath) ? BundlePath : FPaths::GetPath(BundlePath), TEXT("SMAACapture.json"));
+
+	const TSharedPtr<FJsonObject> Root = SMAACommandletUtils::LoadCaptureMetadata(Filename);
+	if (!Root.IsValid())
+	{
+		UE_LOG(LogSMAACommandlet, Warning, TEXT("Could not read %s"), *Filename);
+		return false;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* Views = nullptr;
+	if (!Root->TryGetArrayField(TEXT("Views"), Views) || Views->IsEmpty())
+	{
+		UE_LOG(LogSMAACommandlet, Warning, TEXT("%s has no views"), *Filename);
+		return false;
+	}
+
+	const TSharedPtr<FJsonObject>* Settings = nullptr;
+	if (!(*Views)[0]->AsObject()->TryGetObjectField(TEXT("Settings"), Settings))
+	{
+		UE_LOG(LogSMAACommandlet, Warning, TEXT("%s has no settings"), *Filename);
+		return false;
+	}
+
+	const TArray<uint8> Preset = ParseSMAANameList((*Settings)->GetStringField(TEXT("Preset")), SMAAPresetNames);
+	const TArray<uint8> EdgeMode = ParseSMAANameList((*Settings)->GetStringField(TEXT("EdgeDetector")), SMAAEdgeDetectorNames);
+	if (Preset.IsEmpty() || EdgeMode.IsEmpty())
+	{
+		return false;
+	}
+
+	OutSettings.Quality = ESMAAPreset(Preset[0]);
+	OutSettings.EdgeMode = ESMAAEdgeDetectors(EdgeMode[0]);
+	OutSettings.MaxSearchSteps = uint8((*Settings)->GetIntegerField(TEXT("MaxSearchSteps")));
+	OutSettings.MaxDiagonalSearchSteps = uint8((*Settings)->GetIntegerField(TEXT("MaxDiagonalSearchSteps")));
+	OutSettings.CornerRounding = uint8((*Settings)->GetIntegerField(TEXT("CornerRounding")));
+	OutSettings.AdaptationFactor = float((*Settings)->GetNumberField(TEXT("AdaptationFactor")));
+	OutSettings.ReprojectionWeight = float((*Settings)->GetNumberField(TEXT("ReprojectionWeight")));
+	OutSettings.TemporalHistoryBias = float((*Settings)->GetNumberField(TEXT("TemporalHistoryBias")));
+	bOutTemporal = (*Settings)->GetBoolField(TEXT("Temporal"));
+	return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "SMAACPU.h"
+
+// Shared by the SMAA commandlets and automation tests
+
+extern const TCHAR* SMAAPresetNames[5];
+extern const TCHAR* SMAAEdgeDetectorNames[4];
+
+// Parses a comma separated list of names from SMAAPresetNames or SMAAEdgeDetectorNames, ignoring case
+TArray<uint8> ParseSMAANameList(const FString& List, TConstArrayView<const TCHAR*> Names);
+
+TArray<int32> ParseSMAAIntList(const FString& List);
+
+// Loads an EXR or PNG into a linear float image
+bool LoadSMAACPUImage(const FString& Filename, FSMAACPUImage& OutImage);
+
+// Saves a float image. The format follows the extension, use .exr to keep full precision
+bool SaveSMAACPUImage(const FString& Filename, const FSMAACPUImage& Image);
+
+// Looks for <BasePath><Suffix> with any supported extension
+bool FindSMAACompanion(const FString& BasePath, const TCHAR* Suffix, FString& OutFilename);
+
+struct FSMAACorpusFrame
+{
+	FString Name;
+
+	// Path without the extension, to find other companions with
+	FString BasePath;
+
+	FSMAACPUFrame Inputs;
+
+	// The view the frame belongs to, and its T2x state. Read from SMAACapture.json for frames of an r.SMAA.CaptureInputs
+	// bundle, see bCaptured. Other frames are taken to be one view's consecutive frames, with valid history after the first
+	bool bCaptured = false;
+	int32 View = 0;
+	int32 JitterIndex = 0;
+	bool bHistoryValid = false;
+	bool bCameraCut = false;
+
+	// The subsample indices T2x ran this frame with, as the GPU picks them from SubpixelJitterWeights
+	FVector4f GetSubsampleIndices() const { return JitterIndex & 1 ? FVector4f(2, 2, 2, 0) : FVector4f(1, 1, 1, 0); }
+
+	// Whether T2x resolves this frame against the previous one of its view, under the same conditions as the GPU
+	bool CanResolve() const { return bHistoryValid && !bCameraCut; }
+};
+
+// Loads every EXR and PNG in a directory, or a single file, grouped by view and in name order within each. Depth, normal
+// and velocity are read from <Frame>_depth, <Frame>_normal and <Frame>_velocity next to each frame. References and
+// captured GBuffers are skipped
+TArray<FSMAACorpusFrame> LoadSMAACorpus(const FString& InputPath);
+
+// The settings of the first view in a bundle written by r.SMAA.CaptureInputs, from its SMAACapture.json
+bool LoadSMAACaptureSettings(const FString& BundlePath, FSMAACPUSettings& OutSettings, bool& bOutTemporal);
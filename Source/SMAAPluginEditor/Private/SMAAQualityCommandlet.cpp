@@ -0,0 +1,930 @@
+#include "SMAAQualityCommandlet.h"
+
+#include "SMAACPU.h"
+#include "SMAACommandletUtils.h"
+#include "SMAADeveloperSettings.h"
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSMAAQuality, Log, All);
+
+namespace SMAAQuality
+{
+	const TCHAR* ModeNames[2] = { TEXT("1x"), TEXT("T2x") };
+
+	// Identical images would be infinitely far above the noise floor
+	constexpr double MaxPSNR = 100.0;
+
+	// One channel float image
+	struct FChannel
+	{
+		int32 Width = 0;
+		int32 Height = 0;
+		TArray<float> Values;
+
+		void Init(int32 InWidth, int32 InHeight)
+		{
+			Width = InWidth;
+			Height = InHeight;
+			Values.SetNumZeroed(Width * Height);
+		}
+
+		float At(int32 X, int32 Y) const
+		{
+			return Values[FMath::Clamp(Y, 0, Height - 1) * Width + FMath::Clamp(X, 0, Width - 1)];
+		}
+	};
+
+	// Clamped to [0, 1] and sRGB encoded, as it would be shown
+	struct FDisplayImage
+	{
+		int32 Width = 0;
+		int32 Height = 0;
+		TArray<FVector3f> Pixels;
+	};
+
+	struct FFrame
+	{
+		FString Name;
+		FSMAACPUFrame Inputs;
+		FDisplayImage Reference;
+		FChannel ReferenceLuma;
+
+		// For -Sequence, see FSMAACorpusFrame
+		int32 View = 0;
+		FVector4f SubsampleIndices;
+		bool bCanResolve = false;
+	};
+
+	struct FConfig
+	{
+		// False for the unprocessed baseline
+		bool bProcess = true;
+		bool bTemporal = false;
+		ESMAAPreset Preset = ESMAAPreset::Ultra;
+		ESMAAEdgeDetectors EdgeMode = ESMAAEdgeDetectors::Luminance;
+		int32 MaxSearchSteps = 0;
+		int32 MaxDiagonalSearchSteps = 0;
+		int32 CornerRounding = 0;
+
+		const TCHAR* GetModeName() const { return bProcess ? ModeNames[bTemporal ? 1 : 0] : TEXT("None"); }
+		const TCHAR* GetPresetName() const { return bProcess ? SMAAPresetNames[uint8(Preset)] : TEXT(""); }
+		const TCHAR* GetEdgeDetectorName() const { return bProcess ? SMAAEdgeDetectorNames[uint8(EdgeMode)] : TEXT(""); }
+	};
+
+	struct FMetrics
+	{
+		double PSNR = 0.0;
+		double SSIM = 0.0;
+		double FLIP = 0.0;
+
+		// Negative when there is no previous frame to compare with
+		double Flicker = -1.0;
+
+		FSMAACPUStageTimings Timings;
+	};
+
+	struct FResult
+	{
+		FString Frame;
+		FConfig Config;
+		FMetrics Metrics;
+	};
+
+	// Averages over every frame a configuration ran on
+	struct FSummary
+	{
+		FConfig Config;
+		int32 NumFrames = 0;
+		int32 NumFlickerFrames = 0;
+		FMetrics Metrics;
+	};
+
+	float LinearToSRGB(float Value)
+	{
+		Value = FMath::Clamp(Value, 0.0f, 1.0f);
+		return Value <= 0.0031308f ? Value * 12.92f : 1.055f * FMath::Pow(Value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	float SRGBToLinear(float Value)
+	{
+		return Value <= 0.04045f ? Value / 12.92f : FMath::Pow((Value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	FDisplayImage ToDisplay(const FSMAACPUImage& Image)
+	{
+		FDisplayImage Display;
+		Display.Width = Image.Width;
+		Display.Height = Image.Height;
+		Display.Pixels.SetNumUninitialized(Image.Pixels.Num());
+		for (int32 Index = 0; Index < Image.Pixels.Num(); ++Index)
+		{
+			const FVector4f& Pixel = Image.Pixels[Index];
+			Display.Pixels[Index] = FVector3f(LinearToSRGB(Pixel.X), LinearToSRGB(Pixel.Y), LinearToSRGB(Pixel.Z));
+		}
+		return Display;
+	}
+
+	FChannel ToLuma(const FDisplayImage& Image)
+	{
+		FChannel Luma;
+		Luma.Init(Image.Width, Image.Height);
+		for (int32 Index = 0; Index < Image.Pixels.Num(); ++Index)
+		{
+			const FVector3f& Pixel = Image.Pixels[Index];
+			Luma.Values[Index] = 0.2126f * Pixel.X + 0.7152f * Pixel.Y + 0.0722f * Pixel.Z;
+		}
+		return Luma;
+	}
+
+	// Separable convolution with clamped addressing. Both kernels have an odd number of taps, centred
+	FChannel Convolve(const FChannel& Input, TConstArrayView<float> KernelX, TConstArrayView<float> KernelY)
+	{
+		const int32 RadiusX = KernelX.Num() / 2;
+		const int32 RadiusY = KernelY.Num() / 2;
+
+		FChannel Rows;
+		Rows.Init(Input.Width, Input.Height);
+		ParallelFor(Input.Height, [&](int32 Y)
+		{
+			for (int32 X = 0; X < Input.Width; ++X)
+			{
+				float Sum = 0.0f;
+				for (int32 Tap = -RadiusX; Tap <= RadiusX; ++Tap)
+				{
+					Sum += KernelX[Tap + RadiusX] * Input.At(X + Tap, Y);
+				}
+				Rows.Values[Y * Input.Width + X] = Sum;
+			}
+		});
+
+		FChannel Output;
+		Output.Init(Input.Width, Input.Height);
+		ParallelFor(Input.Height, [&](int32 Y)
+		{
+			for (int32 X = 0; X < Input.Width; ++X)
+			{
+				float Sum = 0.0f;
+				for (int32 Tap = -RadiusY; Tap <= RadiusY; ++Tap)
+				{
+					Sum += KernelY[Tap + RadiusY] * Rows.At(X, Y + Tap);
+				}
+				Output.Values[Y * Input.Width + X] = Sum;
+			}
+		});
+		return Output;
+	}
+
+	TArray<float> GaussianKernel(float Sigma, int32 Radius)
+	{
+		TArray<float> Kernel;
+		float Sum = 0.0f;
+		for (int32 Tap = -Radius; Tap <= Radius; ++Tap)
+		{
+			Sum += Kernel.Add_GetRef(FMath::Exp(-float(Tap * Tap) / (2.0f * Sigma * Sigma)));
+		}
+
+		for (float& Weight : Kernel)
+		{
+			Weight /= Sum;
+		}
+		return Kernel;
+	}
+
+	double ComputePSNR(const FDisplayImage& Reference, const FDisplayImage& Test)
+	{
+		double SquaredError = 0.0;
+		for (int32 Index = 0; Index < Reference.Pixels.Num(); ++Index)
+		{
+			const FVector3f Difference = Reference.Pixels[Index] - Test.Pixels[Index];
+			SquaredError += Difference.SquaredLength();
+		}
+
+		const double MSE = SquaredError / (3.0 * Reference.Pixels.Num());
+		return MSE > 0.0 ? FMath::Min(10.0 * FMath::LogX(10.0, 1.0 / MSE), MaxPSNR) : MaxPSNR;
+	}
+
+	// Mean SSIM of the luma, with the usual 11x11 Gaussian window of sigma 1.5
+	double ComputeSSIM(const FChannel& Reference, const FChannel& Test)
+	{
+		constexpr float C1 = 0.01f * 0.01f;
+		constexpr float C2 = 0.03f * 0.03f;
+
+		const TArray<float> Window = GaussianKernel(1.5f, 5);
+
+		FChannel ReferenceSquared = Reference;
+		FChannel TestSquared = Test;
+		FChannel Product = Reference;
+		for (int32 Index = 0; Index < Reference.Values.Num(); ++Index)
+		{
+			ReferenceSquared.Values[Index] *= Reference.Values[Index];
+			TestSquared.Values[Index] *= Test.Values[Index];
+			Product.Values[Index] *= Test.Values[Index];
+		}
+
+		const FChannel MeanReference = Convolve(Reference, Window, Window);
+		const FChannel MeanTest = Convolve(Test, Window, Window);
+		const FChannel MeanReferenceSquared = Convolve(ReferenceSquared, Window, Window);
+		const FChannel MeanTestSquared = Convolve(TestSquared, Window, Window);
+		const FChannel MeanProduct = Convolve(Product, Window, Window);
+
+		double Sum = 0.0;
+		for (int32 Index = 0; Index < Reference.Values.Num(); ++Index)
+		{
+			const float MuX = MeanReference.Values[Index];
+			const float MuY = MeanTest.Values[Index];
+			const float VarianceX = MeanReferenceSquared.Values[Index] - MuX * MuX;
+			const float VarianceY = MeanTestSquared.Values[Index] - MuY * MuY;
+			const float Covariance = MeanProduct.Values[Index] - MuX * MuY;
+
+			Sum += ((2.0f * MuX * MuY + C1) * (2.0f * Covariance + C2)) / ((MuX * MuX + MuY * MuY + C1) * (VarianceX + VarianceY + C2));
+		}
+		return Sum / Reference.Values.Num();
+	}
+
+	// FLIP works in CIE spaces relative to the D65 white
+	const FVector3f WhiteXYZ(0.950428545f, 1.0f, 1.088900371f);
+
+	FVector3f LinearRGBToXYZ(const FVector3f& Colour)
+	{
+		return FVector3f(
+			0.4124564f * Colour.X + 0.3575761f * Colour.Y + 0.1804375f * Colour.Z,
+			0.2126729f * Colour.X + 0.7151522f * Colour.Y + 0.0721750f * Colour.Z,
+			0.0193339f * Colour.X + 0.1191920f * Colour.Y + 0.9503041f * Colour.Z);
+	}
+
+	FVector3f XYZToLinearRGB(const FVector3f& XYZ)
+	{
+		return FVector3f(
+			3.2404542f * XYZ.X - 1.5371385f * XYZ.Y - 0.4985314f * XYZ.Z,
+			-0.9692660f * XYZ.X + 1.8760108f * XYZ.Y + 0.0415560f * XYZ.Z,
+			0.0556434f * XYZ.X - 0.2040259f * XYZ.Y + 1.0572252f * XYZ.Z);
+	}
+
+	FVector3f XYZToYCxCz(const FVector3f& XYZ)
+	{
+		const FVector3f Normalised = XYZ / WhiteXYZ;
+		return FVector3f(116.0f * Normalised.Y - 16.0f, 500.0f * (Normalised.X - Normalised.Y), 200.0f * (Normalised.Y - Normalised.Z));
+	}
+
+	FVector3f YCxCzToXYZ(const FVector3f& YCxCz)
+	{
+		const float Y = (YCxCz.X + 16.0f) / 116.0f;
+		return FVector3f(YCxCz.Y / 500.0f + Y, Y, Y - YCxCz.Z / 200.0f) * WhiteXYZ;
+	}
+
+	float LabCurve(float Value)
+	{
+		constexpr float Delta = 6.0f / 29.0f;
+		return Value > Delta * Delta * Delta ? FMath::Pow(Value, 1.0f / 3.0f) : Value / (3.0f * Delta * Delta) + 4.0f / 29.0f;
+	}
+
+	// CIELAB with FLIP's Hunt adjustment, which scales chroma down with lightness
+	FVector3f XYZToHuntLab(const FVector3f& XYZ)
+	{
+		const FVector3f Normalised = XYZ / WhiteXYZ;
+		const float L = 116.0f * LabCurve(Normalised.Y) - 16.0f;
+		const float A = 500.0f * (LabCurve(Normalised.X) - LabCurve(Normalised.Y));
+		const float B = 200.0f * (LabCurve(Normalised.Y) - LabCurve(Normalised.Z));
+		return FVector3f(L, 0.01f * L * A, 0.01f * L * B);
+	}
+
+	float HyAB(const FVector3f& A, const FVector3f& B)
+	{
+		return FMath::Abs(A.X - B.X) + FMath::Sqrt(FMath::Square(A.Y - B.Y) + FMath::Square(A.Z - B.Z));
+	}
+
+	// Sum of one or two Gaussians of the contrast sensitivity function, see the FLIP paper for the constants
+	struct FCSFTerm
+	{
+		float A;
+		float B;
+	};
+
+	FChannel FilterCSF(const FChannel& Input, FCSFTerm First, FCSFTerm Second, float PixelsPerDegree)
+	{
+		const float MaxB = FMath::Max(First.B, Second.B);
+		const int32 Radius = FMath::CeilToInt(3.0f * FMath::Sqrt(MaxB / (2.0f * UE_PI * UE_PI)) * PixelsPerDegree);
+
+		FChannel Output;
+		Output.Init(Input.Width, Input.Height);
+		for (const FCSFTerm& Term : { First, Second })
+		{
+			if (Term.A <= 0.0f)
+			{
+				continue;
+			}
+
+			// Each term integrates to A over the plane, so its share of the normalised kernel is A over the total
+			const float Sigma = FMath::Max(FMath::Sqrt(Term.B / (2.0f * UE_PI * UE_PI)) * PixelsPerDegree, UE_KINDA_SMALL_NUMBER);
+			const TArray<float> Kernel = GaussianKernel(Sigma, Radius);
+			const FChannel Filtered = Convolve(Input, Kernel, Kernel);
+
+			const float Weight = Term.A / (First.A + Second.A);
+			for (int32 Index = 0; Index < Output.Values.Num(); ++Index)
+			{
+				Output.Values[Index] += Weight * Filtered.Values[Index];
+			}
+		}
+		return Output;
+	}
+
+	struct FFLIPInputs
+	{
+		// Spatially filtered, in Hunt adjusted CIELAB
+		TArray<FVector3f> HuntLab;
+
+		// Gradient and point (second derivative) response magnitudes of the luminance
+		FChannel Edges;
+		FChannel Points;
+	};
+
+	FFLIPInputs PrepareFLIP(const FDisplayImage& Image, float PixelsPerDegree)
+	{
+		FChannel YCxCz[3];
+		for (FChannel& Channel : YCxCz)
+		{
+			Channel.Init(Image.Width, Image.Height);
+		}
+
+		for (int32 Index = 0; Index < Image.Pixels.Num(); ++Index)
+		{
+			const FVector3f& Pixel = Image.Pixels[Index];
+			const FVector3f Opponent = XYZToYCxCz(LinearRGBToXYZ(FVector3f(SRGBToLinear(Pixel.X), SRGBToLinear(Pixel.Y), SRGBToLinear(Pixel.Z))));
+			YCxCz[0].Values[Index] = Opponent.X;
+			YCxCz[1].Values[Index] = Opponent.Y;
+			YCxCz[2].Values[Index] = Opponent.Z;
+		}
+
+		FFLIPInputs Inputs;
+
+		// Colour: what survives the eye's contrast sensitivity at this distance
+		const FChannel Achromatic = FilterCSF(YCxCz[0], { 1.0f, 0.0047f }, { 0.0f, 1e-5f }, PixelsPerDegree);
+		const FChannel RedGreen = FilterCSF(YCxCz[1], { 1.0f, 0.0053f }, { 0.0f, 1e-5f }, PixelsPerDegree);
+		const FChannel BlueYellow = FilterCSF(YCxCz[2], { 34.1f, 0.04f }, { 13.5f, 0.025f }, PixelsPerDegree);
+
+		Inputs.HuntLab.SetNumUninitialized(Image.Pixels.Num());
+		for (int32 Index = 0; Index < Image.Pixels.Num(); ++Index)
+		{
+			FVector3f Linear = XYZToLinearRGB(YCxCzToXYZ(FVector3f(Achromatic.Values[Index], RedGreen.Values[Index], BlueYellow.Values[Index])));
+			Linear = FVector3f(FMath::Clamp(Linear.X, 0.0f, 1.0f), FMath::Clamp(Linear.Y, 0.0f, 1.0f), FMath::Clamp(Linear.Z, 0.0f, 1.0f));
+			Inputs.HuntLab[Index] = XYZToHuntLab(LinearRGBToXYZ(Linear));
+		}
+
+		// Features: edges and points in the normalised luminance, at the scale of a 0.082 degree feature
+		FChannel Luminance;
+		Luminance.Init(Image.Width, Image.Height);
+		for (int32 Index = 0; Index < Image.Pixels.Num(); ++Index)
+		{
+			Luminance.Values[Index] = (YCxCz[0].Values[Index] + 16.0f) / 116.0f;
+		}
+
+		const float Sigma = 0.5f * 0.082f * PixelsPerDegree;
+		const int32 Radius = FMath::CeilToInt(3.0f * Sigma);
+		const TArray<float> Smooth = GaussianKernel(Sigma, Radius);
+
+		// Derivatives of the Gaussian, normalised so the positive and negative weights each sum to one
+		TArray<float> FirstDerivative;
+		TArray<float> SecondDerivative;
+		float FirstPositive = 0.0f;
+		float SecondPositive = 0.0f;
+		float SecondNegative = 0.0f;
+		for (int32 Tap = -Radius; Tap <= Radius; ++Tap)
+		{
+			const float Gaussian = FMath::Exp(-float(Tap * Tap) / (2.0f * Sigma * Sigma));
+			const float First = FirstDerivative.Add_GetRef(-float(Tap) * Gaussian);
+			const float Second = SecondDerivative.Add_GetRef((float(Tap * Tap) / (Sigma * Sigma) - 1.0f) * Gaussian);
+
+			FirstPositive += FMath::Max(First, 0.0f);
+			SecondPositive += FMath::Max(Second, 0.0f);
+			SecondNegative -= FMath::Min(Second, 0.0f);
+		}
+
+		for (int32 Tap = 0; Tap < FirstDerivative.Num(); ++Tap)
+		{
+			FirstDerivative[Tap] /= FirstPositive;
+			SecondDerivative[Tap] /= SecondDerivative[Tap] > 0.0f ? SecondPositive : SecondNegative;
+		}
+
+		const FChannel EdgeX = Convolve(Luminance, FirstDerivative, Smooth);
+		const FChannel EdgeY = Convolve(Luminance, Smooth, FirstDerivative);
+		const FChannel PointX = Convolve(Luminance, SecondDerivative, Smooth);
+		const FChannel PointY = Convolve(Luminance, Smooth, SecondDerivative);
+
+		Inputs.Edges.Init(Image.Width, Image.Height);
+		Inputs.Points.Init(Image.Width, Image.Height);
+		for (int32 Index = 0; Index < Image.Pixels.Num(); ++Index)
+		{
+			Inputs.Edges.Values[Index] = FMath::Sqrt(FMath::Square(EdgeX.Values[Index]) + FMath::Square(EdgeY.Values[Index]));
+			Inputs.Points.Values[Index] = FMath::Sqrt(FMath::Square(PointX.Values[Index]) + FMath::Square(PointY.Values[Index]));
+		}
+
+		return Inputs;
+	}
+
+	// Mean LDR-FLIP error, 0 for identical images and 1 for the largest perceived difference
+	double ComputeFLIP(const FFLIPInputs& Reference, const FFLIPInputs& Test)
+	{
+		constexpr float ColourExponent = 0.7f;
+		constexpr float FeatureExponent = 0.5f;
+		constexpr float ColourCutoff = 0.4f;
+		constexpr float ColourCompression = 0.95f;
+
+		// The largest colour difference in sRGB, between green and blue
+		const float MaxColourDifference = FMath::Pow(HyAB(XYZToHuntLab(LinearRGBToXYZ(FVector3f(0, 1, 0))), XYZToHuntLab(LinearRGBToXYZ(FVector3f(0, 0, 1)))), ColourExponent);
+
+		double Sum = 0.0;
+		for (int32 Index = 0; Index < Reference.HuntLab.Num(); ++Index)
+		{
+			// Small differences are spread over most of the range, large ones compressed into the rest
+			const float ColourDifference = FMath::Pow(HyAB(Reference.HuntLab[Index], Test.HuntLab[Index]), ColourExponent);
+			const float ColourError = ColourDifference < ColourCutoff * MaxColourDifference
+				? ColourCompression / (ColourCutoff * MaxColourDifference) * ColourDifference
+				: ColourCompression + (ColourDifference - ColourCutoff * MaxColourDifference) / (MaxColourDifference - ColourCutoff * MaxColourDifference) * (1.0f - ColourCompression);
+
+			const float FeatureDifference = FMath::Max(
+				FMath::Abs(Reference.Edges.Values[Index] - Test.Edges.Values[Index]),
+				FMath::Abs(Reference.Points.Values[Index] - Test.Points.Values[Index]));
+			const float FeatureError = FMath::Pow(FMath::Min(FeatureDifference / UE_SQRT_2, 1.0f), FeatureExponent);
+
+			Sum += FMath::Pow(FMath::Min(ColourError, 1.0f), 1.0f - FeatureError);
+		}
+		return Sum / Reference.HuntLab.Num();
+	}
+
+	// Mean absolute change between frames the reference doesn't have, in display luma. 0 is as stable as the reference
+	double ComputeFlicker(const FChannel& PreviousTest, const FChannel& Test, const FChannel& PreviousReference, const FChannel& Reference)
+	{
+		double Sum = 0.0;
+		for (int32 Index = 0; Index < Test.Values.Num(); ++Index)
+		{
+			const float TestChange = Test.Values[Index] - PreviousTest.Values[Index];
+			const float ReferenceChange = Reference.Values[Index] - PreviousReference.Values[Index];
+			Sum += FMath::Abs(TestChange - ReferenceChange);
+		}
+		return Sum / Test.Values.Num();
+	}
+
+	FSMAACPUImage BoxDownsample(const FSMAACPUImage& Image, int32 Factor)
+	{
+		FSMAACPUImage Output;
+		Output.Init(Image.Width / Factor, Image.Height / Factor);
+
+		const float Weight = 1.0f / float(Factor * Factor);
+		ParallelFor(Output.Height, [&](int32 Y)
+		{
+			for (int32 X = 0; X < Output.Width; ++X)
+			{
+				FVector4f Sum(0, 0, 0, 0);
+				for (int32 SubY = 0; SubY < Factor; ++SubY)
+				{
+					for (int32 SubX = 0; SubX < Factor; ++SubX)
+					{
+						Sum += Image.At(X * Factor + SubX, Y * Factor + SubY);
+					}
+				}
+				Output.At(X, Y) = Sum * Weight;
+			}
+		});
+		return Output;
+	}
+
+	// The sample nearest each output pixel's centre, as rasterising at the lower resolution would have taken
+	FSMAACPUImage PointDownsample(const FSMAACPUImage& Image, int32 Factor)
+	{
+		if (!Image.IsValid())
+		{
+			return FSMAACPUImage();
+		}
+
+		FSMAACPUImage Output;
+		Output.Init(Image.Width / Factor, Image.Height / Factor);
+		for (int32 Y = 0; Y < Output.Height; ++Y)
+		{
+			for (int32 X = 0; X < Output.Width; ++X)
+			{
+				Output.At(X, Y) = Image.At(X * Factor + Factor / 2, Y * Factor + Factor / 2);
+			}
+		}
+		return Output;
+	}
+
+	bool LoadReference(FSMAACorpusFrame& CorpusFrame, int32 Supersample, FFrame& OutFrame)
+	{
+		FSMAACPUImage Reference;
+
+		FString ReferencePath;
+		if (FindSMAACompanion(CorpusFrame.BasePath, TEXT("_reference"), ReferencePath))
+		{
+			if (!LoadSMAACPUImage(ReferencePath, Reference))
+			{
+				UE_LOG(LogSMAAQuality, Warning, TEXT("Could not load %s"), *ReferencePath);
+				return false;
+			}
+
+			const FSMAACPUImage& Colour = CorpusFrame.Inputs.Colour;
+			const int32 Factor = Reference.Width / Colour.Width;
+			if (Factor < 1 || Reference.Width != Colour.Width * Factor || Reference.Height != Colour.Height * Factor)
+			{
+				UE_LOG(LogSMAAQuality, Warning, TEXT("%s is not an integer multiple of the frame size, skipping the frame"), *ReferencePath);
+				return false;
+			}
+
+			if (Factor > 1)
+			{
+				Reference = BoxDownsample(Reference, Factor);
+			}
+			OutFrame.Inputs = MoveTemp(CorpusFrame.Inputs);
+		}
+		else if (Supersample > 1)
+		{
+			Reference = BoxDownsample(CorpusFrame.Inputs.Colour, Supersample);
+			OutFrame.Inputs.Colour = PointDownsample(CorpusFrame.Inputs.Colour, Supersample);
+			OutFrame.Inputs.Depth = PointDownsample(CorpusFrame.Inputs.Depth, Supersample);
+			OutFrame.Inputs.Normal = PointDownsample(CorpusFrame.Inputs.Normal, Supersample);
+
+			// Screen space, so it doesn't scale with the resolution
+			OutFrame.Inputs.Velocity = PointDownsample(CorpusFrame.Inputs.Velocity, Supersample);
+		}
+		else
+		{
+			UE_LOG(LogSMAAQuality, Warning, TEXT("%s has no reference and -Supersample is not set, skipping it"), *CorpusFrame.Name);
+			return false;
+		}
+
+		OutFrame.Name = CorpusFrame.Name;
+		OutFrame.View = CorpusFrame.View;
+		OutFrame.SubsampleIndices = CorpusFrame.GetSubsampleIndices();
+		OutFrame.bCanResolve = CorpusFrame.CanResolve();
+		OutFrame.Reference = ToDisplay(Reference);
+		OutFrame.ReferenceLuma = ToLuma(OutFrame.Reference);
+		return true;
+	}
+
+	void Accumulate(FSummary& Summary, const FMetrics& Metrics)
+	{
+		Summary.NumFrames++;
+		Summary.Metrics.PSNR += Metrics.PSNR;
+		Summary.Metrics.SSIM += Metrics.SSIM;
+		Summary.Metrics.FLIP += Metrics.FLIP;
+		Summary.Metrics.Timings.EdgeDetection += Metrics.Timings.EdgeDetection;
+		Summary.Metrics.Timings.BlendingWeights += Metrics.Timings.BlendingWeights;
+		Summary.Metrics.Timings.NeighbourhoodBlending += Metrics.Timings.NeighbourhoodBlending;
+		Summary.Metrics.Timings.TemporalResolve += Metrics.Timings.TemporalResolve;
+
+		if (Metrics.Flicker >= 0.0)
+		{
+			Summary.NumFlickerFrames++;
+			Summary.Metrics.Flicker = FMath::Max(Summary.Metrics.Flicker, 0.0) + Metrics.Flicker;
+		}
+	}
+
+	void Finish(FSummary& Summary)
+	{
+		if (Summary.NumFrames == 0)
+		{
+			return;
+		}
+
+		const double Scale = 1.0 / Summary.NumFrames;
+		Summary.Metrics.PSNR *= Scale;
+		Summary.Metrics.SSIM *= Scale;
+		Summary.Metrics.FLIP *= Scale;
+		Summary.Metrics.Timings.EdgeDetection *= Scale;
+		Summary.Metrics.Timings.BlendingWeights *= Scale;
+		Summary.Metrics.Timings.NeighbourhoodBlending *= Scale;
+		Summary.Metrics.Timings.TemporalResolve *= Scale;
+
+		if (Summary.NumFlickerFrames > 0)
+		{
+			Summary.Metrics.Flicker /= Summary.NumFlickerFrames;
+		}
+	}
+
+	FString ToCSVRow(const FConfig& Config, const FMetrics& Metrics)
+	{
+		return FString::Printf(TEXT("%s,%s,%s,%d,%d,%d,%.4f,%.6f,%.6f,%s,%.3f,%.3f,%.3f,%.3f,%.3f"),
+			Config.GetModeName(), Config.GetPresetName(), Config.GetEdgeDetectorName(), Config.MaxSearchSteps, Config.MaxDiagonalSearchSteps, Config.CornerRounding,
+			Metrics.PSNR, Metrics.SSIM, Metrics.FLIP,
+			Metrics.Flicker >= 0.0 ? *FString::Printf(TEXT("%.6f"), Metrics.Flicker) : TEXT(""),
+			Metrics.Timings.EdgeDetection * 1000.0, Metrics.Timings.BlendingWeights * 1000.0,
+			Metrics.Timings.NeighbourhoodBlending * 1000.0, Metrics.Timings.TemporalResolve * 1000.0,
+			Metrics.Timings.GetTotal() * 1000.0);
+	}
+
+	const TCHAR* CSVColumns = TEXT("Mode,Preset,EdgeDetector,MaxSearchSteps,MaxDiagonalSearchSteps,CornerRounding,PSNR,SSIM,FLIP,Flicker,EdgeDetectionMs,BlendingWeightsMs,NeighbourhoodBlendingMs,TemporalResolveMs,TotalMs");
+
+	FString ToCSV(const TArray<FResult>& Results)
+	{
+		FString CSV = FString::Printf(TEXT("Frame,%s\n"), CSVColumns);
+		for (const FResult& Result : Results)
+		{
+			CSV += Result.Frame + TEXT(",") + ToCSVRow(Result.Config, Result.Metrics) + TEXT("\n");
+		}
+		return CSV;
+	}
+
+	FString ToCSV(const TArray<FSummary>& Summaries)
+	{
+		FString CSV = FString::Printf(TEXT("Frames,%s\n"), CSVColumns);
+		for (const FSummary& Summary : Summaries)
+		{
+			CSV += FString::Printf(TEXT("%d,"), Summary.NumFrames) + ToCSVRow(Summary.Config, Summary.Metrics) + TEXT("\n");
+		}
+		return CSV;
+	}
+
+	TSharedRef<FJsonObject> ToJSON(const FConfig& Config, const FMetrics& Metrics)
+	{
+		TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+		Entry->SetStringField(TEXT("Mode"), Config.GetModeName());
+		if (Config.bProcess)
+		{
+			Entry->SetStringField(TEXT("Preset"), Config.GetPresetName());
+			Entry->SetStringField(TEXT("EdgeDetector"), Config.GetEdgeDetectorName());
+			Entry->SetNumberField(TEXT("MaxSearchSteps"), Config.MaxSearchSteps);
+			Entry->SetNumberField(TEXT("MaxDiagonalSearchSteps"), Config.MaxDiagonalSearchSteps);
+			Entry->SetNumberField(TEXT("CornerRounding"), Config.CornerRounding);
+		}
+
+		Entry->SetNumberField(TEXT("PSNR"), Metrics.PSNR);
+		Entry->SetNumberField(TEXT("SSIM"), Metrics.SSIM);
+		Entry->SetNumberField(TEXT("FLIP"), Metrics.FLIP);
+		if (Metrics.Flicker >= 0.0)
+		{
+			Entry->SetNumberField(TEXT("Flicker"), Metrics.Flicker);
+		}
+
+		TSharedRef<FJsonObject> Stages = MakeShared<FJsonObject>();
+		Stages->SetNumberField(TEXT("EdgeDetection"), Metrics.Timings.EdgeDetection * 1000.0);
+		Stages->SetNumberField(TEXT("BlendingWeights"), Metrics.Timings.BlendingWeights * 1000.0);
+		Stages->SetNumberField(TEXT("NeighbourhoodBlending"), Metrics.Timings.NeighbourhoodBlending * 1000.0);
+		Stages->SetNumberField(TEXT("TemporalResolve"), Metrics.Timings.TemporalResolve * 1000.0);
+		Entry->SetObjectField(TEXT("StageMs"), Stages);
+		Entry->SetNumberField(TEXT("TotalMs"), Metrics.Timings.GetTotal() * 1000.0);
+		return Entry;
+	}
+
+	FString ToJSON(const TArray<FResult>& Results, const TArray<FSummary>& Summaries, bool bSequence, int32 Supersample, float PixelsPerDegree)
+	{
+		TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+		Root->SetStringField(TEXT("CPU"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+		Root->SetBoolField(TEXT("Sequence"), bSequence);
+		Root->SetNumberField(TEXT("Supersample"), Supersample);
+		Root->SetNumberField(TEXT("PixelsPerDegree"), PixelsPerDegree);
+
+		TArray<TSharedPtr<FJsonValue>> SummaryEntries;
+		for (const FSummary& Summary : Summaries)
+		{
+			TSharedRef<FJsonObject> Entry = ToJSON(Summary.Config, Summary.Metrics);
+			Entry->SetNumberField(TEXT("Frames"), Summary.NumFrames);
+			SummaryEntries.Add(MakeShared<FJsonValueObject>(Entry));
+		}
+		Root->SetArrayField(TEXT("Summary"), SummaryEntries);
+
+		TArray<TSharedPtr<FJsonValue>> ResultEntries;
+		for (const FResult& Result : Results)
+		{
+			TSharedRef<FJsonObject> Entry = ToJSON(Result.Config, Result.Metrics);
+			Entry->SetStringField(TEXT("Frame"), Result.Frame);
+			ResultEntries.Add(MakeShared<FJsonValueObject>(Entry));
+		}
+		Root->SetArrayField(TEXT("Results"), ResultEntries);
+
+		FString JSON;
+		TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JSON);
+		FJsonSerializer::Serialize(Root, Writer);
+		return JSON;
+	}
+}
+
+USMAAQualityCommandlet::USMAAQualityCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 USMAAQualityCommandlet::Main(const FString& Params)
+{
+	using namespace SMAAQuality;
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	const FString InputPath = ParamValues.FindRef(TEXT("Input"));
+	if (InputPath.IsEmpty())
+	{
+		UE_LOG(LogSMAAQuality, Error, TEXT("Missing -Input=<Directory or file>"));
+		return 1;
+	}
+
+	const FString OutputDir = ParamValues.Contains(TEXT("Output")) ? ParamValues[TEXT("Output")] : FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SMAA"), TEXT("Quality"));
+	TArray<uint8> Modes = ParseSMAANameList(ParamValues.Contains(TEXT("Modes")) ? ParamValues[TEXT("Modes")] : TEXT("1x,T2x"), ModeNames);
+	TArray<uint8> Presets = ParseSMAANameList(ParamValues.Contains(TEXT("Presets")) ? ParamValues[TEXT("Presets")] : TEXT("Low,Medium,High,Ultra"), SMAAPresetNames);
+	TArray<uint8> EdgeModes = ParseSMAANameList(ParamValues.Contains(TEXT("EdgeDetectors")) ? ParamValues[TEXT("EdgeDetectors")] : TEXT("Luminance"), SMAAEdgeDetectorNames);
+	TArray<int32> SearchSteps = ParseSMAAIntList(ParamValues.Contains(TEXT("SearchSteps")) ? ParamValues[TEXT("SearchSteps")] : TEXT("8,16,32"));
+	const int32 Supersample = ParamValues.Contains(TEXT("Supersample")) ? FCString::Atoi(*ParamValues[TEXT("Supersample")]) : 0;
+	const float PixelsPerDegree = ParamValues.Contains(TEXT("PixelsPerDegree")) ? FMath::Max(FCString::Atof(*ParamValues[TEXT("PixelsPerDegree")]), 1.0f) : 67.0f;
+	const bool bSequence = Switches.Contains(TEXT("Sequence"));
+
+	// Measures a bundle from r.SMAA.CaptureInputs with the settings it was captured with, rather than sweeping them
+	FSMAACPUSettings BaseSettings;
+	if (Switches.Contains(TEXT("CaptureSettings")))
+	{
+		bool bCapturedTemporal = false;
+		if (!LoadSMAACaptureSettings(InputPath, BaseSettings, bCapturedTemporal))
+		{
+			UE_LOG(LogSMAAQuality, Error, TEXT("-CaptureSettings needs an SMAACapture.json next to the input"));
+			return 1;
+		}
+
+		Modes = { uint8(bCapturedTemporal ? 1 : 0) };
+		Presets = { uint8(BaseSettings.Quality) };
+		EdgeModes = { uint8(BaseSettings.EdgeMode) };
+		SearchSteps = { BaseSettings.MaxSearchSteps };
+	}
+
+	// The area texture is read from its source data, which is why this is an editor commandlet
+	USMAADeveloperSettings::Get()->LoadTextures();
+
+	FSMAALookupTables Tables;
+	if (!Tables.InitFromTexture(USMAADeveloperSettings::Get()->SMAAAreaTexture))
+	{
+		UE_LOG(LogSMAAQuality, Error, TEXT("Could not read the SMAA area texture"));
+		return 1;
+	}
+
+	TArray<FFrame> Frames;
+	{
+		TArray<FSMAACorpusFrame> Corpus = LoadSMAACorpus(InputPath);
+		for (FSMAACorpusFrame& CorpusFrame : Corpus)
+		{
+			FFrame Frame;
+			if (LoadReference(CorpusFrame, Supersample, Frame))
+			{
+				Frames.Add(MoveTemp(Frame));
+			}
+		}
+	}
+
+	if (Frames.IsEmpty())
+	{
+		UE_LOG(LogSMAAQuality, Error, TEXT("No frames with a reference found in %s"), *InputPath);
+		return 1;
+	}
+
+	// The unprocessed input first, as the baseline every configuration should improve on
+	TArray<FConfig> Configs;
+	Configs.Add_GetRef(FConfig()).bProcess = false;
+	for (uint8 Mode : Modes)
+	{
+		for (uint8 EdgeModeIndex : EdgeModes)
+		{
+			for (uint8 PresetIndex : Presets)
+			{
+				// Presets run with the search parameters their permutations bake in, so only Custom sweeps the steps
+				uint8 MaxSearchSteps = BaseSettings.MaxSearchSteps;
+				uint8 MaxDiagonalSearchSteps = BaseSettings.MaxDiagonalSearchSteps;
+				uint8 CornerRounding = BaseSettings.CornerRounding;
+				TArray<int32> PresetSearchSteps = SearchSteps;
+				if (GetSMAAPresetSearchSettings(ESMAAPreset(PresetIndex), MaxSearchSteps, MaxDiagonalSearchSteps, CornerRounding))
+				{
+					PresetSearchSteps = { MaxSearchSteps };
+				}
+
+				for (int32 Steps : PresetSearchSteps)
+				{
+					FConfig& Config = Configs.AddDefaulted_GetRef();
+					Config.bTemporal = Mode == 1;
+					Config.EdgeMode = ESMAAEdgeDetectors(EdgeModeIndex);
+					Config.Preset = ESMAAPreset(PresetIndex);
+					Config.MaxSearchSteps = FMath::Clamp(Steps, 0, 112);
+					Config.MaxDiagonalSearchSteps = MaxDiagonalSearchSteps;
+					Config.CornerRounding = CornerRounding;
+				}
+			}
+		}
+	}
+
+	// Reference features don't change between configurations
+	TArray<FFLIPInputs> ReferenceFLIP;
+	for (const FFrame& Frame : Frames)
+	{
+		ReferenceFLIP.Add(PrepareFLIP(Frame.Reference, PixelsPerDegree));
+	}
+
+	TArray<FResult> Results;
+	TArray<FSummary> Summaries;
+
+	for (const FConfig& Config : Configs)
+	{
+		FSMAACPUSettings Settings = BaseSettings;
+		Settings.Quality = Config.Preset;
+		Settings.EdgeMode = Config.EdgeMode;
+		Settings.MaxSearchSteps = uint8(Config.MaxSearchSteps);
+		Settings.MaxDiagonalSearchSteps = uint8(Config.MaxDiagonalSearchSteps);
+		Settings.CornerRounding = uint8(Config.CornerRounding);
+
+		FSummary& Summary = Summaries.AddDefaulted_GetRef();
+		Summary.Config = Config;
+
+		// The previous frame of the sequence, for the T2x history and flicker
+		FSMAACPUImage History;
+		FChannel PreviousLuma;
+		const FChannel* PreviousReferenceLuma = nullptr;
+
+		for (int32 FrameIndex = 0; FrameIndex < Frames.Num(); ++FrameIndex)
+		{
+			const FFrame& Frame = Frames[FrameIndex];
+
+			// Each view of a bundle is a sequence of its own
+			if (FrameIndex > 0 && Frame.View != Frames[FrameIndex - 1].View)
+			{
+				History = FSMAACPUImage();
+				PreviousReferenceLuma = nullptr;
+			}
+
+			if (Config.bProcess && !SMAACPUSupportsEdgeMode(Frame.Inputs, Config.EdgeMode))
+			{
+				UE_LOG(LogSMAAQuality, Display, TEXT("%s: no input for %s edge detection, skipping"), *Frame.Name, Config.GetEdgeDetectorName());
+				History = FSMAACPUImage();
+				PreviousReferenceLuma = nullptr;
+				continue;
+			}
+
+			FResult& Result = Results.AddDefaulted_GetRef();
+			Result.Frame = Frame.Name;
+			Result.Config = Config;
+
+			FSMAACPUImage Output;
+			if (!Config.bProcess)
+			{
+				Output = Frame.Inputs.Colour;
+			}
+			else if (!Config.bTemporal)
+			{
+				Result.Metrics.Timings = RunSMAACPU(Settings, Tables, Frame.Inputs, nullptr, Output);
+			}
+			else if (bSequence)
+			{
+				Settings.SubsampleIndices = Frame.SubsampleIndices;
+				Result.Metrics.Timings = RunSMAACPU(Settings, Tables, Frame.Inputs, Frame.bCanResolve && History.IsValid() ? &History : nullptr, Output);
+				History = Output;
+			}
+			else
+			{
+				// A still has no previous frame, so resolve against itself with the other subpixel indices
+				FSMAACPUImage Past;
+				Settings.SubsampleIndices = FVector4f(1, 1, 1, 0);
+				RunSMAACPU(Settings, Tables, Frame.Inputs, nullptr, Past);
+				Settings.SubsampleIndices = FVector4f(2, 2, 2, 0);
+				Result.Metrics.Timings = RunSMAACPU(Settings, Tables, Frame.Inputs, &Past, Output);
+			}
+
+			const FDisplayImage Display = ToDisplay(Output);
+			FChannel Luma = ToLuma(Display);
+
+			Result.Metrics.PSNR = ComputePSNR(Frame.Reference, Display);
+			Result.Metrics.SSIM = ComputeSSIM(Frame.ReferenceLuma, Luma);
+			Result.Metrics.FLIP = ComputeFLIP(ReferenceFLIP[FrameIndex], PrepareFLIP(Display, PixelsPerDegree));
+
+			if (bSequence && PreviousReferenceLuma && PreviousLuma.Width == Luma.Width && PreviousLuma.Height == Luma.Height)
+			{
+				Result.Metrics.Flicker = ComputeFlicker(PreviousLuma, Luma, *PreviousReferenceLuma, Frame.ReferenceLuma);
+			}
+			PreviousLuma = MoveTemp(Luma);
+			PreviousReferenceLuma = &Frame.ReferenceLuma;
+
+			Accumulate(Summary, Result.Metrics);
+		}
+
+		Finish(Summary);
+
+		UE_LOG(LogSMAAQuality, Display, TEXT("%s %s %s steps %d/%d, rounding %d: PSNR %.2f dB, SSIM %.4f, FLIP %.4f, flicker %.5f, %.2f ms"),
+			Config.GetModeName(), Config.GetPresetName(), Config.GetEdgeDetectorName(), Config.MaxSearchSteps, Config.MaxDiagonalSearchSteps, Config.CornerRounding,
+			Summary.Metrics.PSNR, Summary.Metrics.SSIM, Summary.Metrics.FLIP, Summary.Metrics.Flicker, Summary.Metrics.Timings.GetTotal() * 1000.0);
+	}
+
+	const FString CSVPath = FPaths::Combine(OutputDir, TEXT("SMAAQuality.csv"));
+	const FString SummaryCSVPath = FPaths::Combine(OutputDir, TEXT("SMAAQualitySummary.csv"));
+	const FString JSONPath = FPaths::Combine(OutputDir, TEXT("SMAAQuality.json"));
+
+	if (!FFileHelper::SaveStringToFile(ToCSV(Results), *CSVPath)
+		|| !FFileHelper::SaveStringToFile(ToCSV(Summaries), *SummaryCSVPath)
+		|| !FFileHelper::SaveStringToFile(ToJSON(Results, Summaries, bSequence, Supersample, PixelsPerDegree), *JSONPath))
+	{
+		UE_LOG(LogSMAAQuality, Error, TEXT("Could not write the results to %s"), *OutputDir);
+		return 1;
+	}
+
+	UE_LOG(LogSMAAQuality, Display, TEXT("Wrote %d results over %d configurations to %s"), Results.Num(), Configs.Num(), *OutputDir);
+	return 0;
+}
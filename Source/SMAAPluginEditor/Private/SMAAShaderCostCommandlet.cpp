@@ -0,0 +1,333 @@
+#include "SMAAShaderCostCommandlet.h"
+
+#include "SMAAShaderPermutations.h"
+#include "Async/ParallelFor.h"
+#include "DataDrivenShaderPlatformInfo.h"
+#include "GlobalShader.h"
+#include "Interfaces/ITargetPlatform.h"
+#include "Interfaces/ITargetPlatformManagerModule.h"
+#include "Misc/EngineVersionComparison.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ShaderCompiler.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSMAAShaderCost, Log, All);
+
+// Backends report registers and the like as generic statistics from 5.4
+#define SMAA_SHADER_STATISTICS !UE_VERSION_OLDER_THAN(5, 4, 0)
+
+namespace SMAAShaderCost
+{
+	struct FResult
+	{
+		FString Shader;
+		FString Permutation;
+		bool bSucceeded = false;
+		uint32 Instructions = 0;
+
+		// Empty when the backend doesn't report them
+		FString VGPRs;
+		FString SGPRs;
+		FString TextureFetches;
+
+		uint32 TextureSamplers = 0;
+		int32 CodeBytes = 0;
+
+		// Name=Value pairs of the statistics without a column, in name order
+		FString OtherStats;
+
+		bool operator<(const FResult& Other) const
+		{
+			return Shader != Other.Shader ? Shader < Other.Shader : Permutation < Other.Permutation;
+		}
+	};
+
+	struct FPermutation
+	{
+		const FGlobalShaderType* ShaderType = nullptr;
+		int32 PermutationId = 0;
+		FShaderCompileJob* Job = nullptr;
+	};
+
+	const TCHAR* Header = TEXT("Shader,Permutation,Status,Instructions,VGPRs,SGPRs,TextureFetches,TextureSamplers,CodeBytes,OtherStats\n");
+
+	// Backends name their statistics differently, so columns are matched on parts of the name, ignoring case
+	FString* FindStatColumn(const FString& StatName, FResult& Result)
+	{
+		if (StatName.Contains(TEXT("VGPR")))
+		{
+			return &Result.VGPRs;
+		}
+		if (StatName.Contains(TEXT("SGPR")))
+		{
+			return &Result.SGPRs;
+		}
+		if (StatName.Contains(TEXT("Tex")) && (StatName.Contains(TEXT("Fetch")) || StatName.Contains(TEXT("Sampl")) || StatName.Contains(TEXT("Load")) || StatName.Contains(TEXT("Instr"))))
+		{
+			return &Result.TextureFetches;
+		}
+		return nullptr;
+	}
+
+	void ReadOutput(const FShaderCompilerOutput& Output, FResult& Result)
+	{
+		Result.bSucceeded = Output.bSucceeded;
+		Result.Instructions = Output.NumInstructions;
+		Result.TextureSamplers = Output.NumTextureSamplers;
+		Result.CodeBytes = Output.ShaderCode.GetShaderCodeSize();
+
+#if SMAA_SHADER_STATISTICS
+		TArray<FString> OtherStats;
+		for (const FGenericShaderStat& Stat : Output.ShaderStatistics)
+		{
+			const FString Name = Stat.StatName.ToString();
+			const FString Value = Visit([](const auto& StatValue) { return LexToString(StatValue); }, Stat.Value);
+
+			if (FString* Column = FindStatColumn(Name, Result); Column && Column->IsEmpty())
+			{
+				*Column = Value;
+			}
+			else
+			{
+				OtherStats.Add(FString::Printf(TEXT("%s=%s"), *Name, *Value));
+			}
+		}
+		OtherStats.Sort();
+		Result.OtherStats = FString::Join(OtherStats, TEXT(";"));
+#endif
+	}
+
+	FString EscapeCSV(const FString& Value)
+	{
+		return Value.Contains(TEXT(",")) || Value.Contains(TEXT("\"")) ? FString::Printf(TEXT("\"%s\""), *Value.Replace(TEXT("\""), TEXT("\"\""))) : Value;
+	}
+
+	FString ToCSV(const TArray<FResult>& Results)
+	{
+		FString CSV = Header;
+		for (const FResult& Result : Results)
+		{
+			CSV += FString::Printf(TEXT("%s,%s,%s,%u,%s,%s,%s,%u,%d,%s\n"),
+				*Result.Shader, *Result.Permutation, Result.bSucceeded ? TEXT("Ok") : TEXT("Failed"),
+				Result.Instructions, *Result.VGPRs, *Result.SGPRs, *Result.TextureFetches,
+				Result.TextureSamplers, Result.CodeBytes, *EscapeCSV(Result.OtherStats));
+		}
+		return CSV;
+	}
+
+	// Instructions, VGPRs and SGPRs of each Shader,Permutation in a report, -1 where a column is empty
+	TMap<FString, FIntVector> LoadBaseline(const FString& Filename)
+	{
+		TMap<FString, FIntVector> Baseline;
+
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+		{
+			return Baseline;
+		}
+
+		for (int32 LineIndex = 1; LineIndex < Lines.Num(); ++LineIndex)
+		{
+			// Only OtherStats, the last column, can hold a comma
+			TArray<FString> Columns;
+			Lines[LineIndex].ParseIntoArray(Columns, TEXT(","), false);
+			if (Columns.Num() < 6)
+			{
+				continue;
+			}
+
+			auto ToInt = [](const FString& Column) { return Column.IsEmpty() ? -1 : FCString::Atoi(*Column); };
+			Baseline.Add(Columns[0] + TEXT(",") + Columns[1], FIntVector(ToInt(Columns[3]), ToInt(Columns[4]), ToInt(Columns[5])));
+		}
+		return Baseline;
+	}
+
+	// Logs the permutations whose cost went up against the baseline and returns how many
+	int32 CompareToBaseline(const FString& Format, const TArray<FResult>& Results, const TMap<FString, FIntVector>& Baseline)
+	{
+		const TCHAR* ColumnNames[] = { TEXT("instructions"), TEXT("VGPRs"), TEXT("SGPRs") };
+
+		int32 NumIncreased = 0;
+		for (const FResult& Result : Results)
+		{
+			const FIntVector* Previous = Baseline.Find(Result.Shader + TEXT(",") + Result.Permutation);
+			if (!Previous || !Result.bSucceeded)
+			{
+				continue;
+			}
+
+			const FIntVector Current(int32(Result.Instructions), Result.VGPRs.IsEmpty() ? -1 : FCString::Atoi(*Result.VGPRs), Result.SGPRs.IsEmpty() ? -1 : FCString::Atoi(*Result.SGPRs));
+
+			bool bIncreased = false;
+			for (int32 Column = 0; Column < 3; ++Column)
+			{
+				if ((*Previous)[Column] >= 0 && Current[Column] > (*Previous)[Column])
+				{
+					UE_LOG(LogSMAAShaderCost, Warning, TEXT("%s %s %s: %s went from %d to %d"), *Format, *Result.Shader, *Result.Permutation,
+						ColumnNames[Column], (*Previous)[Column], Current[Column]);
+					bIncreased = true;
+				}
+			}
+			NumIncreased += bIncreased ? 1 : 0;
+		}
+		return NumIncreased;
+	}
+}
+
+USMAAShaderCostCommandlet::USMAAShaderCostCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 USMAAShaderCostCommandlet::Main(const FString& Params)
+{
+	using namespace SMAAShaderCost;
+
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	const FString OutputDir = ParamValues.Contains(TEXT("Output")) ? ParamValues[TEXT("Output")] : FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SMAA"), TEXT("ShaderCost"));
+	const FString BaselineDir = ParamValues.FindRef(TEXT("Baseline"));
+	const bool bFailOnIncrease = Switches.Contains(TEXT("FailOnIncrease"));
+
+	TArray<FString> Formats;
+	if (ParamValues.Contains(TEXT("Formats")))
+	{
+		ParamValues[TEXT("Formats")].ParseIntoArray(Formats, TEXT(","));
+	}
+	else if (const ITargetPlatform* TargetPlatform = GetTargetPlatformManagerRef().GetRunningTargetPlatform())
+	{
+		TArray<FName> TargetedFormats;
+		TargetPlatform->GetAllTargetedShaderFormats(TargetedFormats);
+		for (FName Format : TargetedFormats)
+		{
+			Formats.AddUnique(Format.ToString());
+		}
+	}
+
+	if (Formats.IsEmpty())
+	{
+		UE_LOG(LogSMAAShaderCost, Error, TEXT("No shader formats, pass -Formats=<Format,...>"));
+		return 1;
+	}
+
+	TArray<FString> ShaderNames;
+	if (ParamValues.Contains(TEXT("Shaders")))
+	{
+		ParamValues[TEXT("Shaders")].ParseIntoArray(ShaderNames, TEXT(","));
+	}
+
+	int32 NumFailures = 0;
+
+	for (const FString& Format : Formats)
+	{
+		const EShaderPlatform Platform = ShaderFormatToLegacyShaderPlatform(FName(*Format));
+		if (Platform == SP_NumPlatforms)
+		{
+			UE_LOG(LogSMAAShaderCost, Error, TEXT("Unknown shader format %s"), *Format);
+			NumFailures++;
+			continue;
+		}
+
+		// Jobs are set up on this thread, as that goes through the shader compiling manager, then compiled in parallel
+		TArray<FShaderCommonCompileJobPtr> Jobs;
+		TArray<FPermutation> Permutations;
+
+		for (const FGlobalShaderType* ShaderType : GetSMAAPassShaderTypes())
+		{
+			if (!ShaderNames.IsEmpty() && !ShaderNames.Contains(ShaderType->GetName()))
+			{
+				continue;
+			}
+
+			for (int32 PermutationId = 0; PermutationId < ShaderType->GetPermutationCount(); ++PermutationId)
+			{
+				if (!ShaderType->ShouldCompilePermutation(Platform, PermutationId, EShaderPermutationFlags::None))
+				{
+					continue;
+				}
+
+				const int32 FirstJob = Jobs.Num();
+				FGlobalShaderTypeCompiler::BeginCompileShader(ShaderType, PermutationId, Platform, EShaderPermutationFlags::None, Jobs);
+
+				FPermutation& Permutation = Permutations.AddDefaulted_GetRef();
+				Permutation.ShaderType = ShaderType;
+				Permutation.PermutationId = PermutationId;
+				Permutation.Job = Jobs.IsValidIndex(FirstJob) ? Jobs[FirstJob]->GetSingleShaderJob() : nullptr;
+			}
+		}
+
+		UE_LOG(LogSMAAShaderCost, Display, TEXT("%s: compiling %d permutations"), *Format, Permutations.Num());
+
+		ParallelFor(Permutations.Num(), [&Permutations](int32 Index)
+		{
+			if (FShaderCompileJob* Job = Permutations[Index].Job)
+			{
+				FShaderCompileUtilities::ExecuteShaderCompileJob(*Job);
+			}
+		});
+
+		TArray<FResult> Results;
+		for (const FPermutation& Permutation : Permutations)
+		{
+			FResult& Result = Results.AddDefaulted_GetRef();
+			Result.Shader = Permutation.ShaderType->GetName();
+			Result.Permutation = DescribeSMAAShaderPermutation(Permutation.ShaderType, Permutation.PermutationId);
+
+			if (!Permutation.Job)
+			{
+				UE_LOG(LogSMAAShaderCost, Error, TEXT("%s %s %s: the shader compiling manager made no job"), *Format, *Result.Shader, *Result.Permutation);
+				NumFailures++;
+				continue;
+			}
+
+			ReadOutput(Permutation.Job->Output, Result);
+
+			if (!Result.bSucceeded)
+			{
+				for (const FShaderCompilerError& Error : Permutation.Job->Output.Errors)
+				{
+					UE_LOG(LogSMAAShaderCost, Error, TEXT("%s %s %s: %s"), *Format, *Result.Shader, *Result.Permutation, *Error.StrippedErrorMessage);
+				}
+				NumFailures++;
+			}
+		}
+		Results.Sort();
+
+		const FString CSVPath = FPaths::Combine(OutputDir, FString::Printf(TEXT("SMAAShaderCost_%s.csv"), *Format));
+		if (!FFileHelper::SaveStringToFile(ToCSV(Results), *CSVPath))
+		{
+			UE_LOG(LogSMAAShaderCost, Error, TEXT("Could not write %s"), *CSVPath);
+			NumFailures++;
+			continue;
+		}
+
+		UE_LOG(LogSMAAShaderCost, Display, TEXT("Wrote %d permutations to %s"), Results.Num(), *CSVPath);
+
+		if (!BaselineDir.IsEmpty())
+		{
+			const FString BaselinePath = FPaths::Combine(BaselineDir, FPaths::GetCleanFilename(CSVPath));
+			const TMap<FString, FIntVector> Baseline = LoadBaseline(BaselinePath);
+			if (Baseline.IsEmpty())
+			{
+				UE_LOG(LogSMAAShaderCost, Warning, TEXT("No baseline at %s"), *BaselinePath);
+				continue;
+			}
+
+			const int32 NumIncreased = CompareToBaseline(Format, Results, Baseline);
+			UE_LOG(LogSMAAShaderCost, Display, TEXT("%s: %d permutations cost more than in %s"), *Format, NumIncreased, *BaselinePath);
+
+			if (bFailOnIncrease)
+			{
+				NumFailures += NumIncreased;
+			}
+		}
+	}
+
+	return NumFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,544 @@
+#include "SMAACPU.h"
+#include "SMAACommandletUtils.h"
+#include "SMAADeveloperSettings.h"
+#include "SMAAGPU.h"
+#include "Engine/Texture2D.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/Paths.h"
+#include "TextureCompiler.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Checks the CPU port and the compute passes against the goldens in Resources/Conformance, which SMAAReference.py
+ * writes from its own transcription of the shaders. Every stage runs on the golden output of the one before it, so
+ * a failure shows up in the stage that caused it only.
+ */
+namespace SMAAConformance
+{
+	enum class EScene : uint8
+	{
+		// Flat shaded shapes with depth, normals and per-shape motion
+		Shapes,
+
+		// One pixel lines at several slopes, for the searches and diagonal detection
+		Lines,
+
+		// Low contrast noise with a few hard steps, for local contrast adaptation
+		Noise,
+
+		// Steps between the Low and Ultra thresholds that only some edge detectors see
+		Contrast,
+	};
+
+	const TCHAR* SceneNames[] = { TEXT("Shapes"), TEXT("Lines"), TEXT("Noise"), TEXT("Contrast") };
+
+	struct FCase
+	{
+		EScene Scene;
+		ESMAAEdgeDetectors EdgeMode;
+		ESMAAPreset Preset;
+		bool bTemporal;
+	};
+
+	// Must match EDGE_CASES in SMAAReference.py
+	const FCase Cases[] = {
+		{ EScene::Shapes, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Low, false },
+		{ EScene::Shapes, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Ultra, false },
+		{ EScene::Shapes, ESMAAEdgeDetectors::Colour, ESMAAPreset::Low, false },
+		{ EScene::Shapes, ESMAAEdgeDetectors::Colour, ESMAAPreset::Ultra, false },
+		{ EScene::Shapes, ESMAAEdgeDetectors::Depth, ESMAAPreset::Low, false },
+		{ EScene::Shapes, ESMAAEdgeDetectors::Depth, ESMAAPreset::Ultra, false },
+		{ EScene::Shapes, ESMAAEdgeDetectors::Normal, ESMAAPreset::Low, false },
+		{ EScene::Shapes, ESMAAEdgeDetectors::Normal, ESMAAPreset::Ultra, false },
+		{ EScene::Shapes, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Ultra, true },
+		{ EScene::Lines, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Low, false },
+		{ EScene::Lines, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Medium, false },
+		{ EScene::Lines, ESMAAEdgeDetectors::Luminance, ESMAAPreset::High, false },
+		{ EScene::Lines, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Ultra, false },
+		{ EScene::Lines, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Ultra, true },
+		{ EScene::Noise, ESMAAEdgeDetectors::Colour, ESMAAPreset::High, false },
+		{ EScene::Contrast, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Low, false },
+		{ EScene::Contrast, ESMAAEdgeDetectors::Luminance, ESMAAPreset::Ultra, false },
+		{ EScene::Contrast, ESMAAEdgeDetectors::Colour, ESMAAPreset::Low, false },
+		{ EScene::Contrast, ESMAAEdgeDetectors::Colour, ESMAAPreset::Ultra, false },
+		{ EScene::Contrast, ESMAAEdgeDetectors::Depth, ESMAAPreset::Low, false },
+		{ EScene::Contrast, ESMAAEdgeDetectors::Depth, ESMAAPreset::Ultra, false },
+		{ EScene::Contrast, ESMAAEdgeDetectors::Normal, ESMAAPreset::Ultra, false },
+	};
+
+	const EScene Scenes[] = { EScene::Shapes, EScene::Lines, EScene::Noise, EScene::Contrast };
+
+	// Scenes with motion, which also have T2x blending and resolve goldens
+	const EScene TemporalScenes[] = { EScene::Shapes, EScene::Lines };
+
+	// The inputs are quantised so that no edge threshold is borderline, and the CPU port samples the area texture's
+	// source data, as the expected weights are made with
+	constexpr float EdgeTolerance = 1e-5f;
+	constexpr float CPUTolerance = 1e-5f;
+
+	// The GPU samples the compressed area texture, and filters with 8 bit subtexel precision
+	constexpr float GPUWeightTolerance = 1.f / 64.f;
+	constexpr float GPUColourTolerance = 1e-3f;
+
+	FString GetCaseName(const FCase& Case)
+	{
+		return FString::Printf(TEXT("%s_%s_%s%s"), SceneNames[uint8(Case.Scene)], SMAAEdgeDetectorNames[uint8(Case.EdgeMode)],
+			SMAAPresetNames[uint8(Case.Preset)], Case.bTemporal ? TEXT("_T2x") : TEXT(""));
+	}
+
+	FString GetGoldenPath(const FString& Name)
+	{
+		return FPaths::Combine(IPluginManager::Get().FindPlugin(TEXT("SMAAPlugin"))->GetBaseDir(), TEXT("Resources"), TEXT("Conformance"), Name + TEXT(".exr"));
+	}
+
+	bool LoadGolden(FAutomationTestBase& Test, const FString& Name, FSMAACPUImage& OutImage)
+	{
+		const FString Path = GetGoldenPath(Name);
+		if (!LoadSMAACPUImage(Path, OutImage))
+		{
+			Test.AddError(FString::Printf(TEXT("Could not load %s, run SMAAReference.py to write the goldens"), *Path));
+			return false;
+		}
+		return true;
+	}
+
+	// FrameIndex 0 is the previous frame, 1 the current one. Inputs no case of the scene reads aren't written, and
+	// are left empty
+	bool LoadFrame(FAutomationTestBase& Test, EScene Scene, int32 FrameIndex, FSMAACPUFrame& OutFrame, FSMAACPUImage& OutWeights)
+	{
+		const FString Prefix = FString::Printf(TEXT("%s_Frame%d_"), SceneNames[uint8(Scene)], FrameIndex);
+
+		if (!LoadGolden(Test, Prefix + TEXT("Colour"), OutFrame.Colour) || !LoadGolden(Test, Prefix + TEXT("Weights"), OutWeights))
+		{
+			return false;
+		}
+
+		const TPair<const TCHAR*, FSMAACPUImage*> Optional[] = {
+			{ TEXT("Depth"), &OutFrame.Depth },
+			{ TEXT("Normal"), &OutFrame.Normal },
+			{ TEXT("Velocity"), &OutFrame.Velocity },
+		};
+
+		for (const TPair<const TCHAR*, FSMAACPUImage*>& Input : Optional)
+		{
+			if (FPaths::FileExists(GetGoldenPath(Prefix + Input.Key)) && !LoadGolden(Test, Prefix + Input.Key, *Input.Value))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool LoadTables(FAutomationTestBase& Test, FSMAALookupTables& OutTables)
+	{
+		USMAADeveloperSettings::Get()->LoadTextures();
+
+		if (!OutTables.InitFromTexture(USMAADeveloperSettings::Get()->SMAAAreaTexture))
+		{
+			Test.AddError(TEXT("Could not read the SMAA area texture"));
+			return false;
+		}
+		return true;
+	}
+
+	FSMAACPUSettings MakeSettings(const FCase& Case)
+	{
+		FSMAACPUSettings Settings;
+		Settings.Quality = Case.Preset;
+		Settings.EdgeMode = Case.EdgeMode;
+		GetSMAAPresetSearchSettings(Case.Preset, Settings.MaxSearchSteps, Settings.MaxDiagonalSearchSteps, Settings.CornerRounding);
+		Settings.SubsampleIndices = Case.bTemporal ? FVector4f(1, 1, 1, 0) : FVector4f(0, 0, 0, 0);
+		return Settings;
+	}
+
+	/**
+	 * Turns the golden area lookups into blend weights by sampling the shipped area texture where the reference did,
+	 * in the shader's order: diagonals first, the horizontal edge only when no diagonal was found, and the vertical
+	 * edge unless a diagonal was.
+	 */
+	bool MakeExpectedWeights(FAutomationTestBase& Test, const FCase& Case, const FSMAALookupTables& Tables, FSMAACPUImage& OutWeights)
+	{
+		const FString CaseName = GetCaseName(Case);
+		const bool bDiagonals = Case.Preset == ESMAAPreset::High || Case.Preset == ESMAAPreset::Ultra;
+
+		FSMAACPUImage AreaH;
+		FSMAACPUImage AreaV;
+		FSMAACPUImage AreaDiag;
+		if (!LoadGolden(Test, CaseName + TEXT("_AreaH"), AreaH) || !LoadGolden(Test, CaseName + TEXT("_AreaV"), AreaV)
+			|| (bDiagonals && !LoadGolden(Test, CaseName + TEXT("_AreaDiag"), AreaDiag)))
+		{
+			return false;
+		}
+
+		OutWeights.Init(AreaH.Width, AreaH.Height);
+
+		for (int32 Y = 0; Y < AreaH.Height; ++Y)
+		{
+			for (int32 X = 0; X < AreaH.Width; ++X)
+			{
+				FVector4f Weights(0.f, 0.f, 0.f, 0.f);
+				bool bVertical = true;
+
+				const FVector4f& Horizontal = AreaH.At(X, Y);
+				if (Horizontal.X >= 0.f)
+				{
+					FVector2f Diagonal(0.f, 0.f);
+					if (bDiagonals)
+					{
+						const FVector4f& Lookups = AreaDiag.At(X, Y);
+						if (Lookups.X >= 0.f)
+						{
+							Diagonal += Tables.SampleArea(Lookups.X, Lookups.Y);
+						}
+						if (Lookups.Z >= 0.f)
+						{
+							// The second diagonal's area is swizzled
+							const FVector2f Area = Tables.SampleArea(Lookups.Z, Lookups.W);
+							Diagonal += FVector2f(Area.Y, Area.X);
+						}
+					}
+
+					if (Diagonal.X == -Diagonal.Y)
+					{
+						const FVector2f Area = Tables.SampleArea(Horizontal.X, Horizontal.Y);
+						Weights.X = Area.X * Horizontal.Z;
+						Weights.Y = Area.Y * Horizontal.W;
+					}
+					else
+					{
+						Weights.X = Diagonal.X;
+						Weights.Y = Diagonal.Y;
+						bVertical = false;
+					}
+				}
+
+				const FVector4f& Vertical = AreaV.At(X, Y);
+				if (bVertical && Vertical.X >= 0.f)
+				{
+					const FVector2f Area = Tables.SampleArea(Vertical.X, Vertical.Y);
+					Weights.Z = Area.X * Vertical.Z;
+					Weights.W = Area.Y * Vertical.W;
+				}
+
+				OutWeights.At(X, Y) = Weights;
+			}
+		}
+
+		return true;
+	}
+
+	// Fails with the largest error over all channels, and the first pixel over the tolerance
+	bool CompareImages(FAutomationTestBase& Test, const FString& What, const FSMAACPUImage& Actual, const FSMAACPUImage& Expected, float Tolerance)
+	{
+		if (Actual.Width != Expected.Width || Actual.Height != Expected.Height)
+		{
+			Test.AddError(FString::Printf(TEXT("%s: expected %dx%d, got %dx%d"), *What, Expected.Width, Expected.Height, Actual.Width, Actual.Height));
+			return false;
+		}
+
+		float MaxError = 0.f;
+		int32 FirstFailure = INDEX_NONE;
+		for (int32 Index = 0; Index < Actual.Pixels.Num(); ++Index)
+		{
+			const FVector4f Difference = (Actual.Pixels[Index] - Expected.Pixels[Index]).GetAbs();
+			const float Error = FMath::Max(FMath::Max(Difference.X, Difference.Y), FMath::Max(Difference.Z, Difference.W));
+			MaxError = FMath::Max(MaxError, Error);
+
+			if (Error > Tolerance && FirstFailure == INDEX_NONE)
+			{
+				FirstFailure = Index;
+			}
+		}
+
+		if (FirstFailure != INDEX_NONE)
+		{
+			Test.AddError(FString::Printf(TEXT("%s: max error %g exceeds %g, first at (%d, %d): %s, expected %s"), *What, MaxError, Tolerance,
+				FirstFailure % Actual.Width, FirstFailure / Actual.Width, *Actual.Pixels[FirstFailure].ToString(), *Expected.Pixels[FirstFailure].ToString()));
+			return false;
+		}
+		return true;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSMAAConformanceCPUTest, "SMAA.Conformance.CPU", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FSMAAConformanceCPUTest::RunTest(const FString& Parameters)
+{
+	using namespace SMAAConformance;
+
+	FSMAALookupTables Tables;
+	if (!LoadTables(*this, Tables))
+	{
+		return false;
+	}
+
+	for (const FCase& Case : Cases)
+	{
+		const FString CaseName = GetCaseName(Case);
+
+		FSMAACPUFrame Frame;
+		FSMAACPUImage SceneWeights;
+		FSMAACPUImage GoldenEdges;
+		FSMAACPUImage ExpectedWeights;
+		if (!LoadFrame(*this, Case.Scene, 1, Frame, SceneWeights) || !LoadGolden(*this, CaseName + TEXT("_Edges"), GoldenEdges)
+			|| !MakeExpectedWeights(*this, Case, Tables, ExpectedWeights))
+		{
+			continue;
+		}
+
+		FSMAACPUSettings Settings = MakeSettings(Case);
+
+		FSMAACPUImage Edges;
+		SMAACPUEdgeDetection(Settings, Frame, Edges);
+		CompareImages(*this, CaseName + TEXT(" edges"), Edges, GoldenEdges, EdgeTolerance);
+
+		FSMAACPUImage Weights;
+		SMAACPUBlendingWeights(Settings, Tables, GoldenEdges, Weights);
+		CompareImages(*this, CaseName + TEXT(" weights"), Weights, ExpectedWeights, CPUTolerance);
+
+		// Row blocks must not change the result
+		Settings.NumThreads = 1;
+
+		FSMAACPUImage SingleThreadedEdges;
+		FSMAACPUImage SingleThreadedWeights;
+		SMAACPUEdgeDetection(Settings, Frame, SingleThreadedEdges);
+		SMAACPUBlendingWeights(Settings, Tables, GoldenEdges, SingleThreadedWeights);
+		TestTrue(CaseName + TEXT(" edges don't depend on the thread count"), Edges.Pixels == SingleThreadedEdges.Pixels);
+		TestTrue(CaseName + TEXT(" weights don't depend on the thread count"), Weights.Pixels == SingleThreadedWeights.Pixels);
+	}
+
+	const FSMAACPUSettings Settings = FSMAACPUSettings();
+
+	for (const EScene Scene : Scenes)
+	{
+		FSMAACPUFrame Frame;
+		FSMAACPUImage SceneWeights;
+		FSMAACPUImage Golden;
+		if (!LoadFrame(*this, Scene, 1, Frame, SceneWeights) || !LoadGolden(*this, FString(SceneNames[uint8(Scene)]) + TEXT("_Blended"), Golden))
+		{
+			continue;
+		}
+
+		// Without reprojection, as with SMAA 1x
+		Frame.Velocity = FSMAACPUImage();
+
+		FSMAACPUImage Blended;
+		SMAACPUNeighbourhoodBlending(Settings, Frame, SceneWeights, Blended);
+		CompareImages(*this, FString(SceneNames[uint8(Scene)]) + TEXT(" blended"), Blended, Golden, CPUTolerance);
+	}
+
+	for (const EScene Scene : TemporalScenes)
+	{
+		const FString SceneName = SceneNames[uint8(Scene)];
+
+		FSMAACPUFrame Previous;
+		FSMAACPUFrame Current;
+		FSMAACPUImage PreviousWeights;
+		FSMAACPUImage CurrentWeights;
+		FSMAACPUImage GoldenHistory;
+		FSMAACPUImage GoldenBlended;
+		FSMAACPUImage GoldenResolved;
+		if (!LoadFrame(*this, Scene, 0, Previous, PreviousWeights) || !LoadFrame(*this, Scene, 1, Current, CurrentWeights)
+			|| !LoadGolden(*this, SceneName + TEXT("_T2x_History"), GoldenHistory) || !LoadGolden(*this, SceneName + TEXT("_T2x_Blended"), GoldenBlended)
+			|| !LoadGolden(*this, SceneName + TEXT("_T2x_Resolved"), GoldenResolved))
+		{
+			continue;
+		}
+
+		FSMAACPUImage History;
+		SMAACPUNeighbourhoodBlending(Settings, Previous, PreviousWeights, History);
+		CompareImages(*this, SceneName + TEXT(" T2x history"), History, GoldenHistory, CPUTolerance);
+
+		FSMAACPUImage Blended;
+		SMAACPUNeighbourhoodBlending(Settings, Current, CurrentWeights, Blended);
+		CompareImages(*this, SceneName + TEXT(" T2x blended"), Blended, GoldenBlended, CPUTolerance);
+
+		FSMAACPUImage Resolved;
+		SMAACPUTemporalResolve(Settings, Current, GoldenBlended, GoldenHistory, Resolved);
+		CompareImages(*this, SceneName + TEXT(" T2x resolved"), Resolved, GoldenResolved, CPUTolerance);
+	}
+
+	return true;
+}
+
+// Reprojection and the resolve aren't covered here: the shaders read velocity encoded the way the renderer writes it,
+// and the view it was written with
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSMAAConformanceGPUTest, "SMAA.Conformance.GPU", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FSMAAConformanceGPUTest::RunTest(const FString& Parameters)
+{
+	using namespace SMAAConformance;
+
+	FSMAALookupTables Tables;
+	if (!LoadTables(*this, Tables))
+	{
+		return false;
+	}
+
+	UTexture2D* AreaTexture = USMAADeveloperSettings::Get()->SMAAAreaTexture;
+	UTexture2D* SearchTexture = USMAADeveloperSettings::Get()->SMAASearchTexture;
+
+	// The passes sample the platform data, which may still be compiling
+	FTextureCompilingManager::Get().FinishCompilation({ AreaTexture, SearchTexture });
+
+	for (const FCase& Case : Cases)
+	{
+		const FString CaseName = GetCaseName(Case);
+
+		FSMAACPUFrame Frame;
+		FSMAACPUImage SceneWeights;
+		FSMAACPUImage GoldenEdges;
+		FSMAACPUImage ExpectedWeights;
+		if (!LoadFrame(*this, Case.Scene, 1, Frame, SceneWeights) || !LoadGolden(*this, CaseName + TEXT("_Edges"), GoldenEdges)
+			|| !MakeExpectedWeights(*this, Case, Tables, ExpectedWeights))
+		{
+			continue;
+		}
+
+		const FSMAACPUSettings Settings = MakeSettings(Case);
+
+		FSMAACPUImage Edges;
+		if (!SMAAGPUEdgeDetection(Settings, Frame, Edges))
+		{
+			AddWarning(TEXT("No GPU to run the SMAA passes on, skipped"));
+			return true;
+		}
+		CompareImages(*this, CaseName + TEXT(" edges"), Edges, GoldenEdges, EdgeTolerance);
+
+		for (const bool bSearchALU : { true, false })
+		{
+			for (uint8 SharedRuns = 0; SharedRuns <= 2; ++SharedRuns)
+			{
+				const FString What = FString::Printf(TEXT("%s weights, SearchALU %d, SharedRuns %d"), *CaseName, int32(bSearchALU), SharedRuns);
+
+				FSMAAGPUBlendingWeightsOptions Options;
+				Options.bSearchALU = bSearchALU;
+				Options.SharedRuns = SharedRuns;
+
+				FSMAACPUImage Weights;
+				uint32 SharedRunMismatches = 0;
+				if (!SMAAGPUBlendingWeights(Settings, Options, AreaTexture, SearchTexture, GoldenEdges, Weights, &SharedRunMismatches))
+				{
+					AddError(FString::Printf(TEXT("%s: could not run, the lookup textures have no resource"), *What));
+					continue;
+				}
+
+				CompareImages(*this, What, Weights, ExpectedWeights, GPUWeightTolerance);
+				if (SharedRuns == 2)
+				{
+					TestEqual(What + TEXT(" shared run mismatches"), SharedRunMismatches, 0u);
+				}
+			}
+		}
+	}
+
+	for (const EScene Scene : Scenes)
+	{
+		FSMAACPUFrame Frame;
+		FSMAACPUImage SceneWeights;
+		FSMAACPUImage Golden;
+		if (!LoadFrame(*this, Scene, 1, Frame, SceneWeights) || !LoadGolden(*this, FString(SceneNames[uint8(Scene)]) + TEXT("_Blended"), Golden))
+		{
+			continue;
+		}
+
+		FSMAACPUImage Blended;
+		if (SMAAGPUNeighbourhoodBlending(FSMAACPUSettings(), Frame, SceneWeights, Blended))
+		{
+			CompareImages(*this, FString(SceneNames[uint8(Scene)]) + TEXT(" blended"), Blended, Golden, GPUColourTolerance);
+		}
+	}
+
+	return true;
+}
+
+// RunSMAACPUBanded must match RunSMAACPU bit for bit, with bands shorter than, as tall as and taller than the apron
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSMAABandedTest, "SMAA.Conformance.Banded", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FSMAABandedTest::RunTest(const FString& Parameters)
+{
+	using namespace SMAAConformance;
+
+	FSMAALookupTables Tables;
+	if (!LoadTables(*this, Tables))
+	{
+		return false;
+	}
+
+	for (const FCase& Case : Cases)
+	{
+		// Banded processing is SMAA 1x only
+		if (Case.bTemporal)
+		{
+			continue;
+		}
+
+		FSMAACPUFrame Frame;
+		FSMAACPUImage SceneWeights;
+		if (!LoadFrame(*this, Case.Scene, 1, Frame, SceneWeights))
+		{
+			continue;
+		}
+		Frame.Velocity = FSMAACPUImage();
+
+		const FSMAACPUSettings Settings = MakeSettings(Case);
+
+		FSMAACPUImage Expected;
+		RunSMAACPU(Settings, Tables, Frame, nullptr, Expected);
+
+		const int32 Apron = GetSMAACPUBandApron(Settings);
+		for (const int32 BandHeight : { 1, Apron - 1, Apron, Apron + 1 })
+		{
+			if (BandHeight < 1)
+			{
+				continue;
+			}
+
+			FSMAACPUImage Output;
+			Output.Init(Frame.Colour.Width, Frame.Colour.Height);
+
+			FSMAACPUBandedIO IO;
+			IO.Width = Frame.Colour.Width;
+			IO.Height = Frame.Colour.Height;
+			IO.ReadRows = [&Frame](int32 FirstRow, int32 NumRows, FSMAACPUFrame& OutFrame)
+			{
+				const TPair<const FSMAACPUImage*, FSMAACPUImage*> Inputs[] = {
+					{ &Frame.Colour, &OutFrame.Colour },
+					{ &Frame.Depth, &OutFrame.Depth },
+					{ &Frame.Normal, &OutFrame.Normal },
+				};
+
+				for (const TPair<const FSMAACPUImage*, FSMAACPUImage*>& Input : Inputs)
+				{
+					if (Input.Key->IsValid())
+					{
+						Input.Value->Init(Input.Key->Width, NumRows);
+						FMemory::Memcpy(Input.Value->Pixels.GetData(), &Input.Key->At(0, FirstRow), Input.Value->Pixels.Num() * sizeof(FVector4f));
+					}
+				}
+			};
+			IO.WriteRows = [&Output](int32 FirstRow, const FSMAACPUImage& Rows)
+			{
+				FMemory::Memcpy(&Output.At(0, FirstRow), Rows.Pixels.GetData(), Rows.Pixels.Num() * sizeof(FVector4f));
+			};
+
+			RunSMAACPUBanded(Settings, Tables, IO, BandHeight);
+			CompareImages(*this, FString::Printf(TEXT("%s banded, %d rows with a %d row apron"), *GetCaseName(Case), BandHeight, Apron), Output, Expected, 0.f);
+		}
+	}
+
+	// An empty image reads and writes nothing
+	bool bCalled = false;
+	FSMAACPUBandedIO EmptyIO;
+	EmptyIO.ReadRows = [&bCalled](int32, int32, FSMAACPUFrame&) { bCalled = true; };
+	EmptyIO.WriteRows = [&bCalled](int32, const FSMAACPUImage&) { bCalled = true; };
+	RunSMAACPUBanded(FSMAACPUSettings(), Tables, EmptyIO, 16);
+	TestFalse(TEXT("Banded processing of an empty image calls back"), bCalled);
+
+	return true;
+}
+
+#endif
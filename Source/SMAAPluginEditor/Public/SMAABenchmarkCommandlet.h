@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SMAABenchmarkCommandlet.generated.h"
+
+/**
+ * Runs the CPU SMAA port over a corpus of EXR and PNG frames, sweeping presets, edge detectors, search steps and
+ * thread counts, and writes per-stage timings, throughput and peak memory as CSV and JSON. Needs no GPU.
+ *
+ * UnrealEditor-Cmd <Project> -run=SMAABenchmark -nullrhi -Input=<Dir or file> [-Output=<Dir>]
+ *     [-Presets=Low,Medium,High,Ultra] [-EdgeDetectors=Luminance,Colour,Depth,Normal] [-SearchSteps=4,8,16,32]
+ *     [-Threads=1,8] [-Iterations=3] [-Temporal | -BandHeight=256] [-CaptureSettings]
+ *
+ * Depth, normal and velocity for a frame are read from <Frame>_depth, <Frame>_normal and <Frame>_velocity next to it.
+ * Edge detectors whose input is missing are skipped for that frame. -BandHeight runs the banded streaming path,
+ * to measure its overhead and peak memory against whole frames. -CaptureSettings replays a bundle written by
+ * r.SMAA.CaptureInputs with the preset, edge detector, search and T2x settings it was captured with. With -Temporal,
+ * frames of a bundle run with the subpixel indices they were captured with and skip the resolve where the GPU had no
+ * history or a camera cut.
+ *
+ * Low to Ultra run with the search parameters they bake in, so their timings belong to the presets the GPU ships.
+ * -SearchSteps only sweeps Custom. Every result reports the search steps, diagonal steps and corner rounding it ran
+ * with.
+ */
+UCLASS()
+class USMAABenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USMAABenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SMAAQualityCommandlet.generated.h"
+
+/**
+ * Runs the CPU SMAA port over a corpus of EXR and PNG frames for every mode, preset and edge detector, and compares
+ * each output against a supersampled reference. Writes PSNR, SSIM, FLIP and, for sequences, temporal flicker as CSV
+ * and JSON next to the timing of each run, so quality can be weighed against cost. Unprocessed input is reported as
+ * mode None, as the baseline. Needs no GPU.
+ *
+ * UnrealEditor-Cmd <Project> -run=SMAAQuality -nullrhi -Input=<Dir or file> [-Output=<Dir>] [-Modes=1x,T2x]
+ *     [-Presets=Low,Medium,High,Ultra] [-EdgeDetectors=Luminance] [-SearchSteps=8,16,32] [-Supersample=4]
+ *     [-Sequence] [-PixelsPerDegree=67] [-CaptureSettings]
+ *
+ * Low to Ultra run with the search steps, diagonal steps and corner rounding they bake in, one row each, so every
+ * row matches a preset the GPU ships. -SearchSteps only sweeps Custom, which keeps 16 diagonal steps and 25% corner
+ * rounding, or those of the capture with -CaptureSettings. The applied values are reported with every result.
+ *
+ * The reference for a frame is read from <Frame>_reference next to it, at the frame's size or an integer multiple of
+ * it, which is box filtered down. With -Supersample=N and no reference file, each frame is instead taken to be an
+ * N times supersampled render: the reference is its box filtered average and the input its sample nearest each
+ * pixel's centre, which is how the frame would have been rasterised at the lower resolution.
+ *
+ * -Sequence treats the frames as consecutive frames of one shot, in name order. T2x then resolves against the
+ * previous frame's output and flicker is measured between frames, against the reference's own change. Frames of an
+ * r.SMAA.CaptureInputs bundle are grouped by view, one sequence each, and take their subpixel indices and history
+ * resets from the jitter index, history and camera cut state they were captured with. Without -Sequence, T2x resolves
+ * each frame against a run of itself with the other subpixel indices.
+ *
+ * Metrics are taken on display values, clamped to [0, 1] and sRGB encoded, so HDR frames should be tonemapped
+ * first. FLIP follows LDR-FLIP (Andersson et al. 2020), with -PixelsPerDegree setting the viewing conditions.
+ *
+ * -CaptureSettings measures a bundle written by r.SMAA.CaptureInputs with the settings it was captured with only.
+ */
+UCLASS()
+class USMAAQualityCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USMAAQualityCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SMAAShaderCostCommandlet.generated.h"
+
+/**
+ * Compiles every permutation of the edge detection, blend weight, neighbourhood blending and temporal resolve compute
+ * shaders for each shader format, and writes the instruction count, VGPRs, SGPRs, texture fetches and code size the
+ * compiler reports as one CSV per format. Rows are keyed and sorted by the permutation's defines and the files hold no
+ * dates or paths, so a report checked in next to the shaders shows each change's cost in review. Needs no GPU.
+ *
+ * UnrealEditor-Cmd <Project> -run=SMAAShaderCost -nullrhi [-Formats=SF_VULKAN_SM6,PCD3D_SM6] [-Output=<Dir>]
+ *     [-Shaders=FSMAAEdgeDetectionCS,FSMAABlendingWeightsCS] [-Baseline=<Dir>] [-FailOnIncrease]
+ *
+ * Formats default to those the running platform targets. D3D formats compile through DXC, so SM6 works on Linux and
+ * SM5 needs Windows. Permutations are the ones the engine would compile, so group shapes other than 8x8 are only
+ * included with -dpcvars=r.SMAA.CompileGroupShapes=1.
+ *
+ * Instruction counts come from every backend. VGPRs, SGPRs and texture fetches are only known to backends which
+ * report them in their statistics, and are left empty otherwise; any other statistic goes to the OtherStats column.
+ *
+ * -Baseline compares against the reports in another directory and logs every permutation whose instructions or
+ * registers went up. With -FailOnIncrease, any such permutation fails the run.
+ */
+UCLASS()
+class USMAAShaderCostCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USMAAShaderCostCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,33 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+using UnrealBuildTool;
+
+public class SMAAPluginEditor : ModuleRules
+{
+	public SMAAPluginEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"Core",
+				"CoreUObject",
+				"Engine"
+			}
+		);
+
+		PrivateDependencyModuleNames.AddRange(
+			new string[]
+			{
+				"ImageCore",
+				"Json",
+				"Projects",
+				"RenderCore",
+				"RHI",
+				"SMAAPlugin",
+				"TargetPlatform"
+			}
+		);
+	}
+}